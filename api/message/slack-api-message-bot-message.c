@@ -2,11 +2,14 @@
 // License, version 2.0. If a copy of the MPL was not distributed with this
 // file, You can obtain one at http://mozilla.org/MPL/2.0/.
 
-#include <json.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "../../weechat-plugin.h"
 #include "../../slack.h"
+#include "../../slack-json.h"
+#include "../../slack-color.h"
+#include "../../slack-id.h"
 #include "../../slack-workspace.h"
 #include "../../slack-message.h"
 #include "../../slack-api.h"
@@ -17,7 +20,8 @@
 
 static const char *subtype = "bot_message";
 
-static inline int json_valid(json_object *object, struct t_slack_workspace *workspace)
+static inline int json_valid(struct t_slack_json_value *object,
+                             struct t_slack_workspace *workspace)
 {
     if (!object)
     {
@@ -25,8 +29,8 @@ static inline int json_valid(json_object *object, struct t_slack_workspace *work
             workspace->buffer,
             _("%s%s: error handling websocket %smessage.%s%s message: "
               "unexpected response from server"),
-            weechat_prefix("error"), SLACK_PLUGIN_NAME,
-            weechat_color("chat_value"), subtype, weechat_color("reset"));
+            SLACK_PREFIX_ERROR, SLACK_PLUGIN_NAME,
+            SLACK_COLOR(SLACK_COLOR_CHAT_VALUE), subtype, SLACK_COLOR(SLACK_COLOR_RESET));
         return 0;
     }
 
@@ -49,7 +53,11 @@ int slack_api_message_bot_message_handle(struct t_slack_workspace *workspace,
     if (!ptr_user)
         return 1; /* silently ignore if bot user hasn't been loaded yet */
 
-    char *message = slack_message_decode(workspace, text);
+    if (!slack_channel_open_buffer(workspace, ptr_channel))
+        return 1;
+
+    char *decoded = slack_message_decode(workspace, text);
+    const char *message = (decoded) ? decoded : text;
     weechat_printf_date_tags(
         ptr_channel->buffer,
         (time_t)atof(ts),
@@ -57,14 +65,13 @@ int slack_api_message_bot_message_handle(struct t_slack_workspace *workspace,
         _("%s%s"),
         slack_user_as_prefix(workspace, ptr_user, username),
         message);
-    free(message);
+    free(decoded);
 
     ptr_typing = slack_channel_typing_search(ptr_channel,
-                                             ptr_user->profile.display_name);
+                                             ptr_user->id);
     if (ptr_typing)
     {
-        slack_channel_typing_free(ptr_channel, ptr_typing);
-        slack_channel_typing_cb(ptr_channel, NULL, 0);
+        slack_channel_typing_remove(workspace, ptr_channel, ptr_typing);
     }
 
     return 1;
@@ -85,7 +92,11 @@ int slack_api_message_slackbot_message_handle(struct t_slack_workspace *workspac
     if (!ptr_user)
         return 1; /* silently ignore if slackbot user hasn't been loaded yet */
 
-    char *message = slack_message_decode(workspace, text);
+    if (!slack_channel_open_buffer(workspace, ptr_channel))
+        return 1;
+
+    char *decoded = slack_message_decode(workspace, text);
+    const char *message = (decoded) ? decoded : text;
     weechat_printf_date_tags(
         ptr_channel->buffer,
         (time_t)atof(ts),
@@ -93,63 +104,62 @@ int slack_api_message_slackbot_message_handle(struct t_slack_workspace *workspac
         _("%s%s"),
         slack_user_as_prefix(workspace, ptr_user, user),
         message);
-    free(message);
+    free(decoded);
 
     ptr_typing = slack_channel_typing_search(ptr_channel,
-                                             ptr_user->profile.display_name);
+                                             ptr_user->id);
     if (ptr_typing)
     {
-        slack_channel_typing_free(ptr_channel, ptr_typing);
-        slack_channel_typing_cb(ptr_channel, NULL, 0);
+        slack_channel_typing_remove(workspace, ptr_channel, ptr_typing);
     }
 
     return 1;
 }
 
 int slack_api_message_bot_message(struct t_slack_workspace *workspace,
-                                  json_object *message)
+                                  struct t_slack_json_value *message)
 {
-    json_object *channel, *bot_id, *username, *user, *text, *ts;
-    channel = json_object_object_get(message, "channel");
+    struct t_slack_json_value *channel, *bot_id, *username, *user, *text, *ts;
+    channel = slack_json_object_get(message, "channel");
     if (!json_valid(channel, workspace))
         return 0;
 
-    username = json_object_object_get(message, "username");
+    username = slack_json_object_get(message, "username");
     if (!json_valid(username, workspace))
         return 0;
 
-    text = json_object_object_get(message, "text");
+    text = slack_json_object_get(message, "text");
     if (!json_valid(text, workspace))
         return 0;
 
-    ts = json_object_object_get(message, "ts");
+    ts = slack_json_object_get(message, "ts");
     if (!json_valid(ts, workspace))
         return 0;
 
-    if (strcmp("slackbot", json_object_get_string(username)) == 0)
+    if (strcmp("slackbot", slack_json_get_string(username)) == 0)
     {
-        user = json_object_object_get(message, "user");
+        user = slack_json_object_get(message, "user");
         if (!json_valid(user, workspace))
             return 0;
         
         return slack_api_message_slackbot_message_handle(workspace,
-                                                         json_object_get_string(channel),
-                                                         json_object_get_string(user),
-                                                         json_object_get_string(text),
-                                                         json_object_get_string(ts));
+                                                         slack_json_get_string(channel),
+                                                         slack_json_get_string(user),
+                                                         slack_json_get_string(text),
+                                                         slack_json_get_string(ts));
     }
     else
     {
-        bot_id = json_object_object_get(message, "bot_id");
+        bot_id = slack_json_object_get(message, "bot_id");
         if (!json_valid(bot_id, workspace))
             return 0;
 
         return slack_api_message_bot_message_handle(workspace,
-                                                    json_object_get_string(channel),
-                                                    json_object_get_string(bot_id),
-                                                    json_object_get_string(username),
-                                                    json_object_get_string(text),
-                                                    json_object_get_string(ts));
+                                                    slack_json_get_string(channel),
+                                                    slack_json_get_string(bot_id),
+                                                    slack_json_get_string(username),
+                                                    slack_json_get_string(text),
+                                                    slack_json_get_string(ts));
     }
 }
 
@@ -7,6 +7,6 @@
 
 int slack_api_message_message_changed(
         struct t_slack_workspace *workspace,
-        json_object *message);
+        struct t_slack_json_value *message);
 
 #endif /*SLACK_API_MESSAGE_MESSAGE_CHANGED_H*/
@@ -2,11 +2,14 @@
 // License, version 2.0. If a copy of the MPL was not distributed with this
 // file, You can obtain one at http://mozilla.org/MPL/2.0/.
 
-#include <json.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "../../weechat-plugin.h"
 #include "../../slack.h"
+#include "../../slack-json.h"
+#include "../../slack-color.h"
+#include "../../slack-id.h"
 #include "../../slack-workspace.h"
 #include "../../slack-message.h"
 #include "../../slack-api.h"
@@ -17,7 +20,8 @@
 
 static const char *subtype = "thread_broadcast";
 
-static inline int json_valid(json_object *object, struct t_slack_workspace *workspace)
+static inline int json_valid(struct t_slack_json_value *object,
+                             struct t_slack_workspace *workspace)
 {
     if (!object)
     {
@@ -25,8 +29,8 @@ static inline int json_valid(json_object *object, struct t_slack_workspace *work
             workspace->buffer,
             _("%s%s: error handling websocket %smessage.%s%s message: "
               "unexpected response from server"),
-            weechat_prefix("error"), SLACK_PLUGIN_NAME,
-            weechat_color("chat_value"), subtype, weechat_color("reset"));
+            SLACK_PREFIX_ERROR, SLACK_PLUGIN_NAME,
+            SLACK_COLOR(SLACK_COLOR_CHAT_VALUE), subtype, SLACK_COLOR(SLACK_COLOR_RESET));
         return 0;
     }
 
@@ -34,7 +38,7 @@ static inline int json_valid(json_object *object, struct t_slack_workspace *work
 }
 
 int slack_api_message_thread_broadcast_handle(struct t_slack_workspace *workspace,
-                                              json_object *root, const char *user,
+                                              struct t_slack_json_value *root, const char *user,
                                               const char *text, const char *ts)
 {
     struct t_slack_channel *ptr_channel;
@@ -49,7 +53,11 @@ int slack_api_message_thread_broadcast_handle(struct t_slack_workspace *workspac
     if (!ptr_user)
         return 1; // silently ignore if user hasn't been loaded yet
 
-    char *message = slack_message_decode(workspace, text);
+    if (!slack_channel_open_buffer(workspace, ptr_channel))
+        return 1;
+
+    char *decoded = slack_message_decode(workspace, text);
+    const char *message = (decoded) ? decoded : text;
     weechat_printf_date_tags(
         ptr_channel->buffer,
         (time_t)atof(ts),
@@ -57,14 +65,13 @@ int slack_api_message_thread_broadcast_handle(struct t_slack_workspace *workspac
         _("%s%s"),
         slack_user_as_prefix(workspace, ptr_user, NULL),
         message);
-    free(message);
+    free(decoded);
 
     ptr_typing = slack_channel_typing_search(ptr_channel,
-                                             ptr_user->profile.display_name);
+                                             ptr_user->id);
     if (ptr_typing)
     {
-        slack_channel_typing_free(ptr_channel, ptr_typing);
-        slack_channel_typing_cb(ptr_channel, NULL, 0);
+        slack_channel_typing_remove(workspace, ptr_channel, ptr_typing);
     }
     */
 
@@ -72,28 +79,28 @@ int slack_api_message_thread_broadcast_handle(struct t_slack_workspace *workspac
 }
 
 int slack_api_message_thread_broadcast(struct t_slack_workspace *workspace,
-                                       json_object *message)
+                                       struct t_slack_json_value *message)
 {
-    json_object *root, *user, *text, *ts;
-    root = json_object_object_get(message, "root");
+    struct t_slack_json_value *root, *user, *text, *ts;
+    root = slack_json_object_get(message, "root");
     if (!json_valid(root, workspace))
         return 0;
 
-    user = json_object_object_get(message, "user");
+    user = slack_json_object_get(message, "user");
     if (!json_valid(user, workspace))
         return 0;
 
-    text = json_object_object_get(message, "text");
+    text = slack_json_object_get(message, "text");
     if (!json_valid(text, workspace))
         return 0;
 
-    ts = json_object_object_get(message, "ts");
+    ts = slack_json_object_get(message, "ts");
     if (!json_valid(ts, workspace))
         return 0;
 
     return slack_api_message_thread_broadcast_handle(workspace,
-            root, json_object_get_string(user),
-                  json_object_get_string(text),
-                  json_object_get_string(ts));
+            root, slack_json_get_string(user),
+                  slack_json_get_string(text),
+                  slack_json_get_string(ts));
 }
 
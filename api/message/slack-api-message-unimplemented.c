@@ -2,11 +2,13 @@
 // License, version 2.0. If a copy of the MPL was not distributed with this
 // file, You can obtain one at http://mozilla.org/MPL/2.0/.
 
-#include <json.h>
 #include <string.h>
 
 #include "../../weechat-plugin.h"
 #include "../../slack.h"
+#include "../../slack-json.h"
+#include "../../slack-color.h"
+#include "../../slack-id.h"
 #include "../../slack-workspace.h"
 #include "../../slack-api.h"
 #include "../../slack-channel.h"
@@ -16,7 +18,8 @@
 
 static const char *subtype = "unimplemented";
 
-static inline int json_valid(json_object *object, struct t_slack_workspace *workspace)
+static inline int json_valid(struct t_slack_json_value *object,
+                             struct t_slack_workspace *workspace)
 {
     if (!object)
     {
@@ -24,8 +27,8 @@ static inline int json_valid(json_object *object, struct t_slack_workspace *work
             workspace->buffer,
             _("%s%s: error handling websocket %smessage.%s%s message: "
               "unexpected response from server"),
-            weechat_prefix("error"), SLACK_PLUGIN_NAME,
-            weechat_color("chat_value"), subtype, weechat_color("reset"));
+            SLACK_PREFIX_ERROR, SLACK_PLUGIN_NAME,
+            SLACK_COLOR(SLACK_COLOR_CHAT_VALUE), subtype, SLACK_COLOR(SLACK_COLOR_RESET));
         return 0;
     }
 
@@ -33,17 +36,14 @@ static inline int json_valid(json_object *object, struct t_slack_workspace *work
 }
 
 int slack_api_message_unimplemented(struct t_slack_workspace *workspace,
-                                    json_object *message)
+                                    struct t_slack_json_value *message)
 {
-    json_object *subtype = json_object_object_get(message, "subtype");
+    struct t_slack_json_value *subtype = slack_json_object_get(message, "subtype");
     if (!json_valid(subtype, workspace))
         return 0;
 
-    weechat_printf(
-        workspace->buffer,
-        _("%s%s: got unhandled message of type: message.%s"),
-        weechat_prefix("error"), SLACK_PLUGIN_NAME,
-        json_object_get_string(subtype));
+    slack_api_count_unhandled(workspace, "message.",
+                              slack_json_get_string(subtype));
 
     return 1;
 }
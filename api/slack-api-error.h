@@ -6,6 +6,6 @@
 #define _SLACK_API_ERROR_H_
 
 int slack_api_error(struct t_slack_workspace *workspace,
-                    json_object *message);
+                    struct t_slack_json_value *message);
 
 #endif /*SLACK_API_ERROR_H*/
@@ -2,10 +2,11 @@
 // License, version 2.0. If a copy of the MPL was not distributed with this
 // file, You can obtain one at http://mozilla.org/MPL/2.0/.
 
-#include <json.h>
 
 #include "../weechat-plugin.h"
 #include "../slack.h"
+#include "../slack-json.h"
+#include "../slack-color.h"
 #include "../slack-workspace.h"
 #include "../slack-api.h"
 #include "slack-api-hello.h"
@@ -20,7 +21,7 @@ int slack_api_hello_handle(struct t_slack_workspace *workspace)
     weechat_printf(
         workspace->buffer,
         _("%s%s: connected!"),
-        weechat_prefix("network"), SLACK_PLUGIN_NAME);
+        SLACK_PREFIX_NETWORK, SLACK_PLUGIN_NAME);
 
     request = slack_request_users_list(workspace,
             weechat_config_string(
@@ -46,7 +47,7 @@ int slack_api_hello_handle(struct t_slack_workspace *workspace)
 }
 
 int slack_api_hello(struct t_slack_workspace *workspace,
-                    json_object *message)
+                    struct t_slack_json_value *message)
 {
     (void) message;
 
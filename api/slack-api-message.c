@@ -2,11 +2,14 @@
 // License, version 2.0. If a copy of the MPL was not distributed with this
 // file, You can obtain one at http://mozilla.org/MPL/2.0/.
 
-#include <json.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "../weechat-plugin.h"
 #include "../slack.h"
+#include "../slack-json.h"
+#include "../slack-color.h"
+#include "../slack-id.h"
 #include "../slack-workspace.h"
 #include "../slack-api.h"
 #include "../slack-channel.h"
@@ -20,55 +23,59 @@
 
 static const char *type = "message";
 
-struct stringcase
+/* see SLACK_API_CASE */
+static t_slack_api_handler *slack_api_message_handler_search(const char *subtype)
 {
-    const char *string;
-    int (*func)(struct t_slack_workspace *workspace,
-                json_object *message);
-};
-
-static struct stringcase cases[] =
-{ { "bot_message", &slack_api_message_bot_message }
-, { "channel_archive", &slack_api_message_unimplemented }
-, { "channel_join", &slack_api_message_unimplemented }
-, { "channel_leave", &slack_api_message_unimplemented }
-, { "channel_name", &slack_api_message_unimplemented }
-, { "channel_purpose", &slack_api_message_unimplemented }
-, { "channel_topic", &slack_api_message_unimplemented }
-, { "channel_unarchive", &slack_api_message_unimplemented }
-, { "file_comment", &slack_api_message_unimplemented }
-, { "file_mention", &slack_api_message_unimplemented }
-, { "file_share", &slack_api_message_unimplemented }
-, { "group_archive", &slack_api_message_unimplemented }
-, { "group_join", &slack_api_message_unimplemented }
-, { "group_leave", &slack_api_message_unimplemented }
-, { "group_name", &slack_api_message_unimplemented }
-, { "group_purpose", &slack_api_message_unimplemented }
-, { "group_topic", &slack_api_message_unimplemented }
-, { "group_unarchive", &slack_api_message_unimplemented }
-, { "me_message", &slack_api_message_me_message }
-, { "message_changed", &slack_api_message_unimplemented }
-, { "message_deleted", &slack_api_message_unimplemented }
-, { "message_replied", &slack_api_message_unimplemented }
-, { "pinned_item", &slack_api_message_unimplemented }
-, { "reply_broadcast", &slack_api_message_unimplemented }
-, { "slackbot_response", &slack_api_message_slackbot_response }
-, { "thread_broadcast", &slack_api_message_unimplemented }
-, { "unpinned_item", &slack_api_message_unimplemented }
-};
-
-static int stringcase_cmp(const void *p1, const void *p2)
-{
-    return strcasecmp(((struct stringcase*)p1)->string, ((struct stringcase*)p2)->string);
-}
+    switch (strlen(subtype))
+    {
+        case 10:
+            SLACK_API_CASE(subtype, "file_share", &slack_api_message_unimplemented);
+            SLACK_API_CASE(subtype, "group_join", &slack_api_message_unimplemented);
+            SLACK_API_CASE(subtype, "group_name", &slack_api_message_unimplemented);
+            SLACK_API_CASE(subtype, "me_message", &slack_api_message_me_message);
+            break;
+        case 11:
+            SLACK_API_CASE(subtype, "bot_message", &slack_api_message_bot_message);
+            SLACK_API_CASE(subtype, "group_leave", &slack_api_message_unimplemented);
+            SLACK_API_CASE(subtype, "group_topic", &slack_api_message_unimplemented);
+            SLACK_API_CASE(subtype, "pinned_item", &slack_api_message_unimplemented);
+            break;
+        case 12:
+            SLACK_API_CASE(subtype, "channel_join", &slack_api_message_unimplemented);
+            SLACK_API_CASE(subtype, "channel_name", &slack_api_message_unimplemented);
+            SLACK_API_CASE(subtype, "file_comment", &slack_api_message_unimplemented);
+            SLACK_API_CASE(subtype, "file_mention", &slack_api_message_unimplemented);
+            break;
+        case 13:
+            SLACK_API_CASE(subtype, "channel_leave", &slack_api_message_unimplemented);
+            SLACK_API_CASE(subtype, "channel_topic", &slack_api_message_unimplemented);
+            SLACK_API_CASE(subtype, "group_archive", &slack_api_message_unimplemented);
+            SLACK_API_CASE(subtype, "group_purpose", &slack_api_message_unimplemented);
+            SLACK_API_CASE(subtype, "unpinned_item", &slack_api_message_unimplemented);
+            break;
+        case 15:
+            SLACK_API_CASE(subtype, "channel_archive", &slack_api_message_unimplemented);
+            SLACK_API_CASE(subtype, "channel_purpose", &slack_api_message_unimplemented);
+            SLACK_API_CASE(subtype, "group_unarchive", &slack_api_message_unimplemented);
+            SLACK_API_CASE(subtype, "message_changed", &slack_api_message_unimplemented);
+            SLACK_API_CASE(subtype, "message_deleted", &slack_api_message_unimplemented);
+            SLACK_API_CASE(subtype, "message_replied", &slack_api_message_unimplemented);
+            SLACK_API_CASE(subtype, "reply_broadcast", &slack_api_message_unimplemented);
+            break;
+        case 16:
+            SLACK_API_CASE(subtype, "thread_broadcast", &slack_api_message_unimplemented);
+            break;
+        case 17:
+            SLACK_API_CASE(subtype, "channel_unarchive", &slack_api_message_unimplemented);
+            SLACK_API_CASE(subtype, "slackbot_response", &slack_api_message_slackbot_response);
+            break;
+    }
 
-void slack_api_message_init()
-{
-    size_t case_count = sizeof(cases) / sizeof(cases[0]);
-    qsort(cases, case_count, sizeof(struct stringcase), stringcase_cmp);
+    return NULL;
 }
 
-static inline int json_valid(json_object *object, struct t_slack_workspace *workspace)
+static inline int json_valid(struct t_slack_json_value *object,
+                             struct t_slack_workspace *workspace)
 {
     if (!object)
     {
@@ -76,8 +83,8 @@ static inline int json_valid(json_object *object, struct t_slack_workspace *work
             workspace->buffer,
             _("%s%s: error handling websocket %s%s%s message: "
               "unexpected response from server"),
-            weechat_prefix("error"), SLACK_PLUGIN_NAME,
-            weechat_color("chat_value"), type, weechat_color("reset"));
+            SLACK_PREFIX_ERROR, SLACK_PLUGIN_NAME,
+            SLACK_COLOR(SLACK_COLOR_CHAT_VALUE), type, SLACK_COLOR(SLACK_COLOR_RESET));
         return 0;
     }
 
@@ -99,7 +106,11 @@ int slack_api_message_message_handle(struct t_slack_workspace *workspace,
     if (!ptr_user)
         return 1; /* silently ignore if user hasn't been loaded yet */
 
-    char *message = slack_message_decode(workspace, text);
+    if (!slack_channel_open_buffer(workspace, ptr_channel))
+        return 1;
+
+    char *decoded = slack_message_decode(workspace, text);
+    const char *message = (decoded) ? decoded : text;
     weechat_printf_date_tags(
         ptr_channel->buffer,
         (time_t)atof(ts),
@@ -107,18 +118,17 @@ int slack_api_message_message_handle(struct t_slack_workspace *workspace,
         _("%s%s"),
         slack_user_as_prefix(workspace, ptr_user, NULL),
         message);
-    slack_channel_member_speaking_add(ptr_channel, ptr_user->profile.display_name,
+    slack_channel_member_speaking_add(ptr_channel, ptr_user,
                                       weechat_string_has_highlight(
                                           message,
                                           ptr_user->profile.display_name));
-    free(message);
+    free(decoded);
     
     ptr_typing = slack_channel_typing_search(ptr_channel,
-                                             ptr_user->profile.display_name);
+                                             ptr_user->id);
     if (ptr_typing)
     {
-        slack_channel_typing_free(ptr_channel, ptr_typing);
-        slack_channel_typing_cb(ptr_channel, NULL, 0);
+        slack_channel_typing_remove(workspace, ptr_channel, ptr_typing);
     }
 
     return 1;
@@ -138,7 +148,11 @@ int slack_api_message_attachment_handle(struct t_slack_workspace *workspace,
     if (!ptr_user)
         return 1; /* silently ignore if user hasn't been loaded yet */
 
-    char *message = slack_message_decode(workspace, text);
+    if (!slack_channel_open_buffer(workspace, ptr_channel))
+        return 1;
+
+    char *decoded = slack_message_decode(workspace, text);
+    const char *message = (decoded) ? decoded : text;
     weechat_printf_date_tags(
         ptr_channel->buffer,
         (time_t)atof(ts),
@@ -146,87 +160,76 @@ int slack_api_message_attachment_handle(struct t_slack_workspace *workspace,
         _("%s%s"),
         "++\t",
         message);
-    free(message);
+    free(decoded);
     
     return 1;
 }
 
 int slack_api_message_route_message(struct t_slack_workspace *workspace,
                                     const char *subtype,
-                                    json_object *message)
+                                    struct t_slack_json_value *message)
 {
-    struct stringcase key;
-    key.string = subtype;
-
-    size_t case_count = sizeof(cases) / sizeof(cases[0]);
-    void *entry_ptr = bsearch(&key, cases, case_count,
-            sizeof(struct stringcase), stringcase_cmp);
+    t_slack_api_handler *handler;
 
-    if (entry_ptr)
-    {
-        struct stringcase *entry = (struct stringcase *)entry_ptr;
-        return (*entry->func)(workspace, message);
-    }
-    else
+    handler = slack_api_message_handler_search(subtype);
+    if (!handler)
     {
-        weechat_printf(
-            workspace->buffer,
-            _("%s%s: got unhandled message of type: message.%s"),
-            weechat_prefix("error"), SLACK_PLUGIN_NAME,
-            subtype);
+        slack_api_count_unhandled(workspace, "message.", subtype);
         return 1;
     }
+
+    return (*handler)(workspace, message);
 }
 
 int slack_api_message(struct t_slack_workspace *workspace,
-                      json_object *message)
+                      struct t_slack_json_value *message)
 {
-    json_object *subtype, *channel, *user, *text, *ts;
-    json_object *attachments, *attachment, *fallback;
+    struct t_slack_json_value *subtype, *channel, *user, *text, *ts;
+    struct t_slack_json_value *attachments, *attachment, *fallback;
     int i, rc;
 
-    subtype = json_object_object_get(message, "subtype");
+    subtype = slack_json_object_get(message, "subtype");
     if (!subtype)
     { /* normal message */
-        channel = json_object_object_get(message, "channel");
+        channel = slack_json_object_get(message, "channel");
         if (!json_valid(channel, workspace))
             return 0;
 
-        user = json_object_object_get(message, "user");
+        user = slack_json_object_get(message, "user");
         if (!json_valid(user, workspace))
             return 0;
 
-        text = json_object_object_get(message, "text");
+        text = slack_json_object_get(message, "text");
         if (!json_valid(text, workspace))
             return 0;
 
-        ts = json_object_object_get(message, "ts");
+        ts = slack_json_object_get(message, "ts");
         if (!json_valid(ts, workspace))
             return 0;
 
         rc = slack_api_message_message_handle(workspace,
-                json_object_get_string(channel),
-                json_object_get_string(user),
-                json_object_get_string(text),
-                json_object_get_string(ts));
-        attachments = json_object_object_get(message, "attachments");
+                slack_json_get_string(channel),
+                slack_json_get_string(user),
+                slack_json_get_string(text),
+                slack_json_get_string(ts));
+        attachments = slack_json_object_get(message, "attachments");
         if (json_valid(attachments, workspace))
         {
-            for (i = json_object_array_length(attachments); i > 0; i--)
+            for (i = slack_json_array_length(attachments); i > 0; i--)
             {
-                attachment = json_object_array_get_idx(attachments, i - 1);
+                attachment = slack_json_array_get(attachments, i - 1);
                 if (!json_valid(attachment, workspace))
                     continue;
                 
-                fallback = json_object_object_get(attachment, "fallback");
+                fallback = slack_json_object_get(attachment, "fallback");
                 if (!json_valid(fallback, workspace))
                     continue;
 
                 slack_api_message_attachment_handle(workspace,
-                        json_object_get_string(channel),
-                        json_object_get_string(user),
-                        json_object_get_string(fallback),
-                        json_object_get_string(ts));
+                        slack_json_get_string(channel),
+                        slack_json_get_string(user),
+                        slack_json_get_string(fallback),
+                        slack_json_get_string(ts));
             }
         }
         return rc;
@@ -234,7 +237,7 @@ int slack_api_message(struct t_slack_workspace *workspace,
     else
     { /* special message */
         return slack_api_message_route_message(workspace,
-                json_object_get_string(subtype),
+                slack_json_get_string(subtype),
                 message);
     }
 }
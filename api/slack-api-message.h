@@ -6,8 +6,6 @@
 #define _SLACK_API_MESSAGE_H_
 
 int slack_api_message(struct t_slack_workspace *workspace,
-                      json_object *message);
-
-void slack_api_message_init();
+                      struct t_slack_json_value *message);
 
 #endif /*SLACK_API_MESSAGE_H*/
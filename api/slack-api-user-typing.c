@@ -2,10 +2,12 @@
 // License, version 2.0. If a copy of the MPL was not distributed with this
 // file, You can obtain one at http://mozilla.org/MPL/2.0/.
 
-#include <json.h>
 
 #include "../weechat-plugin.h"
 #include "../slack.h"
+#include "../slack-json.h"
+#include "../slack-color.h"
+#include "../slack-id.h"
 #include "../slack-workspace.h"
 #include "../slack-user.h"
 #include "../slack-channel.h"
@@ -14,7 +16,8 @@
 
 static const char *type = "user_typing";
 
-static inline int json_valid(json_object *object, struct t_slack_workspace *workspace)
+static inline int json_valid(struct t_slack_json_value *object,
+                             struct t_slack_workspace *workspace)
 {
     if (!object)
     {
@@ -22,8 +25,8 @@ static inline int json_valid(json_object *object, struct t_slack_workspace *work
             workspace->buffer,
             _("%s%s: error handling websocket %s%s%s message: "
               "unexpected response from server"),
-            weechat_prefix("error"), SLACK_PLUGIN_NAME,
-            weechat_color("chat_value"), type, weechat_color("reset"));
+            SLACK_PREFIX_ERROR, SLACK_PLUGIN_NAME,
+            SLACK_COLOR(SLACK_COLOR_CHAT_VALUE), type, SLACK_COLOR(SLACK_COLOR_RESET));
         return 0;
     }
 
@@ -43,25 +46,25 @@ int slack_api_user_typing_handle(struct t_slack_workspace *workspace,
     if (!ptr_user)
         return 1; /* silently ignore if user hasn't been loaded yet */
 
-    slack_channel_add_typing(ptr_channel, ptr_user);
+    slack_channel_add_typing(workspace, ptr_channel, ptr_user);
 
     return 1;
 }
 
 int slack_api_user_typing(struct t_slack_workspace *workspace,
-                          json_object *message)
+                          struct t_slack_json_value *message)
 {
-    json_object *channel, *user;
+    struct t_slack_json_value *channel, *user;
 
-    channel = json_object_object_get(message, "channel");
+    channel = slack_json_object_get(message, "channel");
     if (!json_valid(channel, workspace))
         return 0;
     
-    user = json_object_object_get(message, "user");
+    user = slack_json_object_get(message, "user");
     if (!json_valid(user, workspace))
         return 0;
 
     return slack_api_user_typing_handle(workspace,
-            json_object_get_string(channel),
-            json_object_get_string(user));
+            slack_json_get_string(channel),
+            slack_json_get_string(user));
 }
@@ -6,6 +6,6 @@
 #define _SLACK_API_USER_TYPING_H_
 
 int slack_api_user_typing(struct t_slack_workspace *workspace,
-                          json_object *message);
+                          struct t_slack_json_value *message);
 
 #endif /*SLACK_API_USER_TYPING_H*/
@@ -3,12 +3,14 @@
 // file, You can obtain one at http://mozilla.org/MPL/2.0/.
 
 #include <libwebsockets.h>
-#include <json.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "../weechat-plugin.h"
 #include "../slack.h"
+#include "../slack-json.h"
+#include "../slack-color.h"
+#include "../slack-id.h"
 #include "../slack-workspace.h"
 #include "../slack-channel.h"
 #include "../slack-request.h"
@@ -18,14 +20,15 @@
 static const char *const endpoint = "/api/bots.info?"
     "token=%s&bot=%s";
 
-static inline int json_valid(json_object *object, struct t_slack_workspace *workspace)
+static inline int json_valid(struct t_slack_json_value *object,
+                             struct t_slack_workspace *workspace)
 {
     if (!object)
     {
         weechat_printf(
             workspace->buffer,
             _("%s%s: error retrieving bot info: unexpected response from server"),
-            weechat_prefix("error"), SLACK_PLUGIN_NAME);
+            SLACK_PREFIX_ERROR, SLACK_PLUGIN_NAME);
         //__asm__("int3");
         return 0;
     }
@@ -50,13 +53,13 @@ static int callback_http(struct lws *wsi, enum lws_callback_reasons reason,
         weechat_printf(
             request->workspace->buffer,
             _("%s%s: (%d) error connecting to slack: %s"),
-            weechat_prefix("error"), SLACK_PLUGIN_NAME, request->idx,
+            SLACK_PREFIX_ERROR, SLACK_PLUGIN_NAME, request->idx,
             in ? (char *)in : "(null)");
 
         weechat_printf(
             request->workspace->buffer,
             _("%s%s: (%d) reconnecting..."),
-            weechat_prefix("error"), SLACK_PLUGIN_NAME, request->idx);
+            SLACK_PREFIX_ERROR, SLACK_PLUGIN_NAME, request->idx);
 
         memset(&ccinfo, 0, sizeof(ccinfo)); /* otherwise uninitialized garbage */
         ccinfo.context = request->context;
@@ -79,7 +82,7 @@ static int callback_http(struct lws *wsi, enum lws_callback_reasons reason,
         weechat_printf(
             request->workspace->buffer,
             _("%s%s: (%d) retrieving bot info... (%d)"),
-            weechat_prefix("network"), SLACK_PLUGIN_NAME, request->idx,
+            SLACK_PREFIX_NETWORK, SLACK_PLUGIN_NAME, request->idx,
             status);
         break;
 
@@ -125,8 +128,8 @@ static int callback_http(struct lws *wsi, enum lws_callback_reasons reason,
             int chunk_count, i;
             char *json_string;
             char cursor[64];
-            json_object *response, *ok, *error, *members, *metadata;
-            json_object *user, *id, *name, *profile, *display_name, *next_cursor;
+            struct t_slack_json_value *response, *ok, *error, *members, *metadata;
+            struct t_slack_json_value *user, *id, *name, *profile, *display_name, *next_cursor;
             struct t_json_chunk *chunk_ptr;
 
             chunk_count = 0;
@@ -157,28 +160,28 @@ static int callback_http(struct lws *wsi, enum lws_callback_reasons reason,
             weechat_printf(
                 request->workspace->buffer,
                 _("%s%s: (%d) got response: %s"),
-                weechat_prefix("network"), SLACK_PLUGIN_NAME, request->idx,
+                SLACK_PREFIX_NETWORK, SLACK_PLUGIN_NAME, request->idx,
                 json_string);
             
-            response = json_tokener_parse(json_string);
-            ok = json_object_object_get(response, "ok");
+            response = slack_json_parse(json_string);
+            ok = slack_json_object_get(response, "ok");
             if (!json_valid(ok, request->workspace))
             {
-                json_object_put(response);
+                slack_json_free(response);
                 free(json_string);
                 return 0;
             }
 
-            if(json_object_get_boolean(ok))
+            if(slack_json_get_boolean(ok))
             {
                 // TODO: this
             }
             else
             {
-                error = json_object_object_get(response, "error");
+                error = slack_json_object_get(response, "error");
                 if (!json_valid(error, request->workspace))
                 {
-                    json_object_put(response);
+                    slack_json_free(response);
                     free(json_string);
                     return 0;
                 }
@@ -186,11 +189,11 @@ static int callback_http(struct lws *wsi, enum lws_callback_reasons reason,
                 weechat_printf(
                     request->workspace->buffer,
                     _("%s%s: (%d) failed to retrieve users: %s"),
-                    weechat_prefix("error"), SLACK_PLUGIN_NAME, request->idx,
-                    json_object_get_string(error));
+                    SLACK_PREFIX_ERROR, SLACK_PLUGIN_NAME, request->idx,
+                    slack_json_get_string(error));
             }
 
-            json_object_put(response);
+            slack_json_free(response);
             free(json_string);
         }
         /* fallthrough */
@@ -242,7 +245,7 @@ struct t_slack_request *slack_request_bots_info(
         weechat_printf(
             workspace->buffer,
             _("%s%s: (%d) error connecting to slack: lws init failed"),
-            weechat_prefix("error"), SLACK_PLUGIN_NAME, request->idx);
+            SLACK_PREFIX_ERROR, SLACK_PLUGIN_NAME, request->idx);
         return NULL;
     }
     else
@@ -250,7 +253,7 @@ struct t_slack_request *slack_request_bots_info(
         weechat_printf(
             workspace->buffer,
             _("%s%s: (%d) contacting slack.com:443"),
-            weechat_prefix("network"), SLACK_PLUGIN_NAME, request->idx);
+            SLACK_PREFIX_NETWORK, SLACK_PLUGIN_NAME, request->idx);
     }
 
     memset(&ccinfo, 0, sizeof(ccinfo)); /* otherwise uninitialized garbage */
@@ -3,12 +3,15 @@
 // file, You can obtain one at http://mozilla.org/MPL/2.0/.
 
 #include <libwebsockets.h>
-#include <json.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "../weechat-plugin.h"
 #include "../slack.h"
+#include "../slack-color.h"
+#include "../slack-id.h"
+#include "../slack-arena.h"
+#include "../slack-json.h"
 #include "../slack-workspace.h"
 #include "../slack-request.h"
 #include "../slack-channel.h"
@@ -18,14 +21,129 @@ static const char *const endpoint = "/api/channels.list?"
     "token=%s&cursor=%s&"
     "exclude_archived=false&exclude_members=true&limit=20";
 
-static inline int json_valid(json_object *object, struct t_slack_workspace *workspace)
+enum t_channels_list_result_field
 {
-    if (!object)
+    CHANNELS_LIST_OK = 0,
+    CHANNELS_LIST_ERROR,
+    CHANNELS_LIST_NEXT_CURSOR,
+};
+
+struct t_channels_list_result
+{
+    unsigned int found;
+    int ok;
+    char error[64];
+    char next_cursor[64];
+};
+
+static const struct t_slack_json_field result_fields[] = {
+    SLACK_JSON_FIELD(struct t_channels_list_result, "ok",
+                     SLACK_JSON_BOOLEAN, ok),
+    SLACK_JSON_FIELD(struct t_channels_list_result, "error",
+                     SLACK_JSON_STRING, error),
+    SLACK_JSON_FIELD(struct t_channels_list_result, "response_metadata.next_cursor",
+                     SLACK_JSON_STRING, next_cursor),
+};
+
+enum t_channels_list_channel_field
+{
+    CHANNEL_ID = 0,
+    CHANNEL_NAME,
+    CHANNEL_CREATED,
+    CHANNEL_IS_GENERAL,
+    CHANNEL_NAME_NORMALIZED,
+    CHANNEL_IS_SHARED,
+    CHANNEL_IS_ORG_SHARED,
+    CHANNEL_IS_MEMBER,
+    CHANNEL_TOPIC_VALUE,
+    CHANNEL_TOPIC_CREATOR,
+    CHANNEL_TOPIC_LAST_SET,
+    CHANNEL_PURPOSE_VALUE,
+    CHANNEL_PURPOSE_CREATOR,
+    CHANNEL_PURPOSE_LAST_SET,
+    CHANNEL_IS_ARCHIVED,
+    CHANNEL_CREATOR,
+};
+
+/* ids get one spare byte, so that a longer one can't pass as valid */
+struct t_channels_list_channel
+{
+    unsigned int found;
+    char id[SLACK_ID_MAX_LEN + 2];
+    char name[256];
+    long created;
+    int is_general;
+    char name_normalized[256];
+    int is_shared;
+    int is_org_shared;
+    int is_member;
+    char topic_value[1024];
+    char topic_creator[SLACK_ID_MAX_LEN + 2];
+    long topic_last_set;
+    char purpose_value[1024];
+    char purpose_creator[SLACK_ID_MAX_LEN + 2];
+    long purpose_last_set;
+    int is_archived;
+    char creator[SLACK_ID_MAX_LEN + 2];
+};
+
+static const struct t_slack_json_field channel_fields[] = {
+    SLACK_JSON_FIELD(struct t_channels_list_channel, "id",
+                     SLACK_JSON_STRING, id),
+    SLACK_JSON_FIELD(struct t_channels_list_channel, "name",
+                     SLACK_JSON_STRING, name),
+    SLACK_JSON_FIELD(struct t_channels_list_channel, "created",
+                     SLACK_JSON_INTEGER, created),
+    SLACK_JSON_FIELD(struct t_channels_list_channel, "is_general",
+                     SLACK_JSON_BOOLEAN, is_general),
+    SLACK_JSON_FIELD(struct t_channels_list_channel, "name_normalized",
+                     SLACK_JSON_STRING, name_normalized),
+    SLACK_JSON_FIELD(struct t_channels_list_channel, "is_shared",
+                     SLACK_JSON_BOOLEAN, is_shared),
+    SLACK_JSON_FIELD(struct t_channels_list_channel, "is_org_shared",
+                     SLACK_JSON_BOOLEAN, is_org_shared),
+    SLACK_JSON_FIELD(struct t_channels_list_channel, "is_member",
+                     SLACK_JSON_BOOLEAN, is_member),
+    SLACK_JSON_FIELD(struct t_channels_list_channel, "topic.value",
+                     SLACK_JSON_STRING, topic_value),
+    SLACK_JSON_FIELD(struct t_channels_list_channel, "topic.creator",
+                     SLACK_JSON_STRING, topic_creator),
+    SLACK_JSON_FIELD(struct t_channels_list_channel, "topic.last_set",
+                     SLACK_JSON_INTEGER, topic_last_set),
+    SLACK_JSON_FIELD(struct t_channels_list_channel, "purpose.value",
+                     SLACK_JSON_STRING, purpose_value),
+    SLACK_JSON_FIELD(struct t_channels_list_channel, "purpose.creator",
+                     SLACK_JSON_STRING, purpose_creator),
+    SLACK_JSON_FIELD(struct t_channels_list_channel, "purpose.last_set",
+                     SLACK_JSON_INTEGER, purpose_last_set),
+    SLACK_JSON_FIELD(struct t_channels_list_channel, "is_archived",
+                     SLACK_JSON_BOOLEAN, is_archived),
+    SLACK_JSON_FIELD(struct t_channels_list_channel, "creator",
+                     SLACK_JSON_STRING, creator),
+};
+
+static void channel_cb(void *data, const void *record);
+
+static const struct t_slack_json_table table = {
+    result_fields, sizeof(result_fields) / sizeof(result_fields[0]),
+    sizeof(struct t_channels_list_result),
+    "channels",
+    channel_fields, sizeof(channel_fields) / sizeof(channel_fields[0]),
+    sizeof(struct t_channels_list_channel),
+    &channel_cb,
+};
+
+#define CHANNEL_STRING(__channel, __field, __value)                     \
+    (SLACK_JSON_FOUND(__channel, __field) ? (__channel)->__value : NULL)
+
+static inline int json_valid(int found, struct t_slack_workspace *workspace)
+{
+    if (!found)
     {
         weechat_printf(
             workspace->buffer,
             _("%s%s: error retrieving channels: unexpected response from server"),
-            weechat_prefix("error"), SLACK_PLUGIN_NAME);
+            SLACK_PREFIX_ERROR, SLACK_PLUGIN_NAME);
         //__asm__("int3");
         return 0;
     }
@@ -33,6 +151,75 @@ static inline int json_valid(json_object *object, struct t_slack_workspace *work
     return 1;
 }
 
+/*
+ * Adds a channel as soon as its object ends, while the rest of the page is
+ * still being received.
+ */
+
+static void channel_cb(void *data, const void *record)
+{
+    struct t_slack_request *request = (struct t_slack_request *)data;
+    const struct t_channels_list_channel *channel = record;
+    struct t_slack_channel *new_channel;
+
+    if (!json_valid(SLACK_JSON_FOUND(channel, CHANNEL_ID)
+                    && SLACK_JSON_FOUND(channel, CHANNEL_NAME),
+                    request->workspace))
+        return;
+
+    new_channel = slack_channel_new(request->workspace,
+                                    SLACK_CHANNEL_TYPE_CHANNEL,
+                                    channel->id, channel->name);
+    if (!new_channel)
+        return;
+
+    if (SLACK_JSON_FOUND(channel, CHANNEL_CREATED))
+        new_channel->created = channel->created;
+
+    if (SLACK_JSON_FOUND(channel, CHANNEL_IS_GENERAL))
+        new_channel->is_general = channel->is_general;
+
+    if (SLACK_JSON_FOUND(channel, CHANNEL_NAME_NORMALIZED))
+        new_channel->name_normalized = slack_arena_strdup(
+                request->workspace->channels_arena,
+                channel->name_normalized);
+
+    if (SLACK_JSON_FOUND(channel, CHANNEL_IS_SHARED))
+        new_channel->is_shared = channel->is_shared;
+
+    if (SLACK_JSON_FOUND(channel, CHANNEL_IS_ORG_SHARED))
+        new_channel->is_org_shared = channel->is_org_shared;
+
+    if (SLACK_JSON_FOUND(channel, CHANNEL_IS_MEMBER))
+    {
+        new_channel->is_member = channel->is_member;
+        if (new_channel->is_member)
+            slack_channel_queue_buffer(request->workspace, new_channel);
+    }
+
+    if (SLACK_JSON_FOUND(channel, CHANNEL_TOPIC_VALUE))
+        slack_channel_update_topic(request->workspace, new_channel,
+            channel->topic_value,
+            CHANNEL_STRING(channel, CHANNEL_TOPIC_CREATOR, topic_creator),
+            SLACK_JSON_FOUND(channel, CHANNEL_TOPIC_LAST_SET) ?
+                channel->topic_last_set : 0);
+
+    if (SLACK_JSON_FOUND(channel, CHANNEL_PURPOSE_VALUE))
+        slack_channel_update_purpose(request->workspace, new_channel,
+            channel->purpose_value,
+            CHANNEL_STRING(channel, CHANNEL_PURPOSE_CREATOR, purpose_creator),
+            SLACK_JSON_FOUND(channel, CHANNEL_PURPOSE_LAST_SET) ?
+                channel->purpose_last_set : 0);
+
+    if (SLACK_JSON_FOUND(channel, CHANNEL_IS_ARCHIVED))
+        new_channel->is_archived = channel->is_archived;
+
+    if (SLACK_JSON_FOUND(channel, CHANNEL_CREATOR))
+        new_channel->creator = slack_arena_strdup(
+                request->workspace->channels_arena,
+                channel->creator);
+}
+
 static const struct lws_protocols protocols[];
 
 static int callback_http(struct lws *wsi, enum lws_callback_reasons reason,
@@ -50,13 +237,13 @@ static int callback_http(struct lws *wsi, enum lws_callback_reasons reason,
         weechat_printf(
             request->workspace->buffer,
             _("%s%s: (%d) error connecting to slack: %s"),
-            weechat_prefix("error"), SLACK_PLUGIN_NAME, request->idx,
+            SLACK_PREFIX_ERROR, SLACK_PLUGIN_NAME, request->idx,
             in ? (char *)in : "(null)");
 
         weechat_printf(
             request->workspace->buffer,
             _("%s%s: (%d) reconnecting..."),
-            weechat_prefix("error"), SLACK_PLUGIN_NAME, request->idx);
+            SLACK_PREFIX_ERROR, SLACK_PLUGIN_NAME, request->idx);
 
         memset(&ccinfo, 0, sizeof(ccinfo)); /* otherwise uninitialized garbage */
         ccinfo.context = request->context;
@@ -79,33 +266,18 @@ static int callback_http(struct lws *wsi, enum lws_callback_reasons reason,
         weechat_printf(
             request->workspace->buffer,
             _("%s%s: (%d) retrieving channels... (%d)"),
-            weechat_prefix("network"), SLACK_PLUGIN_NAME, request->idx,
+            SLACK_PREFIX_NETWORK, SLACK_PLUGIN_NAME, request->idx,
             status);
+
+        if (request->decoder)
+            slack_json_decoder_reset(request->decoder);
+        else
+            request->decoder = slack_json_decoder_new(&table, request);
         break;
 
     /* chunks of chunked content, with header removed */
     case LWS_CALLBACK_RECEIVE_CLIENT_HTTP_READ:
-        {
-            struct t_json_chunk *new_chunk, *last_chunk;
-
-            new_chunk = malloc(sizeof(*new_chunk));
-            new_chunk->data = malloc((1024 * sizeof(char)) + 1);
-            new_chunk->data[0] = '\0';
-            new_chunk->next = NULL;
-
-            strncat(new_chunk->data, in, (int)len);
-
-            if (request->json_chunks)
-            {
-                for (last_chunk = request->json_chunks; last_chunk->next;
-                        last_chunk = last_chunk->next);
-                last_chunk->next = new_chunk;
-            }
-            else
-            {
-                request->json_chunks = new_chunk;
-            }
-        }
+        slack_json_decoder_feed(request->decoder, in, len);
         return 0; /* don't passthru */
 
     /* uninterpreted http content */
@@ -122,203 +294,20 @@ static int callback_http(struct lws *wsi, enum lws_callback_reasons reason,
 
     case LWS_CALLBACK_COMPLETED_CLIENT_HTTP:
         {
-            int chunk_count, i;
-            char *json_string;
             char cursor[64];
-            json_object *response, *ok, *error, *channels, *metadata;
-            json_object *channel, *id, *name, *created;
-            json_object *is_general, *name_normalized, *is_shared, *is_org_shared, *is_member;
-            json_object *topic, *purpose, *is_archived;
-            json_object *sub_value, *sub_creator, *sub_last_set;
-            json_object *creator, *next_cursor;
-            struct t_json_chunk *chunk_ptr;
-
-            chunk_count = 0;
-            if (request->json_chunks)
-            {
-                chunk_count++;
-                for (chunk_ptr = request->json_chunks; chunk_ptr->next;
-                        chunk_ptr = chunk_ptr->next)
-                {
-                    chunk_count++;
-                }
-            }
+            const struct t_channels_list_result *result;
 
-            json_string = malloc((1024 * sizeof(char) * chunk_count) + 1);
-            json_string[0] = '\0';
-
-            chunk_ptr = request->json_chunks;
-            for (i = 0; i < chunk_count; i++)
-            {
-                strncat(json_string, chunk_ptr->data, 1024);
-                chunk_ptr = chunk_ptr->next;
-
-                free(request->json_chunks->data);
-                free(request->json_chunks);
-                request->json_chunks = chunk_ptr;
-            }
-
-            weechat_printf(
-                request->workspace->buffer,
-                _("%s%s: (%d) got response: %s"),
-                weechat_prefix("network"), SLACK_PLUGIN_NAME, request->idx,
-                json_string);
-            
-            response = json_tokener_parse(json_string);
-            ok = json_object_object_get(response, "ok");
-            if (!json_valid(ok, request->workspace))
-            {
-                json_object_put(response);
-                free(json_string);
+            result = slack_json_decoder_finish(request->decoder);
+            if (!json_valid(result && SLACK_JSON_FOUND(result, CHANNELS_LIST_OK),
+                            request->workspace))
                 return 0;
-            }
 
-            if(json_object_get_boolean(ok))
+            if (result->ok)
             {
-                channels = json_object_object_get(response, "channels");
-                if (!json_valid(channels, request->workspace))
-                {
-                    json_object_put(response);
-                    free(json_string);
-                    return 0;
-                }
-
-                for (i = json_object_array_length(channels); i > 0; i--)
-                {
-                    struct t_slack_channel *new_channel;
-
-                    channel = json_object_array_get_idx(channels, i - 1);
-                    if (!json_valid(channel, request->workspace))
-                    {
-                        continue;
-                    }
-
-                    id = json_object_object_get(channel, "id");
-                    if (!json_valid(id, request->workspace))
-                    {
-                        continue;
-                    }
-
-                    name = json_object_object_get(channel, "name");
-                    if (!json_valid(name, request->workspace))
-                    {
-                        continue;
-                    }
-
-                    new_channel = slack_channel_new(
-                                    request->workspace,
-                                    SLACK_CHANNEL_TYPE_CHANNEL,
-                                    json_object_get_string(id),
-                                    json_object_get_string(name));
-
-                    created = json_object_object_get(channel, "created");
-                    if (json_valid(created, request->workspace))
-                    {
-                        new_channel->created = json_object_get_int(created);
-                    }
-
-                    is_general = json_object_object_get(channel, "is_general");
-                    if (json_valid(is_general, request->workspace))
-                    {
-                        new_channel->is_general = json_object_get_boolean(is_general);
-                    }
-
-                    name_normalized = json_object_object_get(channel, "name_normalized");
-                    if (json_valid(name_normalized, request->workspace))
-                    {
-                        new_channel->name_normalized = strdup(
-                                json_object_get_string(name_normalized));
-                    }
-
-                    is_shared = json_object_object_get(channel, "is_shared");
-                    if (json_valid(is_shared, request->workspace))
-                    {
-                        new_channel->is_shared = json_object_get_boolean(is_shared);
-                    }
-
-                    is_org_shared = json_object_object_get(channel, "is_org_shared");
-                    if (json_valid(is_org_shared, request->workspace))
-                    {
-                        new_channel->is_org_shared = json_object_get_boolean(is_org_shared);
-                    }
-
-                    is_member = json_object_object_get(channel, "is_member");
-                    if (json_valid(is_member, request->workspace))
-                    {
-                        new_channel->is_member = json_object_get_boolean(is_member);
-                    }
-
-                    topic = json_object_object_get(channel, "topic");
-                    if (json_valid(topic, request->workspace))
-                    {
-                        sub_value = json_object_object_get(topic, "value");
-
-                        sub_creator = json_object_object_get(topic, "creator");
-
-                        sub_last_set = json_object_object_get(topic, "last_set");
-
-                        slack_channel_update_topic(new_channel,
-                                json_valid(sub_value, request->workspace) ?
-                                    json_object_get_string(sub_value) :
-                                    NULL,
-                                json_valid(sub_creator, request->workspace) ?
-                                    json_object_get_string(sub_creator) :
-                                    NULL,
-                                json_valid(sub_last_set, request->workspace) ?
-                                    json_object_get_int(sub_last_set) :
-                                    0);
-                    }
-
-                    purpose = json_object_object_get(channel, "purpose");
-                    if (json_valid(purpose, request->workspace))
-                    {
-                        sub_value = json_object_object_get(topic, "value");
-
-                        sub_creator = json_object_object_get(topic, "creator");
-
-                        sub_last_set = json_object_object_get(topic, "last_set");
-
-                        slack_channel_update_purpose(new_channel,
-                                json_valid(sub_value, request->workspace) ?
-                                    json_object_get_string(sub_value) :
-                                    NULL,
-                                json_valid(sub_creator, request->workspace) ?
-                                    json_object_get_string(sub_creator) :
-                                    NULL,
-                                json_valid(sub_last_set, request->workspace) ?
-                                    json_object_get_int(sub_last_set) :
-                                    0);
-                    }
-
-                    is_archived = json_object_object_get(response, "is_archived");
-                    if (json_valid(is_archived, request->workspace))
-                    {
-                        new_channel->is_archived = json_object_get_boolean(is_archived);
-                    }
-
-                    creator = json_object_object_get(response, "creator");
-                    if (json_valid(creator, request->workspace))
-                    {
-                        new_channel->creator = strdup(json_object_get_string(creator));
-                    }
-                }
-
-                metadata = json_object_object_get(response, "response_metadata");
-                if (!json_valid(metadata, request->workspace))
-                {
-                    json_object_put(response);
-                    free(json_string);
+                if (!json_valid(SLACK_JSON_FOUND(result, CHANNELS_LIST_NEXT_CURSOR),
+                                request->workspace))
                     return 0;
-                }
-
-                next_cursor = json_object_object_get(metadata, "next_cursor");
-                if (!json_valid(next_cursor, request->workspace))
-                {
-                    json_object_put(response);
-                    free(json_string);
-                    return 0;
-                }
-                lws_urlencode(cursor, json_object_get_string(next_cursor), sizeof(cursor));
+                lws_urlencode(cursor, result->next_cursor, sizeof(cursor));
 
                 if (cursor[0])
                 {
@@ -334,27 +323,22 @@ static int callback_http(struct lws *wsi, enum lws_callback_reasons reason,
             }
             else
             {
-                error = json_object_object_get(response, "error");
-                if (!json_valid(error, request->workspace))
-                {
-                    json_object_put(response);
-                    free(json_string);
+                if (!json_valid(SLACK_JSON_FOUND(result, CHANNELS_LIST_ERROR),
+                                request->workspace))
                     return 0;
-                }
 
                 weechat_printf(
                     request->workspace->buffer,
                     _("%s%s: (%d) failed to retrieve channels: %s"),
-                    weechat_prefix("error"), SLACK_PLUGIN_NAME, request->idx,
-                    json_object_get_string(error));
+                    SLACK_PREFIX_ERROR, SLACK_PLUGIN_NAME, request->idx,
+                    result->error);
             }
-
-            json_object_put(response);
-            free(json_string);
         }
         /* fallthrough */
     case LWS_CALLBACK_CLOSED_CLIENT_HTTP:
         request->client_wsi = NULL;
+        slack_json_decoder_free(request->decoder);
+        request->decoder = NULL;
         /* Does not doing this cause a leak?
         lws_cancel_service(lws_get_context(wsi));*/ /* abort poll wait */
         break;
@@ -401,7 +385,7 @@ struct t_slack_request *slack_request_channels_list(
         weechat_printf(
             workspace->buffer,
             _("%s%s: (%d) error connecting to slack: lws init failed"),
-            weechat_prefix("error"), SLACK_PLUGIN_NAME, request->idx);
+            SLACK_PREFIX_ERROR, SLACK_PLUGIN_NAME, request->idx);
         return NULL;
     }
     else
@@ -409,7 +393,7 @@ struct t_slack_request *slack_request_channels_list(
         weechat_printf(
             workspace->buffer,
             _("%s%s: (%d) contacting slack.com:443"),
-            weechat_prefix("network"), SLACK_PLUGIN_NAME, request->idx);
+            SLACK_PREFIX_NETWORK, SLACK_PLUGIN_NAME, request->idx);
     }
 
     memset(&ccinfo, 0, sizeof(ccinfo)); /* otherwise uninitialized garbage */
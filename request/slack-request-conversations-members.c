@@ -3,12 +3,14 @@
 // file, You can obtain one at http://mozilla.org/MPL/2.0/.
 
 #include <libwebsockets.h>
-#include <json.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "../weechat-plugin.h"
 #include "../slack.h"
+#include "../slack-json.h"
+#include "../slack-color.h"
+#include "../slack-id.h"
 #include "../slack-workspace.h"
 #include "../slack-channel.h"
 #include "../slack-request.h"
@@ -18,14 +20,15 @@
 static const char *const endpoint = "/api/conversations.members?"
     "token=%s&channel=%s&cursor=%s&limit=100";
 
-static inline int json_valid(json_object *object, struct t_slack_workspace *workspace)
+static inline int json_valid(struct t_slack_json_value *object,
+                             struct t_slack_workspace *workspace)
 {
     if (!object)
     {
         weechat_printf(
             workspace->buffer,
             _("%s%s: error retrieving members: unexpected response from server"),
-            weechat_prefix("error"), SLACK_PLUGIN_NAME);
+            SLACK_PREFIX_ERROR, SLACK_PLUGIN_NAME);
         //__asm__("int3");
         return 0;
     }
@@ -52,13 +55,13 @@ static int callback_http(struct lws *wsi, enum lws_callback_reasons reason,
         weechat_printf(
             request->workspace->buffer,
             _("%s%s: (%d) error connecting to slack: %s"),
-            weechat_prefix("error"), SLACK_PLUGIN_NAME, request->idx,
+            SLACK_PREFIX_ERROR, SLACK_PLUGIN_NAME, request->idx,
             in ? (char *)in : "(null)");
 
         weechat_printf(
             request->workspace->buffer,
             _("%s%s: (%d) reconnecting..."),
-            weechat_prefix("error"), SLACK_PLUGIN_NAME, request->idx);
+            SLACK_PREFIX_ERROR, SLACK_PLUGIN_NAME, request->idx);
 
         memset(&ccinfo, 0, sizeof(ccinfo)); /* otherwise uninitialized garbage */
         ccinfo.context = request->context;
@@ -81,7 +84,7 @@ static int callback_http(struct lws *wsi, enum lws_callback_reasons reason,
         weechat_printf(
             request->workspace->buffer,
             _("%s%s: (%d) retrieving members... (%d)"),
-            weechat_prefix("network"), SLACK_PLUGIN_NAME, request->idx,
+            SLACK_PREFIX_NETWORK, SLACK_PLUGIN_NAME, request->idx,
             status);
         break;
 
@@ -127,11 +130,11 @@ static int callback_http(struct lws *wsi, enum lws_callback_reasons reason,
             int chunk_count, i;
             char *json_string;
             char cursor[64];
-            json_object *response, *ok, *error, *members;
-            json_object *user, *metadata, *next_cursor;
+            struct t_slack_json_value *response, *ok, *error, *members;
+            struct t_slack_json_value *user, *metadata, *next_cursor;
             struct t_json_chunk *chunk_ptr;
 
-            channelid = (const char *)request->pointer;
+            channelid = (const char *)request->data;
             channel = slack_channel_search(request->workspace, channelid);
 
             chunk_count = 0;
@@ -162,59 +165,59 @@ static int callback_http(struct lws *wsi, enum lws_callback_reasons reason,
             weechat_printf(
                 request->workspace->buffer,
                 _("%s%s: (%d) got response: %s"),
-                weechat_prefix("network"), SLACK_PLUGIN_NAME, request->idx,
+                SLACK_PREFIX_NETWORK, SLACK_PLUGIN_NAME, request->idx,
                 json_string);
             
-            response = json_tokener_parse(json_string);
-            ok = json_object_object_get(response, "ok");
+            response = slack_json_parse(json_string);
+            ok = slack_json_object_get(response, "ok");
             if (!json_valid(ok, request->workspace))
             {
-                json_object_put(response);
+                slack_json_free(response);
                 free(json_string);
                 return 0;
             }
 
-            if(json_object_get_boolean(ok))
+            if(slack_json_get_boolean(ok))
             {
-                members = json_object_object_get(response, "members");
+                members = slack_json_object_get(response, "members");
                 if (!json_valid(members, request->workspace))
                 {
-                    json_object_put(response);
+                    slack_json_free(response);
                     free(json_string);
                     return 0;
                 }
 
-                for (i = json_object_array_length(members); i > 0; i--)
+                for (i = slack_json_array_length(members); i > 0; i--)
                 {
-                    user = json_object_array_get_idx(members, i - 1);
+                    user = slack_json_array_get(members, i - 1);
                     if (!json_valid(user, request->workspace))
                     {
-                        json_object_put(response);
+                        slack_json_free(response);
                         free(json_string);
                         return 0;
                     }
 
                     slack_channel_add_member(request->workspace,
                                              channel,
-                                             json_object_get_string(user));
+                                             slack_json_get_string(user));
                 }
 
-                metadata = json_object_object_get(response, "response_metadata");
+                metadata = slack_json_object_get(response, "response_metadata");
                 if (!json_valid(metadata, request->workspace))
                 {
-                    json_object_put(response);
+                    slack_json_free(response);
                     free(json_string);
                     return 0;
                 }
 
-                next_cursor = json_object_object_get(metadata, "next_cursor");
+                next_cursor = slack_json_object_get(metadata, "next_cursor");
                 if (!json_valid(next_cursor, request->workspace))
                 {
-                    json_object_put(response);
+                    slack_json_free(response);
                     free(json_string);
                     return 0;
                 }
-                lws_urlencode(cursor, json_object_get_string(next_cursor), sizeof(cursor));
+                lws_urlencode(cursor, slack_json_get_string(next_cursor), sizeof(cursor));
 
                 if (cursor[0])
                 {
@@ -231,10 +234,10 @@ static int callback_http(struct lws *wsi, enum lws_callback_reasons reason,
             }
             else
             {
-                error = json_object_object_get(response, "error");
+                error = slack_json_object_get(response, "error");
                 if (!json_valid(error, request->workspace))
                 {
-                    json_object_put(response);
+                    slack_json_free(response);
                     free(json_string);
                     return 0;
                 }
@@ -242,11 +245,11 @@ static int callback_http(struct lws *wsi, enum lws_callback_reasons reason,
                 weechat_printf(
                     request->workspace->buffer,
                     _("%s%s: (%d) failed to retrieve users: %s"),
-                    weechat_prefix("error"), SLACK_PLUGIN_NAME, request->idx,
-                    json_object_get_string(error));
+                    SLACK_PREFIX_ERROR, SLACK_PLUGIN_NAME, request->idx,
+                    slack_json_get_string(error));
             }
 
-            json_object_put(response);
+            slack_json_free(response);
             free(json_string);
         }
         /* fallthrough */
@@ -283,7 +286,7 @@ struct t_slack_request *slack_request_conversations_members(
     struct lws_client_connect_info ccinfo;
 
     request = slack_request_alloc(workspace);
-    request->pointer = channel;
+    request->data = strdup(channel);
 
     size_t urilen = snprintf(NULL, 0, endpoint, token, channel, cursor) + 1;
     request->uri = malloc(urilen);
@@ -300,7 +303,7 @@ struct t_slack_request *slack_request_conversations_members(
         weechat_printf(
             workspace->buffer,
             _("%s%s: (%d) error connecting to slack: lws init failed"),
-            weechat_prefix("error"), SLACK_PLUGIN_NAME, request->idx);
+            SLACK_PREFIX_ERROR, SLACK_PLUGIN_NAME, request->idx);
         return NULL;
     }
     else
@@ -308,7 +311,7 @@ struct t_slack_request *slack_request_conversations_members(
         weechat_printf(
             workspace->buffer,
             _("%s%s: (%d) contacting slack.com:443"),
-            weechat_prefix("network"), SLACK_PLUGIN_NAME, request->idx);
+            SLACK_PREFIX_NETWORK, SLACK_PLUGIN_NAME, request->idx);
     }
 
     memset(&ccinfo, 0, sizeof(ccinfo)); /* otherwise uninitialized garbage */
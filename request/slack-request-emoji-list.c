@@ -3,12 +3,14 @@
 // file, You can obtain one at http://mozilla.org/MPL/2.0/.
 
 #include <libwebsockets.h>
-#include <json.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "../weechat-plugin.h"
 #include "../slack.h"
+#include "../slack-json.h"
+#include "../slack-color.h"
+#include "../slack-id.h"
 #include "../slack-workspace.h"
 #include "../slack-request.h"
 #include "../slack-channel.h"
@@ -17,14 +19,15 @@
 static const char *const endpoint = "/api/emoji.list?"
     "token=%s";
 
-static inline int json_valid(json_object *object, struct t_slack_workspace *workspace)
+static inline int json_valid(struct t_slack_json_value *object,
+                             struct t_slack_workspace *workspace)
 {
     if (!object)
     {
         weechat_printf(
             workspace->buffer,
             _("%s%s: error retrieving emoji: unexpected response from server"),
-            weechat_prefix("error"), SLACK_PLUGIN_NAME);
+            SLACK_PREFIX_ERROR, SLACK_PLUGIN_NAME);
         //__asm__("int3");
         return 0;
     }
@@ -32,6 +35,18 @@ static inline int json_valid(json_object *object, struct t_slack_workspace *work
     return 1;
 }
 
+static void emoji_cb(void *data, const char *key,
+                     struct t_slack_json_value *value)
+{
+    struct t_slack_request *request = (struct t_slack_request *)data;
+
+    if (!json_valid(value, request->workspace))
+        return;
+
+    slack_workspace_add_emoji(request->workspace,
+                              key, slack_json_get_string(value));
+}
+
 static const struct lws_protocols protocols[];
 
 static int callback_http(struct lws *wsi, enum lws_callback_reasons reason,
@@ -49,13 +64,13 @@ static int callback_http(struct lws *wsi, enum lws_callback_reasons reason,
         weechat_printf(
             request->workspace->buffer,
             _("%s%s: (%d) error connecting to slack: %s"),
-            weechat_prefix("error"), SLACK_PLUGIN_NAME, request->idx,
+            SLACK_PREFIX_ERROR, SLACK_PLUGIN_NAME, request->idx,
             in ? (char *)in : "(null)");
 
         weechat_printf(
             request->workspace->buffer,
             _("%s%s: (%d) reconnecting..."),
-            weechat_prefix("error"), SLACK_PLUGIN_NAME, request->idx);
+            SLACK_PREFIX_ERROR, SLACK_PLUGIN_NAME, request->idx);
 
         memset(&ccinfo, 0, sizeof(ccinfo)); /* otherwise uninitialized garbage */
         ccinfo.context = request->context;
@@ -78,7 +93,7 @@ static int callback_http(struct lws *wsi, enum lws_callback_reasons reason,
         weechat_printf(
             request->workspace->buffer,
             _("%s%s: (%d) retrieving emoji... (%d)"),
-            weechat_prefix("network"), SLACK_PLUGIN_NAME, request->idx,
+            SLACK_PREFIX_NETWORK, SLACK_PLUGIN_NAME, request->idx,
             status);
         break;
 
@@ -123,7 +138,7 @@ static int callback_http(struct lws *wsi, enum lws_callback_reasons reason,
         {
             int chunk_count, i;
             char *json_string;
-            json_object *response, *ok, *error, *emoji;
+            struct t_slack_json_value *response, *ok, *error, *emoji;
             struct t_json_chunk *chunk_ptr;
 
             chunk_count = 0;
@@ -154,46 +169,36 @@ static int callback_http(struct lws *wsi, enum lws_callback_reasons reason,
             weechat_printf(
                 request->workspace->buffer,
                 _("%s%s: (%d) got response: %s"),
-                weechat_prefix("network"), SLACK_PLUGIN_NAME, request->idx,
+                SLACK_PREFIX_NETWORK, SLACK_PLUGIN_NAME, request->idx,
                 json_string);
             
-            response = json_tokener_parse(json_string);
-            ok = json_object_object_get(response, "ok");
+            response = slack_json_parse(json_string);
+            ok = slack_json_object_get(response, "ok");
             if (!json_valid(ok, request->workspace))
             {
-                json_object_put(response);
+                slack_json_free(response);
                 free(json_string);
                 return 0;
             }
 
-            if(json_object_get_boolean(ok))
+            if(slack_json_get_boolean(ok))
             {
-                emoji = json_object_object_get(response, "emoji");
+                emoji = slack_json_object_get(response, "emoji");
                 if (!json_valid(emoji, request->workspace))
                 {
-                    json_object_put(response);
+                    slack_json_free(response);
                     free(json_string);
                     return 0;
                 }
 
-                json_object_object_foreach(emoji, key, val)
-                {
-                    if (!json_valid(val, request->workspace))
-                    {
-                        continue;
-                    }
-
-                    slack_workspace_add_emoji(
-                        request->workspace,
-                        key, json_object_get_string(val));
-                }
+                slack_json_object_map(emoji, &emoji_cb, request);
             }
             else
             {
-                error = json_object_object_get(response, "error");
+                error = slack_json_object_get(response, "error");
                 if (!json_valid(error, request->workspace))
                 {
-                    json_object_put(response);
+                    slack_json_free(response);
                     free(json_string);
                     return 0;
                 }
@@ -201,11 +206,11 @@ static int callback_http(struct lws *wsi, enum lws_callback_reasons reason,
                 weechat_printf(
                     request->workspace->buffer,
                     _("%s%s: (%d) failed to retrieve emoji: %s"),
-                    weechat_prefix("error"), SLACK_PLUGIN_NAME, request->idx,
-                    json_object_get_string(error));
+                    SLACK_PREFIX_ERROR, SLACK_PLUGIN_NAME, request->idx,
+                    slack_json_get_string(error));
             }
 
-            json_object_put(response);
+            slack_json_free(response);
             free(json_string);
         }
         /* fallthrough */
@@ -257,7 +262,7 @@ struct t_slack_request *slack_request_emoji_list(
         weechat_printf(
             workspace->buffer,
             _("%s%s: (%d) error connecting to slack: lws init failed"),
-            weechat_prefix("error"), SLACK_PLUGIN_NAME, request->idx);
+            SLACK_PREFIX_ERROR, SLACK_PLUGIN_NAME, request->idx);
         return NULL;
     }
     else
@@ -265,7 +270,7 @@ struct t_slack_request *slack_request_emoji_list(
         weechat_printf(
             workspace->buffer,
             _("%s%s: (%d) contacting slack.com:443"),
-            weechat_prefix("network"), SLACK_PLUGIN_NAME, request->idx);
+            SLACK_PREFIX_NETWORK, SLACK_PLUGIN_NAME, request->idx);
     }
 
     memset(&ccinfo, 0, sizeof(ccinfo)); /* otherwise uninitialized garbage */
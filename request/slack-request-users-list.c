@@ -3,12 +3,15 @@
 // file, You can obtain one at http://mozilla.org/MPL/2.0/.
 
 #include <libwebsockets.h>
-#include <json.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "../weechat-plugin.h"
 #include "../slack.h"
+#include "../slack-color.h"
+#include "../slack-id.h"
+#include "../slack-intern.h"
+#include "../slack-json.h"
 #include "../slack-workspace.h"
 #include "../slack-channel.h"
 #include "../slack-request.h"
@@ -20,14 +23,114 @@ static const char *const endpoint = "/api/users.list?"
     "token=%s&cursor=%s&"
     "exclude_archived=false&exclude_members=true&limit=20";
 
-static inline int json_valid(json_object *object, struct t_slack_workspace *workspace)
+enum t_users_list_result_field
 {
-    if (!object)
+    USERS_LIST_OK = 0,
+    USERS_LIST_ERROR,
+    USERS_LIST_NEXT_CURSOR,
+};
+
+struct t_users_list_result
+{
+    unsigned int found;
+    int ok;
+    char error[64];
+    char next_cursor[64];
+};
+
+static const struct t_slack_json_field result_fields[] = {
+    SLACK_JSON_FIELD(struct t_users_list_result, "ok",
+                     SLACK_JSON_BOOLEAN, ok),
+    SLACK_JSON_FIELD(struct t_users_list_result, "error",
+                     SLACK_JSON_STRING, error),
+    SLACK_JSON_FIELD(struct t_users_list_result, "response_metadata.next_cursor",
+                     SLACK_JSON_STRING, next_cursor),
+};
+
+enum t_users_list_member_field
+{
+    MEMBER_ID = 0,
+    MEMBER_NAME,
+    MEMBER_DISPLAY_NAME,
+    MEMBER_REAL_NAME,
+    MEMBER_BOT_ID,
+    MEMBER_TEAM_ID,
+    MEMBER_TEAM,
+    MEMBER_TZ,
+    MEMBER_TZ_LABEL,
+    MEMBER_LOCALE,
+    MEMBER_STATUS_EMOJI,
+    MEMBER_TZ_OFFSET,
+};
+
+/* ids get one spare byte, so that a longer one can't pass as valid */
+struct t_users_list_member
+{
+    unsigned int found;
+    char id[SLACK_ID_MAX_LEN + 2];
+    char name[128];
+    char display_name[256];
+    char real_name[256];
+    char bot_id[SLACK_ID_MAX_LEN + 2];
+    char team_id[SLACK_ID_MAX_LEN + 2];
+    char team[SLACK_ID_MAX_LEN + 2];
+    char tz[64];
+    char tz_label[128];
+    char locale[16];
+    char status_emoji[128];
+    long tz_offset;
+};
+
+static const struct t_slack_json_field member_fields[] = {
+    SLACK_JSON_FIELD(struct t_users_list_member, "id",
+                     SLACK_JSON_STRING, id),
+    SLACK_JSON_FIELD(struct t_users_list_member, "name",
+                     SLACK_JSON_STRING, name),
+    SLACK_JSON_FIELD(struct t_users_list_member, "profile.display_name",
+                     SLACK_JSON_STRING, display_name),
+    SLACK_JSON_FIELD(struct t_users_list_member, "profile.real_name",
+                     SLACK_JSON_STRING, real_name),
+    SLACK_JSON_FIELD(struct t_users_list_member, "profile.bot_id",
+                     SLACK_JSON_STRING, bot_id),
+    SLACK_JSON_FIELD(struct t_users_list_member, "team_id",
+                     SLACK_JSON_STRING, team_id),
+    SLACK_JSON_FIELD(struct t_users_list_member, "profile.team",
+                     SLACK_JSON_STRING, team),
+    SLACK_JSON_FIELD(struct t_users_list_member, "tz",
+                     SLACK_JSON_STRING, tz),
+    SLACK_JSON_FIELD(struct t_users_list_member, "tz_label",
+                     SLACK_JSON_STRING, tz_label),
+    SLACK_JSON_FIELD(struct t_users_list_member, "locale",
+                     SLACK_JSON_STRING, locale),
+    SLACK_JSON_FIELD(struct t_users_list_member, "profile.status_emoji",
+                     SLACK_JSON_STRING, status_emoji),
+    SLACK_JSON_FIELD(struct t_users_list_member, "tz_offset",
+                     SLACK_JSON_INTEGER, tz_offset),
+};
+
+static void member_cb(void *data, const void *record);
+
+static const struct t_slack_json_table table = {
+    result_fields, sizeof(result_fields) / sizeof(result_fields[0]),
+    sizeof(struct t_users_list_result),
+    "members",
+    member_fields, sizeof(member_fields) / sizeof(member_fields[0]),
+    sizeof(struct t_users_list_member),
+    &member_cb,
+};
+
+/* optional field: absent or null is not an error */
+#define MEMBER_STRING(__member, __field, __value)                       \
+    (SLACK_JSON_FOUND(__member, __field) ? (__member)->__value : NULL)
+
+static inline int json_valid(int found, struct t_slack_workspace *workspace)
+{
+    if (!found)
     {
         weechat_printf(
             workspace->buffer,
             _("%s%s: error retrieving users: unexpected response from server"),
-            weechat_prefix("error"), SLACK_PLUGIN_NAME);
+            SLACK_PREFIX_ERROR, SLACK_PLUGIN_NAME);
         //__asm__("int3");
         return 0;
     }
@@ -35,6 +138,56 @@ static inline int json_valid(json_object *object, struct t_slack_workspace *work
     return 1;
 }
 
+/*
+ * Adds a user as soon as its object ends, while the rest of the page is
+ * still being received.
+ */
+
+static void member_cb(void *data, const void *record)
+{
+    struct t_slack_request *request = (struct t_slack_request *)data;
+    const struct t_users_list_member *member = record;
+    struct t_slack_user *new_user;
+
+    if (!json_valid(SLACK_JSON_FOUND(member, MEMBER_ID)
+                    && SLACK_JSON_FOUND(member, MEMBER_NAME)
+                    && SLACK_JSON_FOUND(member, MEMBER_DISPLAY_NAME),
+                    request->workspace))
+        return;
+
+    new_user = slack_user_new(request->workspace, member->id,
+                              member->display_name[0] ?
+                              member->display_name : member->name);
+    if (!new_user)
+        return;
+
+    slack_user_set_real_name(request->workspace, new_user,
+        MEMBER_STRING(member, MEMBER_REAL_NAME, real_name));
+    new_user->profile.bot_id = slack_id_encode(
+        MEMBER_STRING(member, MEMBER_BOT_ID, bot_id));
+    new_user->team_id = slack_id_encode(
+        MEMBER_STRING(member, MEMBER_TEAM_ID, team_id));
+    new_user->profile.team = slack_id_encode(
+        MEMBER_STRING(member, MEMBER_TEAM, team));
+
+    /* shared by most of the workspace, so interned */
+    new_user->tz = slack_intern_string(
+        request->workspace->strings,
+        MEMBER_STRING(member, MEMBER_TZ, tz));
+    new_user->tz_label = slack_intern_string(
+        request->workspace->strings,
+        MEMBER_STRING(member, MEMBER_TZ_LABEL, tz_label));
+    new_user->locale = slack_intern_string(
+        request->workspace->strings,
+        MEMBER_STRING(member, MEMBER_LOCALE, locale));
+    new_user->profile.status_emoji = slack_intern_string(
+        request->workspace->strings,
+        MEMBER_STRING(member, MEMBER_STATUS_EMOJI, status_emoji));
+
+    if (SLACK_JSON_FOUND(member, MEMBER_TZ_OFFSET))
+        new_user->tz_offset = member->tz_offset;
+}
+
 static const struct lws_protocols protocols[];
 
 static int callback_http(struct lws *wsi, enum lws_callback_reasons reason,
@@ -52,13 +205,13 @@ static int callback_http(struct lws *wsi, enum lws_callback_reasons reason,
         weechat_printf(
             request->workspace->buffer,
             _("%s%s: (%d) error connecting to slack: %s"),
-            weechat_prefix("error"), SLACK_PLUGIN_NAME, request->idx,
+            SLACK_PREFIX_ERROR, SLACK_PLUGIN_NAME, request->idx,
             in ? (char *)in : "(null)");
 
         weechat_printf(
             request->workspace->buffer,
             _("%s%s: (%d) reconnecting..."),
-            weechat_prefix("error"), SLACK_PLUGIN_NAME, request->idx);
+            SLACK_PREFIX_ERROR, SLACK_PLUGIN_NAME, request->idx);
 
         memset(&ccinfo, 0, sizeof(ccinfo)); /* otherwise uninitialized garbage */
         ccinfo.context = request->context;
@@ -81,33 +234,18 @@ static int callback_http(struct lws *wsi, enum lws_callback_reasons reason,
         weechat_printf(
             request->workspace->buffer,
             _("%s%s: (%d) retrieving users... (%d)"),
-            weechat_prefix("network"), SLACK_PLUGIN_NAME, request->idx,
+            SLACK_PREFIX_NETWORK, SLACK_PLUGIN_NAME, request->idx,
             status);
+
+        if (request->decoder)
+            slack_json_decoder_reset(request->decoder);
+        else
+            request->decoder = slack_json_decoder_new(&table, request);
         break;
 
     /* chunks of chunked content, with header removed */
     case LWS_CALLBACK_RECEIVE_CLIENT_HTTP_READ:
-        {
-            struct t_json_chunk *new_chunk, *last_chunk;
-
-            new_chunk = malloc(sizeof(*new_chunk));
-            new_chunk->data = malloc((1024 * sizeof(char)) + 1);
-            new_chunk->data[0] = '\0';
-            new_chunk->next = NULL;
-
-            strncat(new_chunk->data, in, (int)len);
-
-            if (request->json_chunks)
-            {
-                for (last_chunk = request->json_chunks; last_chunk->next;
-                        last_chunk = last_chunk->next);
-                last_chunk->next = new_chunk;
-            }
-            else
-            {
-                request->json_chunks = new_chunk;
-            }
-        }
+        slack_json_decoder_feed(request->decoder, in, len);
         return 0; /* don't passthru */
 
     /* uninterpreted http content */
@@ -124,128 +262,20 @@ static int callback_http(struct lws *wsi, enum lws_callback_reasons reason,
 
     case LWS_CALLBACK_COMPLETED_CLIENT_HTTP:
         {
-            int chunk_count, i;
-            char *json_string;
             char cursor[64];
-            json_object *response, *ok, *error, *members;
-            json_object *user, *id, *name;
-            json_object *profile, *display_name, *bot_id;
-            json_object *metadata, *next_cursor;
-            struct t_json_chunk *chunk_ptr;
-
-            chunk_count = 0;
-            if (request->json_chunks)
-            {
-                chunk_count++;
-                for (chunk_ptr = request->json_chunks; chunk_ptr->next;
-                        chunk_ptr = chunk_ptr->next)
-                {
-                    chunk_count++;
-                }
-            }
-
-            json_string = malloc((1024 * sizeof(char) * chunk_count) + 1);
-            json_string[0] = '\0';
+            const struct t_users_list_result *result;
 
-            chunk_ptr = request->json_chunks;
-            for (i = 0; i < chunk_count; i++)
-            {
-                strncat(json_string, chunk_ptr->data, 1024);
-                chunk_ptr = chunk_ptr->next;
-
-                free(request->json_chunks->data);
-                free(request->json_chunks);
-                request->json_chunks = chunk_ptr;
-            }
-
-            weechat_printf(
-                request->workspace->buffer,
-                _("%s%s: (%d) got response: %s"),
-                weechat_prefix("network"), SLACK_PLUGIN_NAME, request->idx,
-                json_string);
-            
-            response = json_tokener_parse(json_string);
-            ok = json_object_object_get(response, "ok");
-            if (!json_valid(ok, request->workspace))
-            {
-                json_object_put(response);
-                free(json_string);
+            result = slack_json_decoder_finish(request->decoder);
+            if (!json_valid(result && SLACK_JSON_FOUND(result, USERS_LIST_OK),
+                            request->workspace))
                 return 0;
-            }
 
-            if(json_object_get_boolean(ok))
+            if (result->ok)
             {
-                members = json_object_object_get(response, "members");
-                if (!json_valid(members, request->workspace))
-                {
-                    json_object_put(response);
-                    free(json_string);
-                    return 0;
-                }
-
-                for (i = json_object_array_length(members); i > 0; i--)
-                {
-                    struct t_slack_user *new_user;
-
-                    user = json_object_array_get_idx(members, i - 1);
-                    if (!json_valid(user, request->workspace))
-                    {
-                        continue;
-                    }
-
-                    id = json_object_object_get(user, "id");
-                    if (!json_valid(id, request->workspace))
-                    {
-                        continue;
-                    }
-
-                    name = json_object_object_get(user, "name");
-                    if (!json_valid(name, request->workspace))
-                    {
-                        continue;
-                    }
-
-                    profile = json_object_object_get(user, "profile");
-                    if (!json_valid(profile, request->workspace))
-                    {
-                        continue;
-                    }
-
-                    display_name = json_object_object_get(profile, "display_name");
-                    if (!json_valid(display_name, request->workspace))
-                    {
-                        continue;
-                    }
-
-                    new_user = slack_user_new(request->workspace,
-                                              json_object_get_string(id),
-                                              json_object_get_string(display_name)[0] ?
-                                              json_object_get_string(display_name) :
-                                              json_object_get_string(name));
-                    
-                    bot_id = json_object_object_get(profile, "bot_id");
-                    if (json_valid(bot_id, request->workspace))
-                    {
-                        new_user->profile.bot_id = strdup(json_object_get_string(bot_id));
-                    }
-                }
-
-                metadata = json_object_object_get(response, "response_metadata");
-                if (!json_valid(metadata, request->workspace))
-                {
-                    json_object_put(response);
-                    free(json_string);
-                    return 0;
-                }
-
-                next_cursor = json_object_object_get(metadata, "next_cursor");
-                if (!json_valid(next_cursor, request->workspace))
-                {
-                    json_object_put(response);
-                    free(json_string);
+                if (!json_valid(SLACK_JSON_FOUND(result, USERS_LIST_NEXT_CURSOR),
+                                request->workspace))
                     return 0;
-                }
-                lws_urlencode(cursor, json_object_get_string(next_cursor), sizeof(cursor));
+                lws_urlencode(cursor, result->next_cursor, sizeof(cursor));
 
                 if (cursor[0])
                 {
@@ -262,6 +292,7 @@ static int callback_http(struct lws *wsi, enum lws_callback_reasons reason,
                 {
                     struct t_slack_request *next_request;
                     struct t_slack_channel *ptr_channel;
+                    char channel_id[SLACK_ID_MAX_LEN + 1];
 
                     for (ptr_channel = request->workspace->channels; ptr_channel;
                          ptr_channel = ptr_channel->next_channel)
@@ -269,7 +300,7 @@ static int callback_http(struct lws *wsi, enum lws_callback_reasons reason,
                         next_request = slack_request_conversations_members(request->workspace,
                                 weechat_config_string(
                                     request->workspace->options[SLACK_WORKSPACE_OPTION_TOKEN]),
-                                ptr_channel->id,
+                                slack_id_decode(ptr_channel->id, channel_id),
                                 cursor);
                         if (next_request)
                             slack_workspace_register_request(request->workspace, next_request);
@@ -278,27 +309,22 @@ static int callback_http(struct lws *wsi, enum lws_callback_reasons reason,
             }
             else
             {
-                error = json_object_object_get(response, "error");
-                if (!json_valid(error, request->workspace))
-                {
-                    json_object_put(response);
-                    free(json_string);
+                if (!json_valid(SLACK_JSON_FOUND(result, USERS_LIST_ERROR),
+                                request->workspace))
                     return 0;
-                }
 
                 weechat_printf(
                     request->workspace->buffer,
                     _("%s%s: (%d) failed to retrieve users: %s"),
-                    weechat_prefix("error"), SLACK_PLUGIN_NAME, request->idx,
-                    json_object_get_string(error));
+                    SLACK_PREFIX_ERROR, SLACK_PLUGIN_NAME, request->idx,
+                    result->error);
             }
-
-            json_object_put(response);
-            free(json_string);
         }
         /* fallthrough */
     case LWS_CALLBACK_CLOSED_CLIENT_HTTP:
         request->client_wsi = NULL;
+        slack_json_decoder_free(request->decoder);
+        request->decoder = NULL;
         /* Does not doing this cause a leak?
         lws_cancel_service(lws_get_context(wsi));*/ /* abort poll wait */
         break;
@@ -345,7 +371,7 @@ struct t_slack_request *slack_request_users_list(
         weechat_printf(
             workspace->buffer,
             _("%s%s: (%d) error connecting to slack: lws init failed"),
-            weechat_prefix("error"), SLACK_PLUGIN_NAME, request->idx);
+            SLACK_PREFIX_ERROR, SLACK_PLUGIN_NAME, request->idx);
         return NULL;
     }
     else
@@ -353,7 +379,7 @@ struct t_slack_request *slack_request_users_list(
         weechat_printf(
             workspace->buffer,
             _("%s%s: (%d) contacting slack.com:443"),
-            weechat_prefix("network"), SLACK_PLUGIN_NAME, request->idx);
+            SLACK_PREFIX_NETWORK, SLACK_PLUGIN_NAME, request->idx);
     }
 
     memset(&ccinfo, 0, sizeof(ccinfo)); /* otherwise uninitialized garbage */
@@ -3,12 +3,15 @@
 // file, You can obtain one at http://mozilla.org/MPL/2.0/.
 
 #include <libwebsockets.h>
-#include <json.h>
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
 
 #include "weechat-plugin.h"
 #include "slack.h"
+#include "slack-json.h"
+#include "slack-color.h"
+#include "slack-config.h"
 #include "slack-workspace.h"
 #include "slack-api.h"
 #include "api/slack-api-hello.h"
@@ -16,39 +19,131 @@
 #include "api/slack-api-message.h"
 #include "api/slack-api-user-typing.h"
 
-struct stringcase
+static t_slack_api_handler *slack_api_handler_search(const char *type)
 {
-    const char *string;
-    int (*func)(struct t_slack_workspace *workspace,
-                json_object *message);
-};
+    switch (strlen(type))
+    {
+        case 5:
+            SLACK_API_CASE(type, "error", &slack_api_error);
+            SLACK_API_CASE(type, "hello", &slack_api_hello);
+            break;
+        case 7:
+            SLACK_API_CASE(type, "message", &slack_api_message);
+            break;
+        case 11:
+            SLACK_API_CASE(type, "user_typing", &slack_api_user_typing);
+            break;
+    }
 
-static struct stringcase cases[] =
-{ { "hello", &slack_api_hello }
-, { "error", &slack_api_error }
-, { "message", &slack_api_message }
-, { "user_typing", &slack_api_user_typing }
-};
+    return NULL;
+}
 
-static int stringcase_cmp(const void *p1, const void *p2)
+static void slack_api_count(struct t_hashtable *counters,
+                            const char *prefix, const char *type)
 {
-    return strcasecmp(((struct stringcase*)p1)->string, ((struct stringcase*)p2)->string);
+    char key[128];
+    int *count, one;
+
+    snprintf(key, sizeof(key), "%s%s", prefix, type);
+    count = weechat_hashtable_get(counters, key);
+    if (count)
+    {
+        (*count)++;
+        return;
+    }
+
+    one = 1;
+    weechat_hashtable_set(counters, key, &one);
+}
+
+/*
+ * Counts an event the plugin doesn't handle (prefix is "" or the parent
+ * type, like "message."), for /slack stats. Some arrive for every
+ * presence change, so they are not printed.
+ */
+
+void slack_api_count_unhandled(struct t_slack_workspace *workspace,
+                               const char *prefix, const char *type)
+{
+    workspace->events_unhandled++;
+    slack_api_count(workspace->events_unhandled_by_type, prefix, type);
+}
+
+/*
+ * Reads the top-level "type" of a raw event without parsing it: strings
+ * are skipped and nested values only tracked by depth, so a "type" key
+ * inside a message or attachment is never taken for the event's.
+ *
+ * Returns 1 and copies the type to type if it was found and fits.
+ */
+
+static int slack_api_sniff_type(const char *frame, size_t length,
+                                char *type, size_t size)
+{
+    size_t i, start;
+    int depth;
+
+    depth = 0;
+    for (i = 0; i < length; i++)
+    {
+        switch (frame[i])
+        {
+            case '{':
+            case '[':
+                depth++;
+                break;
+            case '}':
+            case ']':
+                depth--;
+                break;
+            case '"':
+                start = ++i;
+                while (i < length && frame[i] != '"')
+                    i += (frame[i] == '\\') ? 2 : 1;
+                if (i >= length)
+                    return 0;
+                if (depth != 1 || i - start != 4
+                    || memcmp(frame + start, "type", 4) != 0)
+                    break;
+                /* a key is followed by ':', a value isn't */
+                for (i++; i < length && isspace((unsigned char)frame[i]); i++);
+                if (i >= length || frame[i] != ':')
+                    break;
+                for (i++; i < length && isspace((unsigned char)frame[i]); i++);
+                if (i >= length || frame[i] != '"')
+                    return 0;
+                start = ++i;
+                while (i < length && frame[i] != '"' && frame[i] != '\\')
+                    i++;
+                if (i >= length || frame[i] != '"' || i - start >= size)
+                    return 0;
+                memcpy(type, frame + start, i - start);
+                type[i - start] = '\0';
+                return 1;
+        }
+    }
+
+    return 0;
 }
 
-void slack_api_init()
+static void slack_api_free_json_chunks(struct t_slack_workspace *workspace)
 {
-    size_t case_count = sizeof(cases) / sizeof(cases[0]);
-    qsort(cases, case_count, sizeof(struct stringcase), stringcase_cmp);
+    struct t_json_chunk *chunk_ptr;
 
-    slack_api_message_init();
+    for (chunk_ptr = workspace->json_chunks; chunk_ptr;
+         workspace->json_chunks = chunk_ptr)
+    {
+        chunk_ptr = chunk_ptr->next;
+        free(workspace->json_chunks->data);
+        free(workspace->json_chunks);
+    }
 }
 
 static int callback_ws(struct lws* wsi, enum lws_callback_reasons reason,
                        void *user, void* in, size_t len)
 {
     struct t_slack_workspace *workspace = (struct t_slack_workspace *)user;
-
-    (void) wsi;
+    char event_type[64];
 
     switch (reason)
     {
@@ -57,7 +152,7 @@ static int callback_ws(struct lws* wsi, enum lws_callback_reasons reason,
         weechat_printf(
             workspace->buffer,
             _("%s%s: error connecting to slack: %s"),
-            weechat_prefix("error"), SLACK_PLUGIN_NAME,
+            SLACK_PREFIX_ERROR, SLACK_PLUGIN_NAME,
             in ? (char *)in : "(null)");
         workspace->client_wsi = NULL;
         break;
@@ -66,20 +161,15 @@ static int callback_ws(struct lws* wsi, enum lws_callback_reasons reason,
         weechat_printf(
             workspace->buffer,
             _("%s%s: waiting for hello..."),
-            weechat_prefix("network"), SLACK_PLUGIN_NAME);
+            SLACK_PREFIX_NETWORK, SLACK_PLUGIN_NAME);
         break;
 
     /* data is never chunked */
     case LWS_CALLBACK_CLIENT_RECEIVE:
-        weechat_printf(
-            workspace->buffer,
-            _("%s%s: received data: %s"),
-            weechat_prefix("network"), SLACK_PLUGIN_NAME,
-            (const char *)in);
         {
             int data_size;
             char *json_string;
-            json_object *response, *type;
+            struct t_slack_json_value *response, *type;
             struct t_json_chunk *new_chunk, *last_chunk, *chunk_ptr;
 
             new_chunk = malloc(sizeof(*new_chunk));
@@ -114,52 +204,64 @@ static int callback_ws(struct lws* wsi, enum lws_callback_reasons reason,
                 strcat(json_string, chunk_ptr->data);
             }
 
-            response = json_tokener_parse(json_string);
+            /* ignored events are dropped whole, before building a DOM */
+            if (lws_is_final_fragment(wsi)
+                && !lws_remaining_packet_payload(wsi)
+                && slack_config_hashtable_ignored_events
+                && slack_api_sniff_type(json_string, data_size,
+                                        event_type, sizeof(event_type))
+                && weechat_hashtable_has_key(slack_config_hashtable_ignored_events,
+                                             event_type))
+            {
+                slack_api_free_json_chunks(workspace);
+                workspace->events_dropped++;
+                slack_api_count(workspace->events_dropped_by_type, "",
+                                event_type);
+                free(json_string);
+                return 0;
+            }
+
+            response = slack_json_parse(json_string);
             if (response)
             {
-                for (chunk_ptr = workspace->json_chunks; chunk_ptr; workspace->json_chunks = chunk_ptr)
-                {
-                    chunk_ptr = chunk_ptr->next;
-                    free(workspace->json_chunks->data);
-                    free(workspace->json_chunks);
-                }
+                slack_api_free_json_chunks(workspace);
 
-                type = json_object_object_get(response, "type");
-                if (!type)
+                type = slack_json_object_get(response, "type");
+                if (!slack_json_get_string(type))
                 {
                     weechat_printf(
                         workspace->buffer,
                         _("%s%s: unexpected data received from websocket: closing"),
-                        weechat_prefix("error"), SLACK_PLUGIN_NAME);
+                        SLACK_PREFIX_ERROR, SLACK_PLUGIN_NAME);
 
                     slack_workspace_disconnect(workspace, 0);
 
-                    json_object_put(response);
+                    slack_json_free(response);
                     free(json_string);
                     return -1;
                 }
 
                 if (!slack_api_route_message(workspace,
-                        json_object_get_string(type), response))
+                        slack_json_get_string(type), response))
                 {
                     weechat_printf(
                         workspace->buffer,
                         _("%s%s: error while handling message: %s"),
-                        weechat_prefix("error"), SLACK_PLUGIN_NAME,
+                        SLACK_PREFIX_ERROR, SLACK_PLUGIN_NAME,
                         json_string);
                     weechat_printf(
                         workspace->buffer,
                         _("%s%s: closing connection."),
-                        weechat_prefix("error"), SLACK_PLUGIN_NAME);
+                        SLACK_PREFIX_ERROR, SLACK_PLUGIN_NAME);
 
                     slack_workspace_disconnect(workspace, 0);
 
-                    json_object_put(response);
+                    slack_json_free(response);
                     free(json_string);
                     return -1;
                 }
 
-                json_object_put(response);
+                slack_json_free(response);
                 free(json_string);
             }
             else
@@ -173,7 +275,7 @@ static int callback_ws(struct lws* wsi, enum lws_callback_reasons reason,
         weechat_printf(
             workspace->buffer,
             _("%s%s: websocket is writeable"),
-            weechat_prefix("network"), SLACK_PLUGIN_NAME);
+            SLACK_PREFIX_NETWORK, SLACK_PLUGIN_NAME);
         break;
 
     case LWS_CALLBACK_CLOSED:
@@ -218,7 +320,7 @@ void slack_api_connect(struct t_slack_workspace *workspace)
         weechat_printf(
             workspace->buffer,
             _("%s%s: error connecting to slack: bad websocket uri"),
-            weechat_prefix("error"), SLACK_PLUGIN_NAME);
+            SLACK_PREFIX_ERROR, SLACK_PLUGIN_NAME);
         return;
     }
 
@@ -240,7 +342,7 @@ void slack_api_connect(struct t_slack_workspace *workspace)
         weechat_printf(
             workspace->buffer,
             _("%s%s: error connecting to slack: lws init failed"),
-            weechat_prefix("error"), SLACK_PLUGIN_NAME);
+            SLACK_PREFIX_ERROR, SLACK_PLUGIN_NAME);
         return;
     }
     else
@@ -248,7 +350,7 @@ void slack_api_connect(struct t_slack_workspace *workspace)
         weechat_printf(
             workspace->buffer,
             _("%s%s: connecting to %s://%s:%d%s"),
-            weechat_prefix("network"), SLACK_PLUGIN_NAME,
+            SLACK_PREFIX_NETWORK, SLACK_PLUGIN_NAME,
             url_protocol, ccinfo.address, ccinfo.port, path);
     }
 
@@ -265,27 +367,21 @@ void slack_api_connect(struct t_slack_workspace *workspace)
 }
 
 int slack_api_route_message(struct t_slack_workspace *workspace,
-                            const char *type, json_object *message)
+                            const char *type,
+                            struct t_slack_json_value *message)
 {
-    struct stringcase key;
-    key.string = type;
+    t_slack_api_handler *handler;
 
-    size_t case_count = sizeof(cases) / sizeof(cases[0]);
-    void *entry_ptr = bsearch(&key, cases, case_count,
-            sizeof(struct stringcase), stringcase_cmp);
+    workspace->events_received++;
 
-    if (entry_ptr)
-    {
-        struct stringcase *entry = (struct stringcase *)entry_ptr;
-        return (*entry->func)(workspace, message);
-    }
-    else
+    handler = slack_api_handler_search(type);
+    if (!handler)
     {
-        weechat_printf(
-            workspace->buffer,
-            _("%s%s: got unhandled message of type: %s"),
-            weechat_prefix("error"), SLACK_PLUGIN_NAME,
-            type);
+        slack_api_count_unhandled(workspace, "", type);
         return 1;
     }
+
+    slack_api_count(workspace->events_handled_by_type, "", type);
+
+    return (*handler)(workspace, message);
 }
@@ -5,11 +5,25 @@
 #ifndef _SLACK_API_H_
 #define _SLACK_API_H_
 
-void slack_api_init();
+typedef int (t_slack_api_handler)(struct t_slack_workspace *workspace,
+                                  struct t_slack_json_value *message);
+
+/*
+ * Event names are dispatched with a switch on their length, then compared
+ * with the few names of that length: inside a case, the name matches a
+ * literal when their first sizeof(literal) - 1 bytes do.
+ */
+#define SLACK_API_CASE(__name, __literal, __handler)                    \
+    if (memcmp(__name, __literal, sizeof(__literal) - 1) == 0)          \
+        return __handler
+
+void slack_api_count_unhandled(struct t_slack_workspace *workspace,
+                               const char *prefix, const char *type);
 
 void slack_api_connect(struct t_slack_workspace *workspace);
 
 int slack_api_route_message(struct t_slack_workspace *workspace,
-                            const char *type, json_object *message);
+                            const char *type,
+                            struct t_slack_json_value *message);
 
 #endif /*SLACK_API_H*/
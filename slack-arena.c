@@ -0,0 +1,120 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, version 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "slack-arena.h"
+
+#define SLACK_ARENA_ALIGN(size) (((size) + 15) & ~(size_t)15)
+
+#define SLACK_ARENA_HEADER_SIZE \
+    SLACK_ARENA_ALIGN(sizeof(struct t_slack_arena_block))
+
+struct t_slack_arena *slack_arena_new(size_t block_size)
+{
+    struct t_slack_arena *new_arena;
+
+    new_arena = malloc(sizeof(*new_arena));
+    if (!new_arena)
+        return NULL;
+
+    new_arena->blocks = NULL;
+    new_arena->block_size = (block_size) ? block_size : SLACK_ARENA_BLOCK_SIZE;
+    new_arena->allocated = 0;
+
+    return new_arena;
+}
+
+void *slack_arena_alloc(struct t_slack_arena *arena, size_t size)
+{
+    struct t_slack_arena_block *block, *new_block;
+    size_t block_size;
+    void *ptr;
+
+    if (!arena)
+        return NULL;
+
+    size = SLACK_ARENA_ALIGN((size) ? size : 1);
+
+    block = arena->blocks;
+    if (!block || block->size - block->used < size)
+    {
+        block_size = SLACK_ARENA_HEADER_SIZE
+            + ((size > arena->block_size) ? size : arena->block_size);
+        new_block = malloc(block_size);
+        if (!new_block)
+            return NULL;
+        new_block->size = block_size;
+        new_block->used = SLACK_ARENA_HEADER_SIZE;
+        arena->allocated += block_size;
+
+        /* an oversized allocation must not waste the current block */
+        if (block && size > arena->block_size)
+        {
+            new_block->next_block = block->next_block;
+            block->next_block = new_block;
+        }
+        else
+        {
+            new_block->next_block = block;
+            arena->blocks = new_block;
+        }
+        block = new_block;
+    }
+
+    ptr = (char *)block + block->used;
+    block->used += size;
+
+    return ptr;
+}
+
+char *slack_arena_strdup(struct t_slack_arena *arena, const char *str)
+{
+    char *new_str;
+    size_t length;
+
+    if (!str)
+        return NULL;
+
+    length = strlen(str) + 1;
+    new_str = slack_arena_alloc(arena, length);
+    if (new_str)
+        memcpy(new_str, str, length);
+
+    return new_str;
+}
+
+void slack_arena_clear(struct t_slack_arena *arena)
+{
+    struct t_slack_arena_block *ptr_block, *next_block;
+
+    if (!arena)
+        return;
+
+    for (ptr_block = arena->blocks; ptr_block; ptr_block = next_block)
+    {
+        next_block = ptr_block->next_block;
+        free(ptr_block);
+    }
+    arena->blocks = NULL;
+    arena->allocated = 0;
+}
+
+void slack_arena_free(struct t_slack_arena *arena)
+{
+    if (!arena)
+        return;
+
+    slack_arena_clear(arena);
+    free(arena);
+}
+
+size_t slack_arena_memory(struct t_slack_arena *arena)
+{
+    if (!arena)
+        return 0;
+
+    return sizeof(*arena) + arena->allocated;
+}
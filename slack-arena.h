@@ -0,0 +1,42 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, version 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef _SLACK_ARENA_H_
+#define _SLACK_ARENA_H_
+
+#include <stddef.h>
+
+#define SLACK_ARENA_BLOCK_SIZE 16384
+
+struct t_slack_arena_block
+{
+    struct t_slack_arena_block *next_block;
+    size_t size;
+    size_t used;
+};
+
+/*
+ * Region allocator: allocations are carved out of large blocks and are only
+ * released all at once, by slack_arena_clear or slack_arena_free.
+ */
+struct t_slack_arena
+{
+    struct t_slack_arena_block *blocks;
+    size_t block_size;
+    size_t allocated;
+};
+
+struct t_slack_arena *slack_arena_new(size_t block_size);
+
+void *slack_arena_alloc(struct t_slack_arena *arena, size_t size);
+
+char *slack_arena_strdup(struct t_slack_arena *arena, const char *str);
+
+void slack_arena_clear(struct t_slack_arena *arena);
+
+void slack_arena_free(struct t_slack_arena *arena);
+
+size_t slack_arena_memory(struct t_slack_arena *arena);
+
+#endif /*SLACK_ARENA_H*/
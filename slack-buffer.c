@@ -2,14 +2,227 @@
 // License, version 2.0. If a copy of the MPL was not distributed with this
 // file, You can obtain one at http://mozilla.org/MPL/2.0/.
 
+#include <stdio.h>
 #include <string.h>
 
 #include "weechat-plugin.h"
 #include "slack.h"
+#include "slack-id.h"
 #include "slack-workspace.h"
+#include "slack-user.h"
 #include "slack-channel.h"
 #include "slack-buffer.h"
 
+/* buffer -> channel and buffer -> workspace, for O(1) callback lookups */
+struct t_hashtable *slack_buffer_channels = NULL;
+struct t_hashtable *slack_buffer_workspaces = NULL;
+
+/* "domain\ttype\tchannel" -> buffer, matched case insensitively like the
+ * workspace name indexes, and each indexed buffer -> its key */
+struct t_hashtable *slack_buffer_names = NULL;
+struct t_hashtable *slack_buffer_name_keys = NULL;
+
+struct t_hook *slack_buffer_hook_opened = NULL;
+struct t_hook *slack_buffer_hook_closing = NULL;
+struct t_hook *slack_buffer_hook_localvar = NULL;
+
+static void slack_buffer_name_key(char *key, int size, const char *domain,
+                                  const char *type, const char *name)
+{
+    snprintf(key, size, "%s\t%s\t%s", domain, type, name);
+}
+
+static void slack_buffer_index_remove(struct t_gui_buffer *buffer)
+{
+    const char *key;
+
+    key = weechat_hashtable_get(slack_buffer_name_keys, buffer);
+    if (!key)
+        return;
+
+    if (weechat_hashtable_get(slack_buffer_names, key) == buffer)
+        weechat_hashtable_remove(slack_buffer_names, key);
+    weechat_hashtable_remove(slack_buffer_name_keys, buffer);
+}
+
+static void slack_buffer_index_update(struct t_gui_buffer *buffer)
+{
+    const char *ptr_type, *ptr_workspace_name, *ptr_channel_name, *ptr_key;
+    char key[512];
+
+    if (weechat_buffer_get_pointer(buffer, "plugin") != weechat_slack_plugin)
+    {
+        slack_buffer_index_remove(buffer);
+        return;
+    }
+
+    ptr_type = weechat_buffer_get_string(buffer, "localvar_type");
+    ptr_workspace_name = weechat_buffer_get_string(buffer, "localvar_server");
+    ptr_channel_name = weechat_buffer_get_string(buffer, "localvar_channel");
+    if (!ptr_type || !ptr_type[0]
+        || !ptr_workspace_name || !ptr_workspace_name[0]
+        || !ptr_channel_name || !ptr_channel_name[0])
+    {
+        slack_buffer_index_remove(buffer);
+        return;
+    }
+
+    slack_buffer_name_key(key, sizeof(key),
+                          ptr_workspace_name, ptr_type, ptr_channel_name);
+
+    /* other local variables (typing, ...) change often: keep the entry */
+    ptr_key = weechat_hashtable_get(slack_buffer_name_keys, buffer);
+    if (ptr_key && strcmp(ptr_key, key) == 0)
+        return;
+
+    slack_buffer_index_remove(buffer);
+    weechat_hashtable_set(slack_buffer_names, key, buffer);
+    weechat_hashtable_set(slack_buffer_name_keys, buffer, key);
+}
+
+static int slack_buffer_index_update_cb(const void *pointer, void *data,
+                                        const char *signal,
+                                        const char *type_data,
+                                        void *signal_data)
+{
+    (void) pointer;
+    (void) data;
+    (void) signal;
+    (void) type_data;
+
+    slack_buffer_index_update(signal_data);
+
+    return WEECHAT_RC_OK;
+}
+
+static int slack_buffer_index_remove_cb(const void *pointer, void *data,
+                                        const char *signal,
+                                        const char *type_data,
+                                        void *signal_data)
+{
+    (void) pointer;
+    (void) data;
+    (void) signal;
+    (void) type_data;
+
+    slack_buffer_index_remove(signal_data);
+
+    return WEECHAT_RC_OK;
+}
+
+struct t_gui_buffer *slack_buffer_search(const char *domain, const char *type,
+                                         const char *name)
+{
+    char key[512];
+
+    if (!domain || !type || !name)
+        return NULL;
+
+    slack_buffer_name_key(key, sizeof(key), domain, type, name);
+
+    return weechat_hashtable_get(slack_buffer_names, key);
+}
+
+void slack_buffer_init()
+{
+    struct t_hdata *hdata_buffer;
+    struct t_gui_buffer *ptr_buffer;
+
+    slack_buffer_channels = weechat_hashtable_new(64,
+                                                  WEECHAT_HASHTABLE_POINTER,
+                                                  WEECHAT_HASHTABLE_POINTER,
+                                                  NULL, NULL);
+    slack_buffer_workspaces = weechat_hashtable_new(8,
+                                                    WEECHAT_HASHTABLE_POINTER,
+                                                    WEECHAT_HASHTABLE_POINTER,
+                                                    NULL, NULL);
+    slack_buffer_names = slack_workspace_name_hashtable_new(64);
+    slack_buffer_name_keys = weechat_hashtable_new(64,
+                                                   WEECHAT_HASHTABLE_POINTER,
+                                                   WEECHAT_HASHTABLE_STRING,
+                                                   NULL, NULL);
+
+    /* index existing buffers once, then follow changes with signals */
+    hdata_buffer = weechat_hdata_get("buffer");
+    ptr_buffer = weechat_hdata_get_list(hdata_buffer, "gui_buffers");
+    while (ptr_buffer)
+    {
+        slack_buffer_index_update(ptr_buffer);
+        ptr_buffer = weechat_hdata_move(hdata_buffer, ptr_buffer, 1);
+    }
+
+    slack_buffer_hook_opened = weechat_hook_signal("buffer_opened",
+                                                   &slack_buffer_index_update_cb,
+                                                   NULL, NULL);
+    slack_buffer_hook_closing = weechat_hook_signal("buffer_closing",
+                                                    &slack_buffer_index_remove_cb,
+                                                    NULL, NULL);
+    slack_buffer_hook_localvar = weechat_hook_signal("buffer_localvar_*",
+                                                     &slack_buffer_index_update_cb,
+                                                     NULL, NULL);
+}
+
+void slack_buffer_end()
+{
+    if (slack_buffer_hook_opened)
+    {
+        weechat_unhook(slack_buffer_hook_opened);
+        slack_buffer_hook_opened = NULL;
+    }
+    if (slack_buffer_hook_closing)
+    {
+        weechat_unhook(slack_buffer_hook_closing);
+        slack_buffer_hook_closing = NULL;
+    }
+    if (slack_buffer_hook_localvar)
+    {
+        weechat_unhook(slack_buffer_hook_localvar);
+        slack_buffer_hook_localvar = NULL;
+    }
+    if (slack_buffer_names)
+    {
+        weechat_hashtable_free(slack_buffer_names);
+        slack_buffer_names = NULL;
+    }
+    if (slack_buffer_name_keys)
+    {
+        weechat_hashtable_free(slack_buffer_name_keys);
+        slack_buffer_name_keys = NULL;
+    }
+    if (slack_buffer_channels)
+    {
+        weechat_hashtable_free(slack_buffer_channels);
+        slack_buffer_channels = NULL;
+    }
+    if (slack_buffer_workspaces)
+    {
+        weechat_hashtable_free(slack_buffer_workspaces);
+        slack_buffer_workspaces = NULL;
+    }
+}
+
+void slack_buffer_register(struct t_gui_buffer *buffer,
+                           struct t_slack_workspace *workspace,
+                           struct t_slack_channel *channel)
+{
+    if (!buffer)
+        return;
+
+    if (channel)
+        weechat_hashtable_set(slack_buffer_channels, buffer, channel);
+    else if (workspace)
+        weechat_hashtable_set(slack_buffer_workspaces, buffer, workspace);
+}
+
+void slack_buffer_unregister(struct t_gui_buffer *buffer)
+{
+    if (!buffer)
+        return;
+
+    weechat_hashtable_remove(slack_buffer_channels, buffer);
+    weechat_hashtable_remove(slack_buffer_workspaces, buffer);
+}
+
 void slack_buffer_get_workspace_and_channel(struct t_gui_buffer *buffer,
                                             struct t_slack_workspace **workspace,
                                             struct t_slack_channel **channel)
@@ -20,29 +233,23 @@ void slack_buffer_get_workspace_and_channel(struct t_gui_buffer *buffer,
     if (!buffer)
         return;
 
-	/* look for a workspace or channel using this buffer */
-    for (ptr_workspace = slack_workspaces; ptr_workspace;
-         ptr_workspace = ptr_workspace->next_workspace)
+    /* look for a workspace or channel using this buffer */
+    ptr_channel = weechat_hashtable_get(slack_buffer_channels, buffer);
+    if (ptr_channel)
     {
-        if (ptr_workspace->buffer == buffer)
-        {
-            if (workspace)
-                *workspace = ptr_workspace;
-            return;
-        }
+        if (workspace)
+            *workspace = ptr_channel->workspace;
+        if (channel)
+            *channel = ptr_channel;
+        return;
+    }
 
-        for (ptr_channel = ptr_workspace->channels; ptr_channel;
-             ptr_channel = ptr_channel->next_channel)
-        {
-            if (ptr_channel->buffer == buffer)
-            {
-                if (workspace)
-                    *workspace = ptr_workspace;
-                if (channel)
-                    *channel = ptr_channel;
-                return;
-            }
-        }
+    ptr_workspace = weechat_hashtable_get(slack_buffer_workspaces, buffer);
+    if (ptr_workspace)
+    {
+        if (workspace)
+            *workspace = ptr_workspace;
+        return;
     }
 
     /* no workspace or channel found */
@@ -55,11 +262,7 @@ char *slack_buffer_typing_bar_cb(const void *pointer,
                                  struct t_gui_buffer *buffer,
                                  struct t_hashtable *extra_info)
 {
-    struct t_slack_channel_typing *ptr_typing;
-    struct t_slack_workspace *workspace;
     struct t_slack_channel *channel;
-    char notification[256];
-    unsigned typecount;
 
     (void) pointer;
     (void) data;
@@ -67,46 +270,51 @@ char *slack_buffer_typing_bar_cb(const void *pointer,
     (void) window;
     (void) extra_info;
 
-    workspace = NULL;
     channel = NULL;
 
-    slack_buffer_get_workspace_and_channel(buffer, &workspace, &channel);
+    slack_buffer_get_workspace_and_channel(buffer, NULL, &channel);
 
     if (!channel)
         return strdup("");
 
-    typecount = 0;
+    return strdup(slack_channel_typing_notification(channel));
+}
 
-    for (ptr_typing = channel->typings; ptr_typing;
-         ptr_typing = ptr_typing->next_typing)
-    {
-        switch (++typecount)
-        {
-            case 1:
-                strcpy(notification, ptr_typing->name);
-                break;
-            case 2:
-                strcat(notification, ", ");
-                strcat(notification, ptr_typing->name);
-                break;
-            case 3:
-            default:
-                strcpy(notification, "Several people");
-                break;
-        }
-    }
+/*
+ * Fills the nicklist of a buffer once it is shown: on buffer_switch for the
+ * buffer, and on window_switch for the buffer of the window, since moving
+ * to another window shows a buffer without switching to it.
+ */
 
-    if (typecount)
-    {
-        strcat(notification, NG_(" is typing...",
-                                 " are typing...",
-                                 typecount));
-        return strdup(notification);
-    }
-    else
-    {
-        return strdup("");
-    }
+int slack_buffer_switch_cb(const void *pointer, void *data,
+                           const char *signal, const char *type_data,
+                           void *signal_data)
+{
+    struct t_slack_workspace *ptr_workspace;
+    struct t_slack_channel *ptr_channel;
+    struct t_gui_buffer *ptr_buffer;
+
+    (void) pointer;
+    (void) data;
+    (void) type_data;
+
+    ptr_buffer = signal_data;
+    if (strcmp(signal, "window_switch") == 0)
+        ptr_buffer = weechat_window_get_pointer(signal_data, "buffer");
+    if (!ptr_buffer)
+        return WEECHAT_RC_OK;
+
+    ptr_workspace = NULL;
+    ptr_channel = NULL;
+    slack_buffer_get_workspace_and_channel(ptr_buffer,
+                                           &ptr_workspace, &ptr_channel);
+
+    if (ptr_channel && !ptr_channel->nicklist_loaded)
+        slack_user_nicklist_populate(ptr_workspace, ptr_channel);
+    else if (ptr_workspace && !ptr_channel && !ptr_workspace->nicklist_loaded)
+        slack_user_nicklist_populate(ptr_workspace, NULL);
+
+    return WEECHAT_RC_OK;
 }
 
 int slack_buffer_nickcmp_cb(const void *pointer, void *data,
@@ -114,23 +322,23 @@ int slack_buffer_nickcmp_cb(const void *pointer, void *data,
                             const char *nick1,
                             const char *nick2)
 {
-    struct t_slack_workspace *workspace;
+    struct t_slack_user *ptr_user;
 
+    (void) pointer;
     (void) data;
+    (void) buffer;
 
-    if (pointer)
-        workspace = (struct t_slack_workspace *)pointer;
-    else
-        slack_buffer_get_workspace_and_channel(buffer, &workspace, NULL);
+    /*
+     * weechat passes the nick being added on either side (it is second when
+     * looking for a duplicate): its key is used, the other nick is folded
+     */
+    ptr_user = slack_user_nicklist_inserted;
+    if (ptr_user && nick1 == ptr_user->profile.display_name)
+        return slack_user_sort_key_cmp_name(ptr_user, nick2);
+    if (ptr_user && nick2 == ptr_user->profile.display_name)
+        return -slack_user_sort_key_cmp_name(ptr_user, nick1);
 
-    if (workspace)
-    {
-        return weechat_strcasecmp(nick1, nick2);
-    }
-    else
-    {
-        return weechat_strcasecmp(nick1, nick2);
-    }
+    return weechat_strcasecmp(nick1, nick2);
 }
 
 int slack_buffer_close_cb(const void *pointer, void *data,
@@ -149,7 +357,15 @@ int slack_buffer_close_cb(const void *pointer, void *data,
     (void) data;
     (void) buffer;
 
-    if (ptr_workspace)
+    slack_buffer_unregister(buffer);
+
+    if (ptr_channel)
+    {
+        /* back to a directory entry, reopened on demand */
+        ptr_channel->buffer = NULL;
+        ptr_channel->nicklist_loaded = 0;
+    }
+    else if (ptr_workspace)
     {
         if (!ptr_workspace->disconnected)
         {
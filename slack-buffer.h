@@ -5,6 +5,19 @@
 #ifndef _SLACK_BUFFER_H_
 #define _SLACK_BUFFER_H_
 
+void slack_buffer_init();
+
+void slack_buffer_end();
+
+void slack_buffer_register(struct t_gui_buffer *buffer,
+                           struct t_slack_workspace *workspace,
+                           struct t_slack_channel *channel);
+
+void slack_buffer_unregister(struct t_gui_buffer *buffer);
+
+struct t_gui_buffer *slack_buffer_search(const char *domain, const char *type,
+                                         const char *name);
+
 void slack_buffer_get_workspace_and_channel(struct t_gui_buffer *buffer,
                                             struct t_slack_workspace **workspace,
                                             struct t_slack_channel **channel);
@@ -16,6 +29,10 @@ char *slack_buffer_typing_bar_cb(const void *pointer,
                                  struct t_gui_buffer *buffer,
                                  struct t_hashtable *extra_info);
 
+int slack_buffer_switch_cb(const void *pointer, void *data,
+                           const char *signal, const char *type_data,
+                           void *signal_data);
+
 int slack_buffer_nickcmp_cb(const void *pointer, void *data,
                             struct t_gui_buffer *buffer,
                             const char *nick1,
@@ -9,69 +9,42 @@
 
 #include "weechat-plugin.h"
 #include "slack.h"
+#include "slack-id.h"
+#include "slack-arena.h"
 #include "slack-workspace.h"
 #include "slack-user.h"
 #include "slack-channel.h"
+#include "slack-memberset.h"
 #include "slack-input.h"
 #include "slack-buffer.h"
 
 struct t_slack_channel *slack_channel_search(struct t_slack_workspace *workspace,
                                              const char *id)
 {
-    struct t_slack_channel *ptr_channel;
-
     if (!workspace || !id)
         return NULL;
 
-    for (ptr_channel = workspace->channels; ptr_channel;
-         ptr_channel = ptr_channel->next_channel)
-    {
-        if (weechat_strcasecmp(ptr_channel->id, id) == 0)
-            return ptr_channel;
-    }
+    return slack_channel_search_id(workspace, slack_id_encode(id));
+}
 
-    return NULL;
+struct t_slack_channel *slack_channel_search_id(struct t_slack_workspace *workspace,
+                                                t_slack_id id)
+{
+    if (!workspace)
+        return NULL;
+
+    return slack_id_hashtable_get(workspace->channels_by_id, id);
 }
 
 struct t_gui_buffer *slack_channel_search_buffer(struct t_slack_workspace *workspace,
                                                  enum t_slack_channel_type type,
                                                  const char *name)
 {
-    struct t_hdata *hdata_buffer;
-    struct t_gui_buffer *ptr_buffer;
-    const char *ptr_type, *ptr_workspace_name, *ptr_channel_name;
-
-    hdata_buffer = weechat_hdata_get("buffer");
-    ptr_buffer = weechat_hdata_get_list(hdata_buffer, "gui_buffers");
-
-    while (ptr_buffer)
-    {
-        if (weechat_buffer_get_pointer(ptr_buffer, "plugin") == weechat_slack_plugin)
-        {
-            ptr_type = weechat_buffer_get_string(ptr_buffer, "localvar_type");
-            ptr_workspace_name = weechat_buffer_get_string(ptr_buffer,
-                                                           "localvar_server");
-            ptr_channel_name = weechat_buffer_get_string(ptr_buffer,
-                                                         "localvar_channel");
-            if (ptr_type && ptr_type[0]
-                && ptr_workspace_name && ptr_workspace_name[0]
-                && ptr_channel_name && ptr_channel_name[0]
-                && (   ((   (type == SLACK_CHANNEL_TYPE_CHANNEL)
-                         || (type == SLACK_CHANNEL_TYPE_GROUP))
-                        && (strcmp(ptr_type, "channel") == 0))
-                    || ((   (type == SLACK_CHANNEL_TYPE_MPIM)
-                         || (type == SLACK_CHANNEL_TYPE_IM))
-                        && (strcmp(ptr_type, "private") == 0)))
-                && (strcmp(ptr_workspace_name, workspace->domain) == 0)
-                && (weechat_strcasecmp(ptr_channel_name, name) == 0))
-            {
-                return ptr_buffer;
-            }
-        }
-        ptr_buffer = weechat_hdata_move(hdata_buffer, ptr_buffer, 1);
-    }
-
-    return NULL;
+    return slack_buffer_search(workspace->domain,
+                               (type == SLACK_CHANNEL_TYPE_IM ||
+                                type == SLACK_CHANNEL_TYPE_MPIM) ?
+                               "private" : "channel",
+                               name);
 }
 
 struct t_gui_buffer *slack_channel_create_buffer(struct t_slack_workspace *workspace,
@@ -183,36 +156,29 @@ struct t_slack_channel *slack_channel_new(struct t_slack_workspace *workspace,
                                           const char *id, const char *name)
 {
     struct t_slack_channel *new_channel, *ptr_channel;
-    struct t_gui_buffer *ptr_buffer;
-    struct t_hook *typing_timer;
-    char buffer_name[SLACK_CHANNEL_NAME_MAX_LEN + 2];
+    t_slack_id channel_id;
 
     if (!workspace || !id || !name || !name[0])
         return NULL;
 
-    ptr_channel = slack_channel_search(workspace, id);
+    channel_id = slack_id_encode(id);
+    if (channel_id == SLACK_ID_NONE)
+        return NULL;
+
+    ptr_channel = slack_channel_search_id(workspace, channel_id);
     if (ptr_channel)
     {
         return ptr_channel;
     }
 
-    buffer_name[0] = '#';
-    strncpy(&buffer_name[1], name, SLACK_CHANNEL_NAME_MAX_LEN + 1);
-
-    ptr_buffer = slack_channel_create_buffer(workspace, type, buffer_name);
-    if (!ptr_buffer)
-        return NULL;
-
-    if ((new_channel = malloc(sizeof(*new_channel))) == NULL)
+    new_channel = slack_arena_alloc(workspace->channels_arena,
+                                    sizeof(*new_channel));
+    if (!new_channel)
         return NULL;
 
-    typing_timer = weechat_hook_timer(1 * 1000, 0, 0,
-                                      &slack_channel_typing_cb,
-                                      new_channel, NULL);
-
     new_channel->type = type;
-    new_channel->id = strdup(id);
-    new_channel->name = strdup(name);
+    new_channel->id = channel_id;
+    new_channel->name = slack_arena_strdup(workspace->channels_arena, name);
     new_channel->created = 0;
 
     new_channel->is_general = 0;
@@ -236,16 +202,26 @@ struct t_slack_channel *slack_channel_new(struct t_slack_workspace *workspace,
 
     new_channel->is_user_deleted = 0;
 
-    new_channel->typing_hook_timer = typing_timer;
     new_channel->members_speaking[0] = NULL;
     new_channel->members_speaking[1] = NULL;
     new_channel->typings = NULL;
     new_channel->last_typing = NULL;
+    new_channel->typing_notification = NULL;
+    new_channel->typing_changed = 0;
     new_channel->members = NULL;
-    new_channel->last_member = NULL;
-    new_channel->buffer = ptr_buffer;
+    new_channel->members_generation = 0;
+    new_channel->members_sorted = NULL;
+    new_channel->members_sorted_count = 0;
+    new_channel->members_sorted_size = 0;
+    new_channel->members_sorted_generation = 0;
+    new_channel->members_sorted_users_generation = 0;
+    new_channel->nicklist_loaded = 0;
+    new_channel->buffer = NULL; /* see slack_channel_open_buffer */
+    new_channel->buffer_queued = 0;
     new_channel->buffer_as_string = NULL;
 
+    new_channel->workspace = workspace;
+
     new_channel->prev_channel = workspace->last_channel;
     new_channel->next_channel = NULL;
     if (workspace->last_channel)
@@ -254,99 +230,347 @@ struct t_slack_channel *slack_channel_new(struct t_slack_workspace *workspace,
         workspace->channels = new_channel;
     workspace->last_channel = new_channel;
 
+    slack_id_hashtable_set(workspace->channels_by_id, new_channel->id,
+                           new_channel);
+    /* conversations named after people never shadow a real channel */
+    if (type == SLACK_CHANNEL_TYPE_CHANNEL || type == SLACK_CHANNEL_TYPE_GROUP
+        || !weechat_hashtable_has_key(workspace->channels_by_name,
+                                      new_channel->name))
+        weechat_hashtable_set(workspace->channels_by_name, new_channel->name,
+                              new_channel);
+
     return new_channel;
 }
 
+static void slack_channel_typing_set_localvar(struct t_slack_channel *channel)
+{
+    const char *localvar, *typing;
+
+    if (!channel->buffer)
+        return;
+
+    typing = (channel->typings) ? "1" : "0";
+    localvar = weechat_buffer_get_string(channel->buffer, "localvar_typing");
+    if (!localvar || strcmp(localvar, typing) != 0)
+        weechat_buffer_set(channel->buffer, "localvar_set_typing", typing);
+}
+
+struct t_slack_channel *slack_channel_search_name(struct t_slack_workspace *workspace,
+                                                  const char *name)
+{
+    if (!workspace || !name)
+        return NULL;
+
+    if (name[0] == '#')
+        name++;
+
+    return weechat_hashtable_get(workspace->channels_by_name, name);
+}
+
+/*
+ * Channels start as directory entries without a buffer; the buffer is
+ * created the first time it's needed (membership, message, /slack open).
+ */
+
+struct t_gui_buffer *slack_channel_open_buffer(struct t_slack_workspace *workspace,
+                                               struct t_slack_channel *channel)
+{
+    struct t_gui_buffer *ptr_buffer;
+    char buffer_name[SLACK_CHANNEL_NAME_MAX_LEN + 2];
+
+    if (!workspace || !channel)
+        return NULL;
+
+    if (channel->buffer)
+        return channel->buffer;
+
+    buffer_name[0] = '#';
+    strncpy(&buffer_name[1], channel->name, SLACK_CHANNEL_NAME_MAX_LEN + 1);
+    buffer_name[sizeof(buffer_name) - 1] = '\0';
+
+    ptr_buffer = slack_channel_create_buffer(workspace, channel->type,
+                                             buffer_name);
+    if (!ptr_buffer)
+        return NULL;
+
+    channel->buffer = ptr_buffer;
+    channel->nicklist_loaded = 0;
+    slack_buffer_register(ptr_buffer, workspace, channel);
+
+    weechat_buffer_set(ptr_buffer, "title",
+                       (channel->topic.value) ? channel->topic.value : "");
+    slack_channel_typing_set_localvar(channel);
+
+    if (weechat_buffer_get_integer(ptr_buffer, "num_displayed") > 0)
+        slack_user_nicklist_populate(workspace, channel);
+
+    return ptr_buffer;
+}
+
+/*
+ * Queues creation of a channel buffer; queued buffers are created a few
+ * at a time by slack_channel_open_queued_buffers.
+ */
+
+void slack_channel_queue_buffer(struct t_slack_workspace *workspace,
+                                struct t_slack_channel *channel)
+{
+    struct t_slack_channel **new_queue;
+    int new_size;
+
+    if (channel->buffer || channel->buffer_queued)
+        return;
+
+    if (workspace->buffer_queue_count == workspace->buffer_queue_size)
+    {
+        new_size = workspace->buffer_queue_size ?
+            workspace->buffer_queue_size * 2 : 64;
+        new_queue = realloc(workspace->buffer_queue,
+                            new_size * sizeof(*new_queue));
+        if (!new_queue)
+            return;
+        workspace->buffer_queue = new_queue;
+        workspace->buffer_queue_size = new_size;
+    }
+
+    workspace->buffer_queue[workspace->buffer_queue_count++] = channel;
+    channel->buffer_queued = 1;
+}
+
+void slack_channel_open_queued_buffers(struct t_slack_workspace *workspace,
+                                       int max_buffers)
+{
+    struct t_slack_channel *ptr_channel;
+
+    while (workspace->buffer_queue_next < workspace->buffer_queue_count
+           && max_buffers > 0)
+    {
+        ptr_channel = workspace->buffer_queue[workspace->buffer_queue_next++];
+        ptr_channel->buffer_queued = 0;
+        if (!ptr_channel->buffer)
+        {
+            slack_channel_open_buffer(workspace, ptr_channel);
+            max_buffers--;
+        }
+    }
+
+    if (workspace->buffer_queue_next == workspace->buffer_queue_count)
+    {
+        workspace->buffer_queue_next = 0;
+        workspace->buffer_queue_count = 0;
+    }
+}
+
+static void slack_channel_member_speaking_unlink(struct t_slack_channel_speakers *speakers,
+                                                struct t_slack_channel_speaker *speaker)
+{
+    if (speaker->prev_speaker)
+        (speaker->prev_speaker)->next_speaker = speaker->next_speaker;
+    else
+        speakers->oldest_speaker = speaker->next_speaker;
+    if (speaker->next_speaker)
+        (speaker->next_speaker)->prev_speaker = speaker->prev_speaker;
+    else
+        speakers->newest_speaker = speaker->prev_speaker;
+}
+
 void slack_channel_member_speaking_add_to_list(struct t_slack_channel *channel,
-                                               const char *nick,
+                                               t_slack_id id,
                                                int highlight)
 {
-    int size, to_remove, i;
-    struct t_weelist_item *ptr_item;
+    struct t_slack_channel_speakers *speakers;
+    struct t_slack_channel_speaker *speaker, **ptr_link;
+    int bucket;
 
     /* create list if it does not exist */
     if (!channel->members_speaking[highlight])
-        channel->members_speaking[highlight] = weechat_list_new();
-
-    /* remove item if it was already in list */
-    ptr_item = weechat_list_casesearch(channel->members_speaking[highlight], nick);
-    if (ptr_item)
-        weechat_list_remove(channel->members_speaking[highlight], ptr_item);
+    {
+        channel->members_speaking[highlight] = calloc(
+            1, sizeof(*channel->members_speaking[highlight]));
+        if (!channel->members_speaking[highlight])
+            return;
+    }
+    speakers = channel->members_speaking[highlight];
 
-    /* add nick in list */
-    weechat_list_add(channel->members_speaking[highlight], nick,
-                     WEECHAT_LIST_POS_END, NULL);
+    bucket = slack_id_hash_cb(NULL, &id) % SLACK_CHANNEL_MEMBERS_SPEAKING_BUCKETS;
+    for (speaker = speakers->buckets[bucket]; speaker;
+         speaker = speaker->next_in_bucket)
+    {
+        if (speaker->id == id)
+            break;
+    }
 
-    /* reduce list size if it's too big */
-    size = weechat_list_size(channel->members_speaking[highlight]);
-    if (size > SLACK_CHANNEL_MEMBERS_SPEAKING_LIMIT)
+    if (speaker)
     {
-        to_remove = size - SLACK_CHANNEL_MEMBERS_SPEAKING_LIMIT;
-        for (i = 0; i < to_remove; i++)
+        /* already in list: move it to the end */
+        if (speaker == speakers->newest_speaker)
+            return;
+        slack_channel_member_speaking_unlink(speakers, speaker);
+    }
+    else
+    {
+        if (speakers->count < SLACK_CHANNEL_MEMBERS_SPEAKING_LIMIT)
+            speaker = &speakers->entries[speakers->count++];
+        else
         {
-            weechat_list_remove(
-                channel->members_speaking[highlight],
-                weechat_list_get(channel->members_speaking[highlight], 0));
+            /* list is full: reuse the least recent speaker */
+            speaker = speakers->oldest_speaker;
+            slack_channel_member_speaking_unlink(speakers, speaker);
+            ptr_link = &speakers->buckets[slack_id_hash_cb(NULL, &speaker->id)
+                                          % SLACK_CHANNEL_MEMBERS_SPEAKING_BUCKETS];
+            while (*ptr_link != speaker)
+                ptr_link = &(*ptr_link)->next_in_bucket;
+            *ptr_link = speaker->next_in_bucket;
         }
+        speaker->id = id;
+        speaker->next_in_bucket = speakers->buckets[bucket];
+        speakers->buckets[bucket] = speaker;
     }
+
+    /* add speaker at the end */
+    speaker->prev_speaker = speakers->newest_speaker;
+    speaker->next_speaker = NULL;
+    if (speakers->newest_speaker)
+        (speakers->newest_speaker)->next_speaker = speaker;
+    else
+        speakers->oldest_speaker = speaker;
+    speakers->newest_speaker = speaker;
 }
 
+/*
+ * Speakers are kept by user id, so display name changes need no update:
+ * completion resolves the current name when reading the list.
+ */
+
 void slack_channel_member_speaking_add(struct t_slack_channel *channel,
-                                       const char *nick, int highlight)
+                                       struct t_slack_user *user,
+                                       int highlight)
 {
     if (highlight < 0)
         highlight = 0;
     if (highlight > 1)
         highlight = 1;
     if (highlight)
-        slack_channel_member_speaking_add_to_list(channel, nick, 1);
+        slack_channel_member_speaking_add_to_list(channel, user->id, 1);
 
-    slack_channel_member_speaking_add_to_list(channel, nick, 0);
+    slack_channel_member_speaking_add_to_list(channel, user->id, 0);
 }
 
-void slack_channel_member_speaking_rename(struct t_slack_channel *channel,
-                                          const char *old_nick,
-                                          const char *new_nick)
+static void slack_channel_typing_heap_set(struct t_slack_workspace *workspace,
+                                          int index,
+                                          struct t_slack_channel_typing *typing)
 {
-    struct t_weelist_item *ptr_item;
-    int i;
+    workspace->typing_heap[index] = typing;
+    typing->heap_index = index;
+}
+
+static void slack_channel_typing_heap_up(struct t_slack_workspace *workspace,
+                                         int index)
+{
+    struct t_slack_channel_typing *typing;
+    int parent;
 
-    for (i = 0; i < 2; i++)
+    typing = workspace->typing_heap[index];
+    while (index > 0)
     {
-        if (channel->members_speaking[i])
-        {
-            ptr_item = weechat_list_search(channel->members_speaking[i], old_nick);
-            if (ptr_item)
-                weechat_list_set(ptr_item, new_nick);
-        }
+        parent = (index - 1) / 2;
+        if (workspace->typing_heap[parent]->ts <= typing->ts)
+            break;
+        slack_channel_typing_heap_set(workspace, index,
+                                      workspace->typing_heap[parent]);
+        index = parent;
     }
+    slack_channel_typing_heap_set(workspace, index, typing);
 }
 
-void slack_channel_member_speaking_rename_if_present(struct t_slack_workspace *workspace,
-                                                     struct t_slack_channel *channel,
-                                                     const char *nick)
+static void slack_channel_typing_heap_down(struct t_slack_workspace *workspace,
+                                           int index)
 {
-    struct t_weelist_item *ptr_item;
-    int i, j, list_size;
+    struct t_slack_channel_typing *typing;
+    int child;
 
-    (void) workspace;
+    typing = workspace->typing_heap[index];
+    while ((child = 2 * index + 1) < workspace->typing_heap_count)
+    {
+        if (child + 1 < workspace->typing_heap_count
+            && workspace->typing_heap[child + 1]->ts
+               < workspace->typing_heap[child]->ts)
+            child++;
+        if (typing->ts <= workspace->typing_heap[child]->ts)
+            break;
+        slack_channel_typing_heap_set(workspace, index,
+                                      workspace->typing_heap[child]);
+        index = child;
+    }
+    slack_channel_typing_heap_set(workspace, index, typing);
+}
 
-    for (i = 0; i < 2; i++)
+static int slack_channel_typing_heap_push(struct t_slack_workspace *workspace,
+                                          struct t_slack_channel_typing *typing)
+{
+    struct t_slack_channel_typing **new_heap;
+    int new_size;
+
+    if (workspace->typing_heap_count == workspace->typing_heap_size)
     {
-        if (channel->members_speaking[i])
-        {
-            list_size = weechat_list_size(channel->members_speaking[i]);
-            for (j = 0; j < list_size; j++)
-            {
-                ptr_item = weechat_list_get (channel->members_speaking[i], j);
-                if (ptr_item && (strcasecmp(weechat_list_string(ptr_item), nick) == 0))
-                    weechat_list_set(ptr_item, nick);
-            }
-        }
+        new_size = workspace->typing_heap_size ?
+            workspace->typing_heap_size * 2 : 16;
+        new_heap = realloc(workspace->typing_heap,
+                           new_size * sizeof(*new_heap));
+        if (!new_heap)
+            return 0;
+        workspace->typing_heap = new_heap;
+        workspace->typing_heap_size = new_size;
     }
+
+    slack_channel_typing_heap_set(workspace, workspace->typing_heap_count++,
+                                  typing);
+    slack_channel_typing_heap_up(workspace, typing->heap_index);
+
+    return 1;
 }
 
-void slack_channel_typing_free(struct t_slack_channel *channel,
+static void slack_channel_typing_heap_remove(struct t_slack_workspace *workspace,
+                                             struct t_slack_channel_typing *typing)
+{
+    int index;
+
+    index = typing->heap_index;
+    if (index < 0)
+        return;
+    typing->heap_index = -1;
+
+    if (index == --workspace->typing_heap_count)
+        return;
+
+    slack_channel_typing_heap_set(workspace, index,
+                                  workspace->typing_heap[workspace->typing_heap_count]);
+    slack_channel_typing_heap_down(workspace, index);
+    slack_channel_typing_heap_up(workspace, workspace->typing_heap[index]->heap_index);
+}
+
+/*
+ * Arms the workspace typing timer for the earliest expiration; the timer
+ * fires once and is re-armed by its callback.
+ */
+
+static void slack_channel_typing_schedule(struct t_slack_workspace *workspace)
+{
+    time_t delay;
+
+    if (workspace->typing_timer || workspace->typing_heap_count == 0)
+        return;
+
+    delay = workspace->typing_heap[0]->ts + SLACK_CHANNEL_TYPING_TIMEOUT + 1
+        - time(NULL);
+
+    workspace->typing_timer = weechat_hook_timer(
+        (delay > 0) ? delay * 1000 : 1, 0, 1,
+        &slack_channel_typing_cb, workspace, NULL);
+}
+
+void slack_channel_typing_free(struct t_slack_workspace *workspace,
+                               struct t_slack_channel *channel,
                                struct t_slack_channel_typing *typing)
 {
     struct t_slack_channel_typing *new_typings;
@@ -368,32 +592,40 @@ void slack_channel_typing_free(struct t_slack_channel *channel,
     if (typing->next_typing)
         (typing->next_typing)->prev_typing = typing->prev_typing;
 
-    /* free typing data */
-    if (typing->id)
-        free(typing->id);
-    if (typing->name)
-        free(typing->name);
+    slack_channel_typing_heap_remove(workspace, typing);
 
     free(typing);
 
     channel->typings = new_typings;
+    channel->typing_changed = 1;
 }
 
-void slack_channel_typing_free_all(struct t_slack_channel *channel)
+void slack_channel_typing_free_all(struct t_slack_workspace *workspace,
+                                   struct t_slack_channel *channel)
 {
     while (channel->typings)
-        slack_channel_typing_free(channel, channel->typings);
+        slack_channel_typing_free(workspace, channel, channel->typings);
+}
+
+void slack_channel_typing_remove(struct t_slack_workspace *workspace,
+                                 struct t_slack_channel *channel,
+                                 struct t_slack_channel_typing *typing)
+{
+    slack_channel_typing_free(workspace, channel, typing);
+
+    slack_channel_typing_set_localvar(channel);
+    weechat_bar_item_update("slack_typing");
 }
 
 int slack_channel_typing_cb(const void *pointer,
                             void *data,
                             int remaining_calls)
 {
-    struct t_slack_channel_typing *ptr_typing, *next_typing;
-    struct t_slack_channel *channel;
-    const char *localvar;
-    unsigned typecount;
+    struct t_slack_workspace *workspace;
+    struct t_slack_channel_typing *ptr_typing;
+    struct t_slack_channel *ptr_channel;
     time_t now;
+    int changed;
 
     (void) data;
     (void) remaining_calls;
@@ -401,120 +633,150 @@ int slack_channel_typing_cb(const void *pointer,
     if (!pointer)
         return WEECHAT_RC_ERROR;
 
-    channel = (struct t_slack_channel *)pointer;
+    workspace = (struct t_slack_workspace *)pointer;
 
-    now = time(NULL);
+    /* this was the last call, weechat unhooks the timer after it */
+    workspace->typing_timer = NULL;
 
-    typecount = 0;
+    now = time(NULL);
 
-    for (ptr_typing = channel->typings; ptr_typing;
-         ptr_typing = ptr_typing->next_typing)
+    changed = 0;
+    while (workspace->typing_heap_count > 0
+           && now - workspace->typing_heap[0]->ts > SLACK_CHANNEL_TYPING_TIMEOUT)
     {
-        next_typing = ptr_typing->next_typing;
+        ptr_typing = workspace->typing_heap[0];
+        ptr_channel = ptr_typing->channel;
+        slack_channel_typing_free(workspace, ptr_channel, ptr_typing);
+        slack_channel_typing_set_localvar(ptr_channel);
+        changed = 1;
+    }
 
-        while (ptr_typing && now - ptr_typing->ts > 5)
-        {
-            slack_channel_typing_free(channel, ptr_typing);
-            ptr_typing = next_typing;
-            if (ptr_typing)
-                next_typing = ptr_typing->next_typing;
-        }
+    if (changed)
+        weechat_bar_item_update("slack_typing");
 
-        if (!ptr_typing)
-            break;
+    slack_channel_typing_schedule(workspace);
+
+    return WEECHAT_RC_OK;
+}
+
+/*
+ * Returns the typing notification for the bar item, rebuilt only when the
+ * set of typers changed since the last call.
+ */
+
+const char *slack_channel_typing_notification(struct t_slack_channel *channel)
+{
+    struct t_slack_channel_typing *ptr_typing;
+    const char *names[2];
+    char notification[SLACK_CHANNEL_TYPING_NOTIFICATION_MAX_LEN + 1];
+    unsigned typecount;
 
+    if (!channel->typing_changed)
+        return (channel->typing_notification) ?
+            channel->typing_notification : "";
+
+    channel->typing_changed = 0;
+    if (channel->typing_notification)
+    {
+        free(channel->typing_notification);
+        channel->typing_notification = NULL;
+    }
+
+    /* past two typers the names aren't shown, so stop counting at three */
+    typecount = 0;
+    for (ptr_typing = channel->typings; ptr_typing && typecount < 3;
+         ptr_typing = ptr_typing->next_typing)
+    {
+        if (typecount < 2)
+            names[typecount] = ptr_typing->name;
         typecount++;
     }
 
-    localvar = weechat_buffer_get_string(channel->buffer, "localvar_typing");
-    if (!localvar || strncmp(localvar, typecount > 0 ? "1" : "0", 1) != 0)
-        weechat_buffer_set(channel->buffer,
-                           "localvar_set_typing",
-                           typecount > 0 ? "1" : "0");
-    weechat_bar_item_update("slack_typing");
+    switch (typecount)
+    {
+        case 0:
+            return "";
+        case 1:
+            snprintf(notification, sizeof(notification), "%s%s",
+                     names[0], _(" is typing..."));
+            break;
+        case 2:
+            snprintf(notification, sizeof(notification), "%s, %s%s",
+                     names[0], names[1], _(" are typing..."));
+            break;
+        default:
+            snprintf(notification, sizeof(notification), "%s%s",
+                     "Several people", _(" are typing..."));
+            break;
+    }
 
-    return WEECHAT_RC_OK;
+    channel->typing_notification = strdup(notification);
+
+    return (channel->typing_notification) ? channel->typing_notification : "";
 }
 
 struct t_slack_channel_typing *slack_channel_typing_search(
                                 struct t_slack_channel *channel,
-                                const char *id)
+                                t_slack_id id)
 {
     struct t_slack_channel_typing *ptr_typing;
 
-    if (!channel || !id)
+    if (!channel || id == SLACK_ID_NONE)
         return NULL;
 
     for (ptr_typing = channel->typings; ptr_typing;
          ptr_typing = ptr_typing->next_typing)
     {
-        if (weechat_strcasecmp(ptr_typing->id, id) == 0)
+        if (ptr_typing->id == id)
             return ptr_typing;
     }
 
     return NULL;
 }
 
-void slack_channel_add_typing(struct t_slack_channel *channel,
+void slack_channel_add_typing(struct t_slack_workspace *workspace,
+                              struct t_slack_channel *channel,
                               struct t_slack_user *user)
 {
     struct t_slack_channel_typing *new_typing;
 
     new_typing = slack_channel_typing_search(channel, user->id);
-    if (!new_typing)
+    if (new_typing)
     {
-        new_typing = malloc(sizeof(*new_typing));
-        new_typing->id = strdup(user->id);
-        new_typing->name = strdup(user->profile.display_name);
-
-        new_typing->prev_typing = channel->last_typing;
-        new_typing->next_typing = NULL;
-        if (channel->last_typing)
-            (channel->last_typing)->next_typing = new_typing;
-        else
-            channel->typings = new_typing;
-        channel->last_typing = new_typing;
+        /* refreshed: only its expiration moves later */
+        new_typing->ts = time(NULL);
+        slack_channel_typing_heap_down(workspace, new_typing->heap_index);
+        return;
     }
-    new_typing->ts = time(NULL);
-
-    slack_channel_typing_cb(channel, NULL, 0);
-}
 
-void slack_channel_member_free(struct t_slack_channel *channel,
-                               struct t_slack_channel_member *member)
-{
-    struct t_slack_channel_member *new_members;
-
-    if (!channel || !member)
+    new_typing = malloc(sizeof(*new_typing));
+    if (!new_typing)
         return;
+    new_typing->id = user->id;
+    new_typing->name = user->profile.display_name;
+    new_typing->ts = time(NULL);
+    new_typing->channel = channel;
+    new_typing->heap_index = -1;
 
-    /* remove member from members list */
-    if (channel->last_member == member)
-        channel->last_member = member->prev_member;
-    if (member->prev_member)
+    if (!slack_channel_typing_heap_push(workspace, new_typing))
     {
-        (member->prev_member)->next_member = member->next_member;
-        new_members = channel->members;
+        free(new_typing);
+        return;
     }
-    else
-        new_members = member->next_member;
-
-    if (member->next_member)
-        (member->next_member)->prev_member = member->prev_member;
 
-    /* free member data */
-    if (member->id)
-        free(member->id);
+    new_typing->prev_typing = channel->last_typing;
+    new_typing->next_typing = NULL;
+    if (channel->last_typing)
+        (channel->last_typing)->next_typing = new_typing;
+    else
+        channel->typings = new_typing;
+    channel->last_typing = new_typing;
+    channel->typing_changed = 1;
 
-    free(member);
+    slack_channel_typing_set_localvar(channel);
+    weechat_bar_item_update("slack_typing");
 
-    channel->members = new_members;
-}
-
-void slack_channel_member_free_all(struct t_slack_channel *channel)
-{
-    while (channel->members)
-        slack_channel_member_free(channel, channel->members);
+    slack_channel_typing_schedule(workspace);
 }
 
 void slack_channel_free(struct t_slack_workspace *workspace,
@@ -539,104 +801,168 @@ void slack_channel_free(struct t_slack_workspace *workspace,
     if (channel->next_channel)
         (channel->next_channel)->prev_channel = channel->prev_channel;
 
-    /* free hooks */
-    if (channel->typing_hook_timer)
-        weechat_unhook(channel->typing_hook_timer);
+    slack_id_hashtable_remove(workspace->channels_by_id, channel->id);
+    if (weechat_hashtable_get(workspace->channels_by_name,
+                              channel->name) == channel)
+        weechat_hashtable_remove(workspace->channels_by_name, channel->name);
 
     /* free linked lists */
-    slack_channel_typing_free_all(channel);
-    slack_channel_member_free_all(channel);
-
-    /* free channel data */
-    if (channel->id)
-        free(channel->id);
-    if (channel->name)
-        free(channel->name);
-    if (channel->name_normalized)
-        free(channel->name_normalized);
-    if (channel->topic.value)
-        free(channel->topic.value);
-    if (channel->topic.creator)
-        free(channel->topic.creator);
-    if (channel->purpose.value)
-        free(channel->purpose.value);
-    if (channel->purpose.creator)
-        free(channel->purpose.creator);
-    if (channel->creator)
-        free(channel->creator);
+    slack_channel_typing_free_all(workspace, channel);
+    slack_memberset_free(channel->members);
+
+    /* free channel data (strings live in the channels arena) */
     if (channel->members_speaking[0])
-        weechat_list_free(channel->members_speaking[0]);
+        free(channel->members_speaking[0]);
     if (channel->members_speaking[1])
-        weechat_list_free(channel->members_speaking[1]);
+        free(channel->members_speaking[1]);
+    if (channel->typing_notification)
+        free(channel->typing_notification);
+    if (channel->members_sorted)
+        free(channel->members_sorted);
     if (channel->buffer_as_string)
         free(channel->buffer_as_string);
 
-    free(channel);
+    slack_buffer_unregister(channel->buffer);
 
     workspace->channels = new_channels;
 }
 
 void slack_channel_free_all(struct t_slack_workspace *workspace)
 {
+    /* queued channels are about to be freed */
+    workspace->buffer_queue_next = 0;
+    workspace->buffer_queue_count = 0;
+
     while (workspace->channels)
         slack_channel_free(workspace, workspace->channels);
+
+    slack_arena_clear(workspace->channels_arena);
 }
 
-void slack_channel_update_topic(struct t_slack_channel *channel,
+void slack_channel_update_topic(struct t_slack_workspace *workspace,
+                                struct t_slack_channel *channel,
                                 const char* topic,
                                 const char* creator,
                                 int last_set)
 {
-    if (channel->topic.value)
-        free(channel->topic.value);
-    if (channel->topic.creator)
-        free(channel->topic.creator);
-    channel->topic.value = (topic) ? strdup(topic) : NULL;
-    channel->topic.creator = (creator) ? strdup(creator) : NULL;
+    /* previous values stay in the arena until the next resync */
+    channel->topic.value = slack_arena_strdup(workspace->channels_arena, topic);
+    channel->topic.creator = slack_arena_strdup(workspace->channels_arena,
+                                                creator);
     channel->topic.last_set = last_set;
 
+    if (!channel->buffer)
+        return;
+
     if (channel->topic.value)
         weechat_buffer_set(channel->buffer, "title", topic);
     else
         weechat_buffer_set(channel->buffer, "title", "");
 }
 
-void slack_channel_update_purpose(struct t_slack_channel *channel,
+void slack_channel_update_purpose(struct t_slack_workspace *workspace,
+                                  struct t_slack_channel *channel,
                                   const char* purpose,
                                   const char* creator,
                                   int last_set)
 {
-    if (channel->purpose.value)
-        free(channel->purpose.value);
-    if (channel->purpose.creator)
-        free(channel->purpose.creator);
-    channel->purpose.value = (purpose) ? strdup(purpose) : NULL;
-    channel->purpose.creator = (creator) ? strdup(creator) : NULL;
+    channel->purpose.value = slack_arena_strdup(workspace->channels_arena,
+                                                purpose);
+    channel->purpose.creator = slack_arena_strdup(workspace->channels_arena,
+                                                  creator);
     channel->purpose.last_set = last_set;
 }
 
-struct t_slack_channel_member *slack_channel_add_member(
-                                struct t_slack_workspace *workspace,
-                                struct t_slack_channel *channel,
-                                const char *id)
+int slack_channel_add_member(struct t_slack_workspace *workspace,
+                             struct t_slack_channel *channel,
+                             const char *id)
 {
-    struct t_slack_channel_member *member;
     struct t_slack_user *user;
 
-    member = malloc(sizeof(struct t_slack_channel_member));
-    member->id = strdup(id);
-
-    member->prev_member = channel->last_member;
-    member->next_member = NULL;
-    if (channel->last_member)
-        (channel->last_member)->next_member = member;
-    else
-        channel->members = member;
-    channel->last_member = member;
+    if (!channel)
+        return 0;
 
+    /* members are stored by user index, so unknown users can't be added */
     user = slack_user_search(workspace, id);
-    if (user)
-        slack_user_nicklist_add(workspace, channel, user);
+    if (!user)
+        return 0;
+
+    if (!channel->members)
+    {
+        channel->members = slack_memberset_new();
+        if (!channel->members)
+            return 0;
+    }
+
+    if (slack_memberset_add(channel->members, user->index,
+                            workspace->users_index_count) <= 0)
+        return 0;
+    channel->members_generation++;
+
+    slack_user_nicklist_add(workspace, channel, user);
+
+    return 1;
+}
+
+static int slack_channel_members_sorted_cmp(const void *user1, const void *user2)
+{
+    return slack_user_sort_key_cmp(*(struct t_slack_user **)user1,
+                                   *(struct t_slack_user **)user2);
+}
+
+/*
+ * Returns the channel members sorted by display name (see
+ * slack_user_sort_key_cmp). The array is cached on the channel and rebuilt
+ * only after members were added or users were renamed or freed.
+ */
+
+struct t_slack_user **slack_channel_members_sorted(struct t_slack_workspace *workspace,
+                                                   struct t_slack_channel *channel,
+                                                   int *count)
+{
+    struct t_slack_user **new_sorted, *ptr_user;
+    uint32_t position, index;
+    int i;
+
+    *count = 0;
+    if (!workspace || !channel || !channel->members)
+        return NULL;
+
+    if (channel->members_sorted
+        && channel->members_sorted_generation == channel->members_generation
+        && channel->members_sorted_users_generation == workspace->users_generation)
+    {
+        *count = channel->members_sorted_count;
+        return channel->members_sorted;
+    }
+
+    if ((int)channel->members->count > channel->members_sorted_size
+        || !channel->members_sorted)
+    {
+        new_sorted = realloc(channel->members_sorted,
+                             (channel->members->count + 1) * sizeof(*new_sorted));
+        if (!new_sorted)
+            return NULL;
+        channel->members_sorted = new_sorted;
+        channel->members_sorted_size = channel->members->count + 1;
+    }
+
+    i = 0;
+    position = 0;
+    while (slack_memberset_next(channel->members, &position, &index)
+           && i < channel->members_sorted_size)
+    {
+        ptr_user = slack_user_search_index(workspace, index);
+        if (ptr_user)
+            channel->members_sorted[i++] = ptr_user;
+    }
+    qsort(channel->members_sorted, i, sizeof(*channel->members_sorted),
+          &slack_channel_members_sorted_cmp);
+
+    channel->members_sorted_count = i;
+    channel->members_sorted_generation = channel->members_generation;
+    channel->members_sorted_users_generation = workspace->users_generation;
 
-    return member;
+    *count = i;
+    return channel->members_sorted;
 }
@@ -6,9 +6,15 @@
 #define _SLACK_CHANNEL_H_
 
 #define SLACK_CHANNEL_MEMBERS_SPEAKING_LIMIT 128
+#define SLACK_CHANNEL_MEMBERS_SPEAKING_BUCKETS 64
 
 #define SLACK_CHANNEL_NAME_MAX_LEN 22
 
+/* seconds a typing notification is shown without being refreshed */
+#define SLACK_CHANNEL_TYPING_TIMEOUT 5
+
+#define SLACK_CHANNEL_TYPING_NOTIFICATION_MAX_LEN 255
+
 enum t_slack_channel_type
 {
     SLACK_CHANNEL_TYPE_CHANNEL,
@@ -19,20 +25,32 @@ enum t_slack_channel_type
 
 struct t_slack_channel_typing
 {
-    char *id;
-    char *name;
+    t_slack_id id;
+    const char *name; /* interned display name */
     time_t ts;
+    struct t_slack_channel *channel;
+    int heap_index; /* position in the workspace expiry heap */
 
     struct t_slack_channel_typing *prev_typing;
     struct t_slack_channel_typing *next_typing;
 };
 
-struct t_slack_channel_member
+struct t_slack_channel_speaker
 {
-    char *id;
+    t_slack_id id;
+    struct t_slack_channel_speaker *next_in_bucket;
+    struct t_slack_channel_speaker *prev_speaker; /* spoke earlier */
+    struct t_slack_channel_speaker *next_speaker; /* spoke later */
+};
 
-    struct t_slack_channel_member *prev_member;
-    struct t_slack_channel_member *next_member;
+/* bounded LRU of members who spoke recently, keyed by user id */
+struct t_slack_channel_speakers
+{
+    struct t_slack_channel_speaker entries[SLACK_CHANNEL_MEMBERS_SPEAKING_LIMIT];
+    struct t_slack_channel_speaker *buckets[SLACK_CHANNEL_MEMBERS_SPEAKING_BUCKETS];
+    struct t_slack_channel_speaker *oldest_speaker;
+    struct t_slack_channel_speaker *newest_speaker;
+    int count;
 };
 
 struct t_slack_channel_topic
@@ -52,7 +70,7 @@ struct t_slack_channel_purpose
 struct t_slack_channel
 {
     enum t_slack_channel_type type; 
-    char *id;
+    t_slack_id id;
     char *name;
     time_t created;
 
@@ -77,15 +95,24 @@ struct t_slack_channel
     /* im */
     int is_user_deleted;
 
-    struct t_hook *typing_hook_timer;
-    struct t_weelist *members_speaking[2];
+    struct t_slack_channel_speakers *members_speaking[2];
     struct t_slack_channel_typing *typings;
     struct t_slack_channel_typing *last_typing;
-    struct t_slack_channel_member *members;
-    struct t_slack_channel_member *last_member;
-    struct t_gui_buffer *buffer;
+    char *typing_notification; /* cached "X is typing..." */
+    int typing_changed;
+    struct t_slack_memberset *members;
+    unsigned int members_generation; /* bumped when members change */
+    struct t_slack_user **members_sorted; /* see slack_channel_members_sorted */
+    int members_sorted_count;
+    int members_sorted_size;
+    unsigned int members_sorted_generation;
+    unsigned int members_sorted_users_generation;
+    int nicklist_loaded; /* nicklist is filled when first displayed */
+    struct t_gui_buffer *buffer; /* NULL until the channel is opened */
+    int buffer_queued;
     char *buffer_as_string;
 
+    struct t_slack_workspace *workspace;
     struct t_slack_channel *prev_channel;
     struct t_slack_channel *next_channel;
 };
@@ -93,6 +120,9 @@ struct t_slack_channel
 struct t_slack_channel *slack_channel_search(struct t_slack_workspace *workspace,
                                              const char *id);
 
+struct t_slack_channel *slack_channel_search_id(struct t_slack_workspace *workspace,
+                                                t_slack_id id);
+
 void slack_channel_add_nicklist_groups(struct t_slack_workspace *workspace,
                                        struct t_slack_channel *channel);
 
@@ -100,48 +130,67 @@ struct t_slack_channel *slack_channel_new(struct t_slack_workspace *workspace,
                                           enum t_slack_channel_type type,
                                           const char *id, const char *name);
 
-void slack_channel_member_speaking_add(struct t_slack_channel *channel,
-                                       const char *nick, int highlight);
+struct t_slack_channel *slack_channel_search_name(struct t_slack_workspace *workspace,
+                                                  const char *name);
+
+struct t_gui_buffer *slack_channel_open_buffer(struct t_slack_workspace *workspace,
+                                               struct t_slack_channel *channel);
 
-void slack_channel_member_speaking_rename(struct t_slack_channel *channel,
-                                          const char *old_nick,
-                                          const char *new_nick);
+void slack_channel_queue_buffer(struct t_slack_workspace *workspace,
+                                struct t_slack_channel *channel);
 
-void slack_channel_member_speaking_rename_if_present(struct t_slack_workspace *workspace,
-                                                     struct t_slack_channel *channel,
-                                                     const char *nick);
+void slack_channel_open_queued_buffers(struct t_slack_workspace *workspace,
+                                       int max_buffers);
 
-void slack_channel_typing_free(struct t_slack_channel *channel,
+void slack_channel_member_speaking_add(struct t_slack_channel *channel,
+                                       struct t_slack_user *user,
+                                       int highlight);
+
+void slack_channel_typing_free(struct t_slack_workspace *workspace,
+                               struct t_slack_channel *channel,
                                struct t_slack_channel_typing *typing);
 
-void slack_channel_typing_free_all(struct t_slack_channel *channel);
+void slack_channel_typing_free_all(struct t_slack_workspace *workspace,
+                                   struct t_slack_channel *channel);
+
+void slack_channel_typing_remove(struct t_slack_workspace *workspace,
+                                 struct t_slack_channel *channel,
+                                 struct t_slack_channel_typing *typing);
 
 int slack_channel_typing_cb(const void *pointer,
                             void *data,
                             int remaining_calls);
 
+const char *slack_channel_typing_notification(struct t_slack_channel *channel);
+
 struct t_slack_channel_typing *slack_channel_typing_search(
                                 struct t_slack_channel *channel,
-                                const char *id);
+                                t_slack_id id);
 
-void slack_channel_add_typing(struct t_slack_channel *channel,
+void slack_channel_add_typing(struct t_slack_workspace *workspace,
+                              struct t_slack_channel *channel,
                               struct t_slack_user *user);
 
 void slack_channel_free_all(struct t_slack_workspace *workspace);
 
-void slack_channel_update_topic(struct t_slack_channel *channel,
+void slack_channel_update_topic(struct t_slack_workspace *workspace,
+                                struct t_slack_channel *channel,
                                 const char* title,
                                 const char* creator,
                                 int last_set);
 
-void slack_channel_update_purpose(struct t_slack_channel *channel,
+void slack_channel_update_purpose(struct t_slack_workspace *workspace,
+                                  struct t_slack_channel *channel,
                                   const char* purpose,
                                   const char* creator,
                                   int last_set);
 
-struct t_slack_channel_member *slack_channel_add_member(
-                                struct t_slack_workspace *workspace,
-                                struct t_slack_channel *channel,
-                                const char *id);
+int slack_channel_add_member(struct t_slack_workspace *workspace,
+                             struct t_slack_channel *channel,
+                             const char *id);
+
+struct t_slack_user **slack_channel_members_sorted(struct t_slack_workspace *workspace,
+                                                   struct t_slack_channel *channel,
+                                                   int *count);
 
 #endif /*SLACK_CHANNEL_H*/
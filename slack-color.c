@@ -0,0 +1,99 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, version 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "weechat-plugin.h"
+#include "slack.h"
+#include "slack-color.h"
+
+/*
+ * Escapes used on every rendered line, resolved once. weechat_color returns
+ * a rotating static buffer and weechat_prefix points into config data, so
+ * both are copied, and copied again whenever weechat options change.
+ */
+
+static const char *slack_color_names[SLACK_NUM_COLORS] =
+{ "reset", "resetcolor", "bold", "-bold", "italic", "-italic",
+  "chat_nick", "chat_value", "chat_delimiters" };
+
+static const char *slack_color_prefix_names[SLACK_NUM_COLOR_PREFIXES] =
+{ "error", "network", "action" };
+
+/* empty until slack_color_init, so lookups never see NULL */
+static char slack_color_empty[] = "";
+
+struct t_slack_color_escape slack_color_escapes[SLACK_NUM_COLORS] =
+{ [0 ... SLACK_NUM_COLORS - 1] = { slack_color_empty, 0 } };
+struct t_slack_color_escape slack_color_prefixes[SLACK_NUM_COLOR_PREFIXES] =
+{ [0 ... SLACK_NUM_COLOR_PREFIXES - 1] = { slack_color_empty, 0 } };
+
+static void slack_color_set(struct t_slack_color_escape *escape,
+                            const char *value)
+{
+    char *new_string;
+
+    new_string = strdup((value) ? value : "");
+    if (!new_string)
+        return;
+
+    if (escape->string != slack_color_empty)
+        free(escape->string);
+    escape->string = new_string;
+    escape->length = strlen(new_string);
+}
+
+static void slack_color_refresh()
+{
+    int i;
+
+    for (i = 0; i < SLACK_NUM_COLORS; i++)
+        slack_color_set(&slack_color_escapes[i],
+                        weechat_color(slack_color_names[i]));
+
+    for (i = 0; i < SLACK_NUM_COLOR_PREFIXES; i++)
+        slack_color_set(&slack_color_prefixes[i],
+                        weechat_prefix(slack_color_prefix_names[i]));
+}
+
+int slack_color_config_cb(const void *pointer, void *data,
+                          const char *option, const char *value)
+{
+    /* make C compiler happy */
+    (void) pointer;
+    (void) data;
+    (void) option;
+    (void) value;
+
+    slack_color_refresh();
+
+    return WEECHAT_RC_OK;
+}
+
+void slack_color_init()
+{
+    slack_color_refresh();
+}
+
+void slack_color_end()
+{
+    int i;
+
+    for (i = 0; i < SLACK_NUM_COLORS; i++)
+    {
+        if (slack_color_escapes[i].string != slack_color_empty)
+            free(slack_color_escapes[i].string);
+        slack_color_escapes[i].string = slack_color_empty;
+        slack_color_escapes[i].length = 0;
+    }
+
+    for (i = 0; i < SLACK_NUM_COLOR_PREFIXES; i++)
+    {
+        if (slack_color_prefixes[i].string != slack_color_empty)
+            free(slack_color_prefixes[i].string);
+        slack_color_prefixes[i].string = slack_color_empty;
+        slack_color_prefixes[i].length = 0;
+    }
+}
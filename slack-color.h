@@ -0,0 +1,54 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, version 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef _SLACK_COLOR_H_
+#define _SLACK_COLOR_H_
+
+enum t_slack_color
+{
+    SLACK_COLOR_RESET = 0,
+    SLACK_COLOR_RESETCOLOR,
+    SLACK_COLOR_BOLD,
+    SLACK_COLOR_UNBOLD,
+    SLACK_COLOR_ITALIC,
+    SLACK_COLOR_UNITALIC,
+    SLACK_COLOR_CHAT_NICK,
+    SLACK_COLOR_CHAT_VALUE,
+    SLACK_COLOR_CHAT_DELIMITERS,
+    /* number of colors */
+    SLACK_NUM_COLORS,
+};
+
+enum t_slack_color_prefix
+{
+    SLACK_COLOR_PREFIX_ERROR = 0,
+    SLACK_COLOR_PREFIX_NETWORK,
+    SLACK_COLOR_PREFIX_ACTION,
+    /* number of prefixes */
+    SLACK_NUM_COLOR_PREFIXES,
+};
+
+struct t_slack_color_escape
+{
+    char *string;
+    int length;
+};
+
+extern struct t_slack_color_escape slack_color_escapes[SLACK_NUM_COLORS];
+extern struct t_slack_color_escape slack_color_prefixes[SLACK_NUM_COLOR_PREFIXES];
+
+#define SLACK_COLOR(__color) (slack_color_escapes[__color].string)
+
+#define SLACK_PREFIX_ERROR (slack_color_prefixes[SLACK_COLOR_PREFIX_ERROR].string)
+#define SLACK_PREFIX_NETWORK (slack_color_prefixes[SLACK_COLOR_PREFIX_NETWORK].string)
+#define SLACK_PREFIX_ACTION (slack_color_prefixes[SLACK_COLOR_PREFIX_ACTION].string)
+
+int slack_color_config_cb(const void *pointer, void *data,
+                          const char *option, const char *value);
+
+void slack_color_init();
+
+void slack_color_end();
+
+#endif /*SLACK_COLOR_H*/
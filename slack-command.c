@@ -8,11 +8,13 @@
 
 #include "weechat-plugin.h"
 #include "slack.h"
+#include "slack-id.h"
 #include "slack-oauth.h"
 #include "slack-teaminfo.h"
 #include "slack-workspace.h"
 #include "slack-channel.h"
 #include "slack-buffer.h"
+#include "slack-emoji.h"
 #include "slack-message.h"
 #include "slack-command.h"
 #include "request/slack-request-chat-memessage.h"
@@ -20,14 +22,17 @@
 void slack_command_display_workspace(struct t_slack_workspace *workspace)
 {
     int num_channels, num_pv;
+    char *str_memory;
 
     if (workspace->is_connected)
     {
         num_channels = 0;//slack_workspace_get_channel_count(workspace);
         num_pv = 0;//slack_workspace_get_pv_count(workspace);
+        str_memory = weechat_string_format_size(
+            slack_workspace_memory(workspace));
         weechat_printf(
             NULL,
-            " %s %s%s%s.slack.com %s(%s%s%s) [%s%s%s]%s, %d %s, %d pv",
+            " %s %s%s%s.slack.com %s(%s%s%s) [%s%s%s]%s, %d %s, %d pv, %s",
             (workspace->is_connected) ? "*" : " ",
             weechat_color("chat_server"),
             workspace->domain,
@@ -44,7 +49,10 @@ void slack_command_display_workspace(struct t_slack_workspace *workspace)
             weechat_color("reset"),
             num_channels,
             NG_("channel", "channels", num_channels),
-            num_pv);
+            num_pv,
+            (str_memory) ? str_memory : "?");
+        if (str_memory)
+            free(str_memory);
     }
     else
     {
@@ -303,6 +311,127 @@ void slack_command_workspace_delete(int argc, char **argv)
         free(workspace_domain);
 }
 
+void slack_command_channel_open(struct t_gui_buffer *buffer,
+                                int argc, char **argv)
+{
+    struct t_slack_workspace *ptr_workspace = NULL;
+    struct t_slack_channel *ptr_channel = NULL;
+    struct t_gui_buffer *ptr_buffer;
+
+    if (argc < 3)
+    {
+        weechat_printf(
+            NULL,
+            _("%sToo few arguments for command\"%s %s\" "
+              "(help on command: /help %s)"),
+            weechat_prefix("error"),
+            argv[0], argv[1], argv[0] + 1);
+        return;
+    }
+
+    slack_buffer_get_workspace_and_channel(buffer, &ptr_workspace, &ptr_channel);
+    if (!ptr_workspace)
+    {
+        weechat_printf(
+            NULL,
+            _("%s%s: \"%s\" command must be executed on a slack buffer"),
+            weechat_prefix("error"), SLACK_PLUGIN_NAME, "slack open");
+        return;
+    }
+
+    ptr_channel = slack_channel_search_name(ptr_workspace, argv[2]);
+    if (!ptr_channel)
+    {
+        weechat_printf(
+            buffer,
+            _("%s%s: channel \"%s\" not found"),
+            weechat_prefix("error"), SLACK_PLUGIN_NAME, argv[2]);
+        return;
+    }
+
+    ptr_buffer = slack_channel_open_buffer(ptr_workspace, ptr_channel);
+    if (ptr_buffer)
+        weechat_buffer_set(ptr_buffer, "display", "1");
+}
+
+void slack_command_display_event_counters(const char *title,
+                                          struct t_hashtable *counters)
+{
+    const char *keys;
+    char **types;
+    int *count, num_types, i;
+
+    keys = weechat_hashtable_get_string(counters, "keys_sorted");
+    types = weechat_string_split(keys, ",", 0, 0, &num_types);
+    if (num_types > 0)
+        weechat_printf(NULL, "  %s:", title);
+    for (i = 0; i < num_types; i++)
+    {
+        count = weechat_hashtable_get(counters, types[i]);
+        weechat_printf(NULL, "    %s%s%s: %d",
+                       weechat_color("chat_value"), types[i],
+                       weechat_color("reset"), (count) ? *count : 0);
+    }
+    weechat_string_free_split(types);
+}
+
+void slack_command_workspace_stats(struct t_gui_buffer *buffer,
+                                   int argc, char **argv)
+{
+    struct t_slack_workspace *ptr_workspace = NULL;
+    struct t_slack_channel *ptr_channel = NULL;
+
+    if (argc > 2)
+        ptr_workspace = slack_workspace_search(argv[2]);
+    else
+        slack_buffer_get_workspace_and_channel(buffer, &ptr_workspace,
+                                               &ptr_channel);
+    if (!ptr_workspace)
+    {
+        weechat_printf(
+            NULL,
+            _("%s%s: workspace not found"),
+            weechat_prefix("error"), SLACK_PLUGIN_NAME);
+        return;
+    }
+
+    weechat_printf(NULL, "");
+    weechat_printf(NULL,
+                   _("Events on %s%s.slack.com%s: %lu received, "
+                     "%lu unhandled, %lu dropped unparsed"),
+                   weechat_color("chat_server"), ptr_workspace->domain,
+                   weechat_color("reset"),
+                   ptr_workspace->events_received,
+                   ptr_workspace->events_unhandled,
+                   ptr_workspace->events_dropped);
+
+    slack_command_display_event_counters(
+        _("handled"), ptr_workspace->events_handled_by_type);
+    slack_command_display_event_counters(
+        _("unhandled"), ptr_workspace->events_unhandled_by_type);
+    slack_command_display_event_counters(
+        _("dropped (slack.network.ignored_events)"),
+        ptr_workspace->events_dropped_by_type);
+}
+
+void slack_command_emoji(struct t_gui_buffer *buffer)
+{
+    struct t_slack_workspace *ptr_workspace = NULL;
+    struct t_slack_channel *ptr_channel = NULL;
+
+    slack_buffer_get_workspace_and_channel(buffer, &ptr_workspace, &ptr_channel);
+    if (!ptr_workspace)
+    {
+        weechat_printf(
+            NULL,
+            _("%s%s: \"%s\" command must be executed on a slack buffer"),
+            weechat_prefix("error"), SLACK_PLUGIN_NAME, "slack emoji");
+        return;
+    }
+
+    slack_emoji_input_complete(buffer);
+}
+
 int slack_command_slack(const void *pointer, void *data,
                         struct t_gui_buffer *buffer, int argc,
                         char **argv, char **argv_eol)
@@ -310,7 +439,7 @@ int slack_command_slack(const void *pointer, void *data,
     /* make C compiler happy */
     (void) pointer;
     (void) data;
-    (void) buffer;
+    (void) argv_eol;
 
     if (argc <= 1 || weechat_strcasecmp(argv[1], "list") == 0)
     {
@@ -338,6 +467,24 @@ int slack_command_slack(const void *pointer, void *data,
             return WEECHAT_RC_OK;
         }
 
+        if (weechat_strcasecmp(argv[1], "open") == 0)
+        {
+            slack_command_channel_open(buffer, argc, argv);
+            return WEECHAT_RC_OK;
+        }
+
+        if (weechat_strcasecmp(argv[1], "stats") == 0)
+        {
+            slack_command_workspace_stats(buffer, argc, argv);
+            return WEECHAT_RC_OK;
+        }
+
+        if (weechat_strcasecmp(argv[1], "emoji") == 0)
+        {
+            slack_command_emoji(buffer);
+            return WEECHAT_RC_OK;
+        }
+
         WEECHAT_COMMAND_ERROR;
     }
 
@@ -351,6 +498,7 @@ int slack_command_me(const void *pointer, void *data,
     struct t_slack_workspace *ptr_workspace = NULL;
     struct t_slack_channel *ptr_channel = NULL;
     struct t_slack_request *request;
+    char channel_id[SLACK_ID_MAX_LEN + 1];
     char *text;
     
     /* make C compiler happy */
@@ -396,7 +544,7 @@ int slack_command_me(const void *pointer, void *data,
         request = slack_request_chat_memessage(ptr_workspace,
                     weechat_config_string(
                         ptr_workspace->options[SLACK_WORKSPACE_OPTION_TOKEN]),
-                    ptr_channel->id, text);
+                    slack_id_decode(ptr_channel->id, channel_id), text);
         if (request)
             slack_workspace_register_request(ptr_workspace, request);
 
@@ -414,15 +562,27 @@ void slack_command_init()
         N_("list"
            " || register [token]"
            " || connect <workspace>"
-           " || delete <workspace>"),
+           " || delete <workspace>"
+           " || open <channel>"
+           " || stats [<workspace>]"
+           " || emoji"),
         N_("    list: list workspaces\n"
            "register: add a slack workspace\n"
            " connect: connect to a slack workspace\n"
-           "  delete: delete a slack workspace\n"),
+           "  delete: delete a slack workspace\n"
+           "    open: open the buffer of a channel of the current workspace\n"
+           "   stats: show event counters of a workspace (default: current "
+           "one), by type: handled, unhandled and dropped unparsed\n"
+           "   emoji: replace the \":word\" at the cursor with the closest "
+           "emoji name, for misspelt names (Tab only completes prefixes); "
+           "bind it to a key, for example: /key bind meta-: /slack emoji\n"),
         "list"
         " || register %(slack_token)"
         " || connect %(slack_workspace)"
-        " || delete %(slack_workspace)",
+        " || delete %(slack_workspace)"
+        " || open %(slack_channels)"
+        " || stats %(slack_workspace)"
+        " || emoji",
         &slack_command_slack, NULL, NULL);
 
     weechat_hook_command(
@@ -8,11 +8,13 @@
 
 #include "weechat-plugin.h"
 #include "slack.h"
+#include "slack-id.h"
 #include "slack-config.h"
-#include "slack-emoji.h"
 #include "slack-workspace.h"
+#include "slack-emoji.h"
 #include "slack-channel.h"
 #include "slack-user.h"
+#include "slack-memberset.h"
 #include "slack-buffer.h"
 #include "slack-completion.h"
 
@@ -21,25 +23,20 @@ void slack_completion_channel_nicks_add_speakers(struct t_gui_completion *comple
                                                  struct t_slack_channel *channel,
                                                  int highlight)
 {
+    struct t_slack_channel_speaker *ptr_speaker;
     struct t_slack_user *user;
-    const char *member;
-    int list_size, i;
 
     if (channel->members_speaking[highlight])
     {
-        list_size = weechat_list_size(channel->members_speaking[highlight]);
-        for (i = 0; i < list_size; i++)
+        /* oldest first, so the most recent speaker ends up first */
+        for (ptr_speaker = channel->members_speaking[highlight]->oldest_speaker;
+             ptr_speaker; ptr_speaker = ptr_speaker->next_speaker)
         {
-            member = weechat_list_string (
-                weechat_list_get(channel->members_speaking[highlight], i));
-            if (member)
-            {
-                user = slack_user_search(workspace, member);
-                if (user)
-                    weechat_hook_completion_list_add(completion,
-                                                     user->profile.display_name,
-                                                     1, WEECHAT_LIST_POS_BEGINNING);
-            }
+            user = slack_user_search_id(workspace, ptr_speaker->id);
+            if (user)
+                weechat_hook_completion_list_add(completion,
+                                                 user->profile.display_name,
+                                                 1, WEECHAT_LIST_POS_BEGINNING);
         }
     }
 }
@@ -51,8 +48,8 @@ int slack_completion_channel_nicks_cb(const void *pointer, void *data,
 {
     struct t_slack_workspace *ptr_workspace;
     struct t_slack_channel *ptr_channel;
-    struct t_slack_channel_member *ptr_member;
-    struct t_slack_user *ptr_user;
+    struct t_slack_user **users;
+    int i, count;
 
     /* make C compiler happy */
     (void) pointer;
@@ -71,15 +68,13 @@ int slack_completion_channel_nicks_cb(const void *pointer, void *data,
         case SLACK_CHANNEL_TYPE_GROUP:
         case SLACK_CHANNEL_TYPE_MPIM:
         case SLACK_CHANNEL_TYPE_IM:
-            for (ptr_member = ptr_channel->members; ptr_member;
-                    ptr_member = ptr_member->next_member)
-            {
-                ptr_user = slack_user_search(ptr_workspace, ptr_member->id);
-                if (ptr_user)
-                    weechat_hook_completion_list_add(completion,
-                                                     ptr_user->profile.display_name,
-                                                     1, WEECHAT_LIST_POS_SORT);
-            }
+            /* members come sorted, so each insert lands at the end */
+            users = slack_channel_members_sorted(ptr_workspace, ptr_channel,
+                                                 &count);
+            for (i = 0; i < count; i++)
+                weechat_hook_completion_list_add(completion,
+                                                 users[i]->profile.display_name,
+                                                 1, WEECHAT_LIST_POS_SORT);
             /* add recent speakers on channel */
             if (weechat_config_integer(slack_config_look_nick_completion_smart) == SLACK_CONFIG_NICK_COMPLETION_SMART_SPEAKERS)
             {
@@ -124,6 +119,43 @@ int slack_completion_workspaces_cb(const void *pointer, void *data,
     return WEECHAT_RC_OK;
 }
 
+void slack_completion_channels_add_cb(void *data,
+                                      struct t_hashtable *hashtable,
+                                      const void *key, const void *value)
+{
+    /* make C compiler happy */
+    (void) hashtable;
+    (void) value;
+
+    weechat_hook_completion_list_add((struct t_gui_completion *)data,
+                                     (const char *)key,
+                                     0, WEECHAT_LIST_POS_SORT);
+}
+
+int slack_completion_channels_cb(const void *pointer, void *data,
+                                 const char *completion_item,
+                                 struct t_gui_buffer *buffer,
+                                 struct t_gui_completion *completion)
+{
+    struct t_slack_workspace *ptr_workspace;
+
+    /* make C compiler happy */
+    (void) pointer;
+    (void) data;
+    (void) completion_item;
+
+    ptr_workspace = NULL;
+    slack_buffer_get_workspace_and_channel(buffer, &ptr_workspace, NULL);
+
+    /* every known channel, with or without a buffer */
+    if (ptr_workspace && ptr_workspace->channels_by_name)
+        weechat_hashtable_map(ptr_workspace->channels_by_name,
+                              &slack_completion_channels_add_cb,
+                              completion);
+
+    return WEECHAT_RC_OK;
+}
+
 void slack_completion_init()
 {
     struct t_config_option *option;
@@ -140,6 +172,11 @@ void slack_completion_init()
                             &slack_completion_workspaces_cb,
                             NULL, NULL);
 
+    weechat_hook_completion("slack_channels",
+                            N_("channels of current slack workspace"),
+                            &slack_completion_channels_cb,
+                            NULL, NULL);
+
     weechat_hook_completion("slack_emoji",
                             N_("slack emoji"),
                             &slack_emoji_complete_by_name_cb,
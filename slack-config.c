@@ -16,6 +16,12 @@ struct t_config_section *slack_config_section_workspace_default;
 struct t_config_section *slack_config_section_workspace;
 
 struct t_config_option *slack_config_look_nick_completion_smart;
+struct t_config_option *slack_config_look_render_mrkdwn;
+struct t_config_option *slack_config_look_replace_emoticons;
+
+struct t_config_option *slack_config_network_ignored_events;
+
+struct t_hashtable *slack_config_hashtable_ignored_events = NULL;
 
 struct t_config_option *slack_config_workspace_default[SLACK_WORKSPACE_NUM_OPTIONS];
 
@@ -38,6 +44,40 @@ void slack_config_workspace_change_cb(const void *pointer, void *data,
     (void) option;
 }
 
+/*
+ * Rebuilds the set of ignored event types from its option.
+ */
+
+void slack_config_change_network_ignored_events(const void *pointer, void *data,
+                                                struct t_config_option *option)
+{
+    char **types;
+    int num_types, i;
+
+    (void) pointer;
+    (void) data;
+    (void) option;
+
+    if (!slack_config_hashtable_ignored_events)
+    {
+        slack_config_hashtable_ignored_events = weechat_hashtable_new(
+            32, WEECHAT_HASHTABLE_STRING, WEECHAT_HASHTABLE_POINTER,
+            NULL, NULL);
+        if (!slack_config_hashtable_ignored_events)
+            return;
+    }
+    else
+        weechat_hashtable_remove_all(slack_config_hashtable_ignored_events);
+
+    types = weechat_string_split(
+        weechat_config_string(slack_config_network_ignored_events),
+        ",", 0, 0, &num_types);
+    for (i = 0; i < num_types; i++)
+        weechat_hashtable_set(slack_config_hashtable_ignored_events,
+                              types[i], NULL);
+    weechat_string_free_split(types);
+}
+
 void slack_config_workspace_default_change_cb(const void *pointer, void *data,
                                               struct t_config_option *option)
 {
@@ -270,6 +310,52 @@ int slack_config_init()
         "off|speakers|speakers_highlights", 0, 0, "speakers", NULL, 0,
         NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
 
+    slack_config_look_render_mrkdwn = weechat_config_new_option (
+        slack_config_file, ptr_section,
+        "render_mrkdwn", "boolean",
+        N_("render *bold*, _italic_, ~strike~ and `code` in messages with "
+           "weechat attributes; when off, the markers are shown as sent"),
+        NULL, 0, 0, "on", NULL, 0,
+        NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
+
+    slack_config_look_replace_emoticons = weechat_config_new_option (
+        slack_config_file, ptr_section,
+        "replace_emoticons", "boolean",
+        N_("replace emoticons typed as whole words (like \":)\" or \"<3\") "
+           "with the shortcode of their emoji in sent messages, "
+           "except in `code`"),
+        NULL, 0, 0, "off", NULL, 0,
+        NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
+
+    ptr_section = weechat_config_new_section(
+            slack_config_file, "network",
+            0, 0,
+            NULL, NULL, NULL,
+            NULL, NULL, NULL,
+            NULL, NULL, NULL,
+            NULL, NULL, NULL,
+            NULL, NULL, NULL);
+
+    if (!ptr_section)
+    {
+        weechat_config_free(slack_config_file);
+        slack_config_file = NULL;
+        return 0;
+    }
+
+    slack_config_network_ignored_events = weechat_config_new_option (
+        slack_config_file, ptr_section,
+        "ignored_events", "string",
+        N_("comma-separated list of real-time event types dropped as soon "
+           "as they are received, before being parsed (see /slack stats "
+           "for the types received)"),
+        NULL, 0, 0,
+        "presence_change,pref_change,desktop_notification,reconnect_url,pong",
+        NULL, 0,
+        NULL, NULL, NULL,
+        &slack_config_change_network_ignored_events, NULL, NULL,
+        NULL, NULL, NULL);
+
     ptr_section = weechat_config_new_section(
             slack_config_file, "workspace_default",
             0, 0,
@@ -317,6 +403,8 @@ int slack_config_read()
 
     rc = weechat_config_read(slack_config_file);
 
+    slack_config_change_network_ignored_events(NULL, NULL, NULL);
+
     return rc;
 }
 
@@ -327,4 +415,9 @@ int slack_config_write()
 
 void slack_config_free()
 {
+    if (slack_config_hashtable_ignored_events)
+    {
+        weechat_hashtable_free(slack_config_hashtable_ignored_events);
+        slack_config_hashtable_ignored_events = NULL;
+    }
 }
@@ -20,6 +20,12 @@ extern struct t_config_section *slack_config_section_workspace_default;
 extern struct t_config_section *slack_config_section_workspace;
 
 extern struct t_config_option *slack_config_look_nick_completion_smart;
+extern struct t_config_option *slack_config_look_render_mrkdwn;
+extern struct t_config_option *slack_config_look_replace_emoticons;
+
+extern struct t_config_option *slack_config_network_ignored_events;
+
+extern struct t_hashtable *slack_config_hashtable_ignored_events;
 
 extern struct t_config_option *slack_config_workspace_default[];
 
@@ -8,9 +8,11 @@
 
 #include "weechat-plugin.h"
 #include "slack.h"
+#include "slack-id.h"
 #include "slack-workspace.h"
 #include "slack-channel.h"
 #include "slack-buffer.h"
+#include "slack-config.h"
 #include "slack-emoji.h"
 
 #include "slack-emoji.inc"
@@ -18,272 +20,540 @@
 #define MIN(a,b) (((a)<(b))?(a):(b))
 #define MAX(a,b) (((a)>(b))?(a):(b))
 
-static int emoji_byname_cmp(const void *p1, const void *p2)
+/* longest typed word considered for fuzzy completion */
+#define SLACK_EMOJI_COMPLETE_MAX_LEN 64
+
+#define SLACK_EMOJI_MATCH_COMMON_UNKNOWN ((size_t)-1)
+
+struct t_slack_emoji_match
+{
+    const char *name;
+    size_t distance;
+    size_t common;
+};
+
+/*
+ * FNV-1a then a 64-bit finalizer; must match emoji_hash() in slack-emoji.py.
+ */
+
+static uint64_t slack_emoji_hash(const char *key, size_t length, int fold)
+{
+    uint64_t hash;
+    unsigned char c;
+    size_t i;
+
+    hash = 0xcbf29ce484222325ULL;
+    for (i = 0; i < length; i++)
+    {
+        c = (unsigned char)key[i];
+        if (fold && c >= 'A' && c <= 'Z')
+            c += 'a' - 'A';
+        hash ^= c;
+        hash *= 0x100000001b3ULL;
+    }
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+
+    return hash;
+}
+
+static uint32_t slack_emoji_slot(uint64_t hash, uint32_t displacement,
+                                 uint32_t count)
+{
+    uint32_t x;
+
+    x = (uint32_t)hash ^ displacement;
+    x ^= x >> 16;
+    x *= 0x85ebca6bU;
+    x ^= x >> 13;
+    x *= 0xc2b2ae35U;
+    x ^= x >> 16;
+
+    return x % count;
+}
+
+static struct t_slack_emoji_by_name *slack_emoji_search_name(const char *name,
+                                                             size_t length)
 {
-    return strcasecmp(((struct t_slack_emoji_by_name *)p1)->name,
-                      ((struct t_slack_emoji_by_name *)p2)->name);
+    struct t_slack_emoji_by_name *emoji;
+    uint64_t hash;
+    uint32_t slot;
+
+    hash = slack_emoji_hash(name, length, 1);
+    slot = slack_emoji_slot(hash,
+                            slack_emoji_by_name_displacements[
+                                (hash >> 32) % SLACK_EMOJI_BY_NAME_BUCKETS],
+                            SLACK_EMOJI_BY_NAME_COUNT);
+    emoji = &slack_emoji_by_name[slack_emoji_by_name_slots[slot]];
+
+    if (strncasecmp(emoji->name, name, length) != 0 || emoji->name[length])
+        return NULL;
+
+    return emoji;
 }
 
-static int emoji_bytext_cmp(const void *p1, const void *p2)
+static struct t_slack_emoji_by_text *slack_emoji_search_text(const char *text,
+                                                             size_t length)
 {
-    return strcasecmp(((struct t_slack_emoji_by_text *)p1)->text,
-                      ((struct t_slack_emoji_by_text *)p2)->text);
+    struct t_slack_emoji_by_text *emoji;
+    uint64_t hash;
+    uint32_t slot;
+
+    hash = slack_emoji_hash(text, length, 0);
+    slot = slack_emoji_slot(hash,
+                            slack_emoji_by_text_displacements[
+                                (hash >> 32) % SLACK_EMOJI_BY_TEXT_BUCKETS],
+                            SLACK_EMOJI_BY_TEXT_COUNT);
+    emoji = &slack_emoji_by_text[slack_emoji_by_text_slots[slot]];
+
+    if (strncmp(emoji->text, text, length) != 0 || emoji->text[length])
+        return NULL;
+
+    return emoji;
 }
 
-static size_t modified_wagner_fischer(const char *src, const char *targ)
+/*
+ * Edit distance from an emoji name to the typed word, where dropping
+ * characters of the name is free (so a name containing the word scores 0).
+ * The row minimum never decreases, so give up with limit + 1 as soon as it
+ * exceeds limit.
+ */
+
+static size_t slack_emoji_distance(const char *name,
+                                   const char *word, size_t length,
+                                   size_t limit)
 {
-    size_t len = strlen(targ) + 1;
-    size_t above[len], below[len];
-    for (size_t *k = above, c = 0; k < above + len; ++k, ++c) *k = c;
+    size_t above[SLACK_EMOJI_COMPLETE_MAX_LEN + 1];
+    size_t below[SLACK_EMOJI_COMPLETE_MAX_LEN + 1];
+    size_t j, k, row_min;
 
-    const char *src_at = src, *targ_at;
-    for (size_t j = 1; j < strlen(src) + 1; ++j)
+    for (k = 0; k <= length; k++)
+        above[k] = k;
+
+    for (j = 1; name[j - 1]; j++)
     {
-        *below = j;
-        targ_at = targ;
-        for (size_t *d = above, *a = above + 1, *l = below, *c = below + 1;
-             c < below + len; ++d, ++a, ++l, ++c)
+        below[0] = j;
+        row_min = j;
+        for (k = 1; k <= length; k++)
         {
-            /*        |-------------replace-----------|       |isrt|  |delt|   */
-            *c = MIN( *src_at == *targ_at ? *d : *d + 1, MIN( *a + 0, *l + 1 ) );
-            ++targ_at;
+            /*          |--------------replace---------------|  |isrt|  |delt|   */
+            below[k] = MIN(name[j - 1] == word[k - 1] ? above[k - 1] : above[k - 1] + 1,
+                           MIN(above[k] + 0, below[k - 1] + 1));
+            row_min = MIN(row_min, below[k]);
         }
-        for (size_t *a = above, *b = below; a < above + len; ++a, ++b) *a = *b;
-        ++src_at;
+        memcpy(above, below, (length + 1) * sizeof(above[0]));
+        if (row_min > limit)
+            return limit + 1;
     }
 
-    return above[len-1];
+    return above[length];
 }
 
-static size_t longest_common_substring(const char *X, const char *Y)
+static size_t slack_emoji_common_substring(const char *name,
+                                           const char *word, size_t length)
 {
-    const size_t n = strlen(X);
-    const size_t m = strlen(Y);
-    size_t i, j, result = 0;
-    size_t **L;
-
-    L = malloc(sizeof(size_t *) * (n + 1));
-    L[0] = malloc(sizeof(size_t) * (m + 1) * (n + 1));
-    
-    for (i = 0; i <= n; i++)
-        L[i] = (*L + (m + 1) * i);
-  
-    /* Following steps build L[n+1][m+1] in bottom up fashion. Note 
-       that L[i][j] contains length of LCS of X[0..i-1] and Y[0..j-1] */
-    for (i = 0; i <= n; i++)
+    size_t previous[SLACK_EMOJI_COMPLETE_MAX_LEN + 1];
+    size_t current[SLACK_EMOJI_COMPLETE_MAX_LEN + 1];
+    size_t i, k, result;
+
+    result = 0;
+    memset(previous, 0, sizeof(previous));
+    current[0] = 0;
+    for (i = 0; name[i]; i++)
     {
-        for (j = 0; j <= m; j++)
+        for (k = 1; k <= length; k++)
         {
-            if (i == 0 || j == 0)
-            {
-                L[i][j] = 0;
-            }
-            else if (X[i-1] == Y[j-1])
-            {
-                L[i][j] = L[i - 1][j - 1] + 1;
-                if (result < L[i][j])
-                    result = L[i][j];
-            }
-            else
-            {
-                L[i][j] = 0;
-            }
+            current[k] = (name[i] == word[k - 1]) ? previous[k - 1] + 1 : 0;
+            result = MAX(result, current[k]);
         }
+        memcpy(previous, current, (length + 1) * sizeof(previous[0]));
     }
-    
-    /* result now contains length of LCS for X[0..n-1] and Y[0..m-1] */
-    free(L[0]);
-    free(L);
+
     return result;
 }
 
+/*
+ * Keeps the best completion seen so far: lowest distance, then longest
+ * common substring with the word (computed only to break ties).
+ */
+
+static void slack_emoji_match(struct t_slack_emoji_match *best,
+                              const char *name,
+                              const char *word, size_t length)
+{
+    size_t distance, common;
+
+    distance = slack_emoji_distance(name, word, length,
+                                    (best->name) ? best->distance : length);
+    if (best->name && distance > best->distance)
+        return;
+
+    common = 0;
+    if (best->name && distance == best->distance)
+    {
+        if (best->common == SLACK_EMOJI_MATCH_COMMON_UNKNOWN)
+            best->common = slack_emoji_common_substring(best->name,
+                                                        word, length);
+        common = slack_emoji_common_substring(name, word, length);
+        if (common <= best->common)
+            return;
+    }
+    else
+        common = SLACK_EMOJI_MATCH_COMMON_UNKNOWN;
+
+    best->name = name;
+    best->distance = distance;
+    best->common = common;
+}
+
+/*
+ * Returns the index of the first builtin emoji whose name is not before
+ * prefix (names are lowercase, compared case-insensitively).
+ */
+
+static size_t slack_emoji_lower_bound(const char *prefix, size_t length)
+{
+    size_t low, high, middle;
+
+    low = 0;
+    high = SLACK_EMOJI_BY_NAME_COUNT;
+    while (low < high)
+    {
+        middle = low + (high - low) / 2;
+        if (strncasecmp(slack_emoji_by_name[middle].name, prefix, length) < 0)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    return low;
+}
+
+static int slack_emoji_workspace_lower_bound(struct t_slack_workspace_emoji **emoji,
+                                             int count,
+                                             const char *prefix, size_t length)
+{
+    int low, high, middle;
+
+    low = 0;
+    high = count;
+    while (low < high)
+    {
+        middle = low + (high - low) / 2;
+        if (strncasecmp(emoji[middle]->name, prefix, length) < 0)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    return low;
+}
+
 int slack_emoji_complete_by_name_cb(const void *pointer, void *data,
                                     const char *completion_item,
                                     struct t_gui_buffer *buffer,
                                     struct t_gui_completion *completion)
 {
-    struct t_slack_workspace_emoji *ptr_emoji;
+    struct t_slack_workspace_emoji **workspace_emoji;
     struct t_slack_workspace *workspace;
     struct t_slack_channel *channel;
-    
+    const char *base_word;
+    size_t i, length;
+    int j, count;
+
     (void) pointer;
     (void) data;
     (void) completion_item;
 
     workspace = NULL;
     slack_buffer_get_workspace_and_channel(buffer, &workspace, &channel);
+    if (!workspace)
+        return WEECHAT_RC_OK;
 
-    size_t i, emoji_count = sizeof(slack_emoji_by_name)
-        / sizeof(struct t_slack_emoji_by_name);
-
-    if (workspace)
-    {
-        for (ptr_emoji = workspace->emoji; ptr_emoji;
-             ptr_emoji = ptr_emoji->next_emoji)
-            weechat_hook_completion_list_add(completion,
-                                            ptr_emoji->name,
-                                            0, WEECHAT_LIST_POS_END);
-    
-        for (i = 0; i < emoji_count; i++)
-            weechat_hook_completion_list_add(completion,
-                                            slack_emoji_by_name[i].name,
-                                            0, WEECHAT_LIST_POS_END);
-    }
+    /* the item is in the default template: only emoji words pay for it */
+    base_word = weechat_hook_completion_get_string(completion, "base_word");
+    if (!base_word || base_word[0] != ':')
+        return WEECHAT_RC_OK;
+    length = strlen(base_word);
+
+    workspace_emoji = slack_workspace_emoji_sorted(workspace, &count);
+    for (j = slack_emoji_workspace_lower_bound(workspace_emoji, count,
+                                               base_word, length);
+         j < count
+             && strncasecmp(workspace_emoji[j]->name, base_word, length) == 0;
+         j++)
+        weechat_hook_completion_list_add(completion,
+                                         workspace_emoji[j]->name,
+                                         0, WEECHAT_LIST_POS_END);
+
+    for (i = slack_emoji_lower_bound(base_word, length);
+         i < SLACK_EMOJI_BY_NAME_COUNT
+             && strncasecmp(slack_emoji_by_name[i].name, base_word, length) == 0;
+         i++)
+        weechat_hook_completion_list_add(completion,
+                                         slack_emoji_by_name[i].name,
+                                         0, WEECHAT_LIST_POS_END);
 
     return WEECHAT_RC_OK;
 }
 
-int slack_emoji_input_complete_cb(const void *pointer, void *data,
-                                  struct t_gui_buffer *buffer,
-                                  const char *command)
+/*
+ * Replaces the ":word" at the cursor with the closest emoji name, for
+ * misspelt names that prefix completion can't reach.
+ *
+ * Returns 1 if the input was changed.
+ */
+
+int slack_emoji_input_complete(struct t_gui_buffer *buffer)
 {
-    struct t_slack_emoji_by_name *closest_emoji;
+    struct t_slack_workspace_emoji *ptr_emoji;
+    struct t_slack_workspace *workspace;
+    struct t_slack_channel *channel;
+    struct t_slack_emoji_match best;
     int input_pos, input_length, start, end;
-    char *new_string, *word, *new_pos;
+    char *new_string, new_pos[32];
     const char *input_string;
+    size_t i, length, new_length;
 
-    (void) pointer;
-    (void) data;
-    (void) command;
+    workspace = NULL;
+    channel = NULL;
+    slack_buffer_get_workspace_and_channel(buffer, &workspace, &channel);
+    if (!workspace)
+        return 0;
 
     input_string = weechat_buffer_get_string(buffer, "input");
+    if (!input_string)
+        return 0;
     input_length = strlen(input_string);
-    input_pos = weechat_buffer_get_integer(buffer, "input_pos");
+    input_pos = weechat_utf8_real_pos(input_string,
+                                      weechat_buffer_get_integer(buffer, "input_pos"));
     for (start = input_pos; start > 0 && input_string[start] != ':'; start--)
         if (input_string[start] == ' ') { break; }
     for (end = input_pos; end < input_length && input_string[end] != ' '; end++)
         if (input_string[end] == ':') { end++; break; }
 
-    if (input_string[start] != ':')
-        return WEECHAT_RC_OK;
-    else
-        word = strndup(&input_string[start], end - start);
-    
-    size_t emoji_count = sizeof(slack_emoji_by_name)
-        / sizeof(struct t_slack_emoji_by_name);
-    closest_emoji = malloc(sizeof(slack_emoji_by_name));
-    memcpy(closest_emoji, slack_emoji_by_name,
-           sizeof(slack_emoji_by_name));
-
-    int edit_dist_cmp(const void *p1, const void *p2)
-    {
-        const struct t_slack_emoji_by_name *e1 = p1;
-        const struct t_slack_emoji_by_name *e2 = p2;
-        size_t d1 = modified_wagner_fischer(e1->name, word);
-        size_t d2 = modified_wagner_fischer(e2->name, word);
-        if (d1 == d2)
-        {
-            size_t l1 = longest_common_substring(e1->name, word);
-            size_t l2 = longest_common_substring(e2->name, word);
-            return (l1 < l2) - (l1 > l2);
-        }
-        return (d1 > d2) - (d1 < d2);
-    };
-    qsort(closest_emoji, emoji_count,
-          sizeof(struct t_slack_emoji_by_name),
-          edit_dist_cmp);
-
-    size_t new_length = snprintf(NULL, 0, "%.*s%s%s",
-                                 start, input_string,
-                                 closest_emoji[0].name,
-                                 &input_string[end]) + 1;
+    /* the ':' must start the word: not "12:30" nor "http://host" */
+    if (input_string[start] != ':'
+        || (start > 0 && input_string[start - 1] != ' '))
+        return 0;
+    length = end - start;
+    if (length > SLACK_EMOJI_COMPLETE_MAX_LEN)
+        return 0;
+
+    /* one pass, one distance per candidate */
+    best.name = NULL;
+    for (i = 0; i < SLACK_EMOJI_BY_NAME_COUNT; i++)
+        slack_emoji_match(&best, slack_emoji_by_name[i].name,
+                          &input_string[start], length);
+    for (ptr_emoji = workspace->emoji; ptr_emoji;
+         ptr_emoji = ptr_emoji->next_emoji)
+        slack_emoji_match(&best, ptr_emoji->name,
+                          &input_string[start], length);
+    if (!best.name)
+        return 0;
+
+    new_length = snprintf(NULL, 0, "%.*s%s%s",
+                          start, input_string,
+                          best.name,
+                          &input_string[end]) + 1;
     new_string = malloc(new_length);
+    if (!new_string)
+        return 0;
     snprintf(new_string, new_length, "%.*s%s%s",
              start, input_string,
-             closest_emoji[0].name,
+             best.name,
              &input_string[end]);
     weechat_buffer_set(buffer, "input", new_string);
-    
-    size_t new_pos_len = snprintf(NULL, 0, "%lu",
-                                  (unsigned long)(start +
-                                      strlen(closest_emoji[0].name) - 1));
-    new_pos = malloc(new_pos_len);
-    snprintf(new_pos, new_pos_len, "%lu",
-             (unsigned long)(start +
-                 strlen(closest_emoji[0].name) - 1));
+
+    snprintf(new_pos, sizeof(new_pos), "%d",
+             weechat_utf8_pos(new_string, start + strlen(best.name)));
     weechat_buffer_set(buffer, "input_pos", new_pos);
-    
-    free(new_pos);
+
     free(new_string);
-    free(closest_emoji);
-    free(word);
-    return WEECHAT_RC_OK_EAT;
+    return 1;
+}
+
+/*
+ * Copies text to output (if not NULL) with emoticons typed as whole words
+ * (":)", "<3") replaced by the shortcode of their emoji, which Slack renders.
+ * Words in `code` are left alone. Returns the output length, or -1 if
+ * nothing would be replaced.
+ */
+
+static int slack_emoji_replace_words(const char *text, char *output)
+{
+    struct t_slack_emoji_by_text *emoji;
+    const char *ptr_text, *word;
+    int length, replaced, code;
+
+    length = 0;
+    replaced = 0;
+    code = 0;
+    ptr_text = text;
+    while (ptr_text[0])
+    {
+        word = ptr_text;
+        while (ptr_text[0] && ptr_text[0] != ' ')
+            ptr_text++;
+        emoji = (ptr_text > word && !code) ?
+            slack_emoji_search_text(word, ptr_text - word) : NULL;
+        if (emoji)
+        {
+            if (output)
+                memcpy(output + length, emoji->name_to, strlen(emoji->name_to));
+            length += strlen(emoji->name_to);
+            replaced = 1;
+        }
+        else
+        {
+            /* each backtick opens or closes code, a fence being three */
+            for (; word < ptr_text; word++)
+            {
+                if (word[0] == '`')
+                    code = !code;
+                if (output)
+                    output[length] = word[0];
+                length++;
+            }
+        }
+        for (; ptr_text[0] == ' '; ptr_text++)
+        {
+            if (output)
+                output[length] = ' ';
+            length++;
+        }
+    }
+    if (output)
+        output[length] = '\0';
+
+    return (replaced) ? length : -1;
+}
+
+char *slack_emoji_replace_text(const char *text)
+{
+    char *output;
+    int length;
+
+    length = slack_emoji_replace_words(text, NULL);
+    if (length < 0)
+        return NULL;
+
+    output = malloc(length + 1);
+    if (!output)
+        return NULL;
+    slack_emoji_replace_words(text, output);
+
+    return output;
 }
 
 int slack_emoji_input_replace_cb(const void *pointer, void *data,
                                  struct t_gui_buffer *buffer,
                                  const char *command)
 {
+    struct t_slack_workspace *workspace;
+    struct t_slack_channel *channel;
+    const char *input;
+    char *new_input;
+
     (void) pointer;
     (void) data;
-    (void) buffer;
     (void) command;
 
-    /* TBI */
-    
+    if (!weechat_config_boolean(slack_config_look_replace_emoticons))
+        return WEECHAT_RC_OK;
+
+    workspace = NULL;
+    channel = NULL;
+    slack_buffer_get_workspace_and_channel(buffer, &workspace, &channel);
+    if (!workspace || !channel)
+        return WEECHAT_RC_OK;
+
+    input = weechat_buffer_get_string(buffer, "input");
+    if (!input || !input[0] || input[0] == '/')
+        return WEECHAT_RC_OK;
+
+    new_input = slack_emoji_replace_text(input);
+    if (new_input)
+    {
+        weechat_buffer_set(buffer, "input", new_input);
+        free(new_input);
+    }
+
     return WEECHAT_RC_OK;
 }
 
+/*
+ * Returns the unicode of a ":shortcode:" span, falling back to workspace
+ * custom emoji that alias a standard one; NULL if it has none.
+ */
+
+const char *slack_emoji_get_unicode_by_shortcode(struct t_slack_workspace *workspace,
+                                                 const char *shortcode,
+                                                 size_t length)
+{
+    struct t_slack_emoji_by_name *emoji;
+    struct t_slack_workspace_emoji *ptr_emoji;
+    char name[SLACK_WORKSPACE_EMOJI_SHORTNAME_MAX_LEN + 1];
+    const char *alias;
+
+    emoji = slack_emoji_search_name(shortcode, length);
+    if (emoji)
+        return emoji->unicode;
+
+    if (!workspace || !workspace->emoji || length > SLACK_WORKSPACE_EMOJI_SHORTNAME_MAX_LEN)
+        return NULL;
+
+    memcpy(name, shortcode, length);
+    name[length] = '\0';
+    ptr_emoji = slack_workspace_emoji_search(workspace, name);
+    if (!ptr_emoji || !ptr_emoji->url
+        || strncmp(ptr_emoji->url, "alias:", 6) != 0)
+        return NULL;
+
+    alias = ptr_emoji->url + 6;
+    if (strlen(alias) + 2 > SLACK_WORKSPACE_EMOJI_SHORTNAME_MAX_LEN)
+        return NULL;
+    snprintf(name, sizeof(name), ":%s:", alias);
+    emoji = slack_emoji_search_name(name, strlen(name));
+
+    return (emoji) ? emoji->unicode : NULL;
+}
+
 const char *slack_emoji_get_unicode_by_name(const char *name)
 {
     struct t_slack_emoji_by_name *result;
-    struct t_slack_emoji_by_name key;
-    key.name = name;
-
-    size_t emoji_count = sizeof(slack_emoji_by_name)
-        / sizeof(struct t_slack_emoji_by_name);
-    result = (struct t_slack_emoji_by_name *)bsearch(
-        &key, slack_emoji_by_name, emoji_count,
-        sizeof(struct t_slack_emoji_by_name),
-        emoji_byname_cmp);
-    
-    return result->unicode;
+
+    result = slack_emoji_search_name(name, strlen(name));
+
+    return (result) ? result->unicode : NULL;
 }
 
 const char *slack_emoji_get_unicode_by_text(const char *text)
 {
     struct t_slack_emoji_by_text *result;
-    struct t_slack_emoji_by_text key;
-    key.text = text;
-
-    size_t emoji_count = sizeof(slack_emoji_by_text)
-        / sizeof(struct t_slack_emoji_by_text);
-    result = (struct t_slack_emoji_by_text *)bsearch(
-        &key, slack_emoji_by_text, emoji_count,
-        sizeof(struct t_slack_emoji_by_text),
-        emoji_bytext_cmp);
-    
-    return result->unicode;
+
+    result = slack_emoji_search_text(text, strlen(text));
+
+    return (result) ? result->unicode : NULL;
 }
 
 const char *slack_emoji_get_text_by_name(const char *name)
 {
     struct t_slack_emoji_by_name *result;
-    struct t_slack_emoji_by_name key;
-    key.name = name;
-
-    size_t emoji_count = sizeof(slack_emoji_by_name)
-        / sizeof(struct t_slack_emoji_by_name);
-    result = (struct t_slack_emoji_by_name *)bsearch(
-        &key, slack_emoji_by_name, emoji_count,
-        sizeof(struct t_slack_emoji_by_name),
-        emoji_byname_cmp);
-    
-    return result->text_to;
+
+    result = slack_emoji_search_name(name, strlen(name));
+
+    return (result) ? result->text_to : NULL;
 }
 
 const char *slack_emoji_get_name_by_text(const char *text)
 {
     struct t_slack_emoji_by_text *result;
-    struct t_slack_emoji_by_text key;
-    key.text = text;
-
-    size_t emoji_count = sizeof(slack_emoji_by_text)
-        / sizeof(struct t_slack_emoji_by_text);
-    result = (struct t_slack_emoji_by_text *)bsearch(
-        &key, slack_emoji_by_text, emoji_count,
-        sizeof(struct t_slack_emoji_by_text),
-        emoji_bytext_cmp);
-    
-    return result->name_to;
+
+    result = slack_emoji_search_text(text, strlen(text));
+
+    return (result) ? result->name_to : NULL;
 }
@@ -5,19 +5,25 @@
 #ifndef _SLACK_EMOJI_H_
 #define _SLACK_EMOJI_H_
 
+#include <stddef.h>
+
 int slack_emoji_complete_by_name_cb(const void *pointer, void *data,
                                     const char *completion_item,
                                     struct t_gui_buffer *buffer,
                                     struct t_gui_completion *completion);
 
-int slack_emoji_input_complete_cb(const void *pointer, void *data,
-                                  struct t_gui_buffer *buffer,
-                                  const char *command);
+int slack_emoji_input_complete(struct t_gui_buffer *buffer);
 
 int slack_emoji_input_replace_cb(const void *pointer, void *data,
                                  struct t_gui_buffer *buffer,
                                  const char *command);
 
+char *slack_emoji_replace_text(const char *text);
+
+const char *slack_emoji_get_unicode_by_shortcode(struct t_slack_workspace *workspace,
+                                                 const char *shortcode,
+                                                 size_t length);
+
 const char *slack_emoji_get_unicode_by_name(const char *name);
 
 const char *slack_emoji_get_unicode_by_text(const char *text);
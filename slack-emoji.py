@@ -4,17 +4,120 @@
 # License, version 2.0. If a copy of the MPL was not distributed with this
 # file, You can obtain one at http://mozilla.org/MPL/2.0/.
 
-import requests
+# Usage: slack-emoji.py [emoji.json] > slack-emoji.inc
+# Without an argument the emoji data is downloaded from iamcal/emoji-data.
+
 import json
-import ast
+import sys
+
+M32 = 0xffffffff
+M64 = 0xffffffffffffffff
+
+# must match slack_emoji_hash() and slack_emoji_slot() in slack-emoji.c
+def emoji_hash(key, fold):
+    h = 0xcbf29ce484222325
+    for b in key.encode('utf-8'):
+        if fold and 0x41 <= b <= 0x5a:
+            b += 0x20
+        h ^= b
+        h = (h * 0x100000001b3) & M64
+    # short keys barely move the high bits, so mix before splitting
+    h ^= h >> 33
+    h = (h * 0xff51afd7ed558ccd) & M64
+    h ^= h >> 33
+    h = (h * 0xc4ceb9fe1a85ec53) & M64
+    h ^= h >> 33
+    return h
+
+def emoji_slot(h, displacement, count):
+    x = (h & M32) ^ displacement
+    x ^= x >> 16
+    x = (x * 0x85ebca6b) & M32
+    x ^= x >> 13
+    x = (x * 0xc2b2ae35) & M32
+    x ^= x >> 16
+    return x % count
+
+def perfect_hash(keys, fold):
+    """Hash and displace: returns (displacements, slots) so that key i is at
+    slots[emoji_slot(h, displacements[bucket(h)], n)] == i."""
+    count = len(keys)
+    nbuckets = max(1, (count + 3) // 4)
+    buckets = [[] for _ in range(nbuckets)]
+    for index, key in enumerate(keys):
+        h = emoji_hash(key, fold)
+        buckets[(h >> 32) % nbuckets].append((index, h))
+    displacements = [0] * nbuckets
+    slots = [None] * count
+    for bucket in sorted(range(nbuckets), key=lambda b: -len(buckets[b])):
+        if not buckets[bucket]:
+            continue
+        for displacement in range(1 << 16):
+            taken = [emoji_slot(h, displacement, count) for _, h in buckets[bucket]]
+            if len(set(taken)) == len(taken) \
+               and all(slots[slot] is None for slot in taken):
+                break
+        else:
+            sys.exit("slack-emoji.py: no displacement for bucket %d" % bucket)
+        displacements[bucket] = displacement
+        for (index, _), slot in zip(buckets[bucket], taken):
+            slots[slot] = index
+    return displacements, slots
+
+def c_string(value):
+    if value is None:
+        return "NULL"
+    out = '"'
+    for b in value.encode('utf-8'):
+        if b in (0x22, 0x5c):
+            out += '\\' + chr(b)
+        elif 0x20 <= b < 0x7f:
+            out += chr(b)
+        else:
+            out += '\\%03o' % b
+    return out + '"'
+
+def c_list(values):
+    return "{" + ", ".join(map(c_string, values + [None])) + "}"
+
+def c_array(name, values):
+    print("static const uint16_t %s[] =" % name)
+    print("{")
+    for i in range(0, len(values), 12):
+        print("    " + ", ".join("%5d" % v for v in values[i:i+12]) + ",")
+    print("};")
+    print("")
+
+def unicode(o):
+    return "".join(chr(int(code, 16)) for code in o['unified'].split('-'))
 
-emoji = requests.get("https://raw.githubusercontent.com/iamcal/emoji-data/master/emoji.json").json()
+if len(sys.argv) > 1:
+    with open(sys.argv[1]) as f:
+        emoji = json.load(f)
+else:
+    import requests
+    emoji = requests.get("https://raw.githubusercontent.com/iamcal/emoji-data/master/emoji.json").json()
 
-print("""
-// This Source Code Form is subject to the terms of the Mozilla Public
+def unique(pairs):
+    """Keeps one emoji per key, preferring the one the key primarily names."""
+    pairs = sorted(pairs, key=lambda x: (x[0], x[1]['short_name'] != x[0].strip(":"),
+                                         len(x[1]['unified'])))
+    return [pair for i, pair in enumerate(pairs)
+            if i == 0 or pairs[i - 1][0] != pair[0]]
+
+by_name = unique((":" + name + ":", o) for o in emoji for name in o['short_names'])
+by_text = unique((text, o) for o in emoji if o['texts'] for text in o['texts'])
+
+name_displacements, name_slots = perfect_hash([name for name, _ in by_name], True)
+text_displacements, text_slots = perfect_hash([text for text, _ in by_text], False)
+
+print("""// This Source Code Form is subject to the terms of the Mozilla Public
 // License, version 2.0. If a copy of the MPL was not distributed with this
 // file, You can obtain one at http://mozilla.org/MPL/2.0/.
 
+// Generated by slack-emoji.py, do not edit.
+
+#include <stdint.h>
 #include <stdlib.h>
 
 #define MAX_TEXTS %d
@@ -33,27 +136,39 @@ struct t_slack_emoji_by_text {
     const char *name_to;
     const char *name_from[MAX_NAMES];
 };
-"""%(max(len(o['texts'] if o['texts'] else []) for o in emoji) + 1,
-     max(len(o['short_names'] if o['short_names'] else []) for o in emoji) + 1))
+
+/*
+ * Both tables are sorted and come with a minimal perfect hash: the bucket of
+ * a key's hash selects a displacement that maps the key to its own slot, and
+ * the slot holds the key's index in the table. Names hash case-insensitively,
+ * texts case-sensitively.
+ */
+
+#define SLACK_EMOJI_BY_NAME_COUNT %d
+#define SLACK_EMOJI_BY_NAME_BUCKETS %d
+#define SLACK_EMOJI_BY_TEXT_COUNT %d
+#define SLACK_EMOJI_BY_TEXT_BUCKETS %d
+""" % (max(len(o['texts'] if o['texts'] else []) for o in emoji) + 1,
+       max(len(o['short_names'] if o['short_names'] else []) for o in emoji) + 1,
+       len(by_name), len(name_displacements),
+       len(by_text), len(text_displacements)))
+
 print("static struct t_slack_emoji_by_name slack_emoji_by_name[] =")
-print("{"+"\n".join(", {{ {0}, {1}, {2}, {3} }}".format(
-    json.dumps(":"+name+":"),
-    json.dumps(ast.parse("\"\\u"+"\\u".join(o['unified'].split('-'))+"\"", mode='eval').body.s),
-    json.dumps(o['text']),
-    "{"+json.dumps(o['texts']+[None] if o['texts'] else [None])[1:-1]+"}")
-                    for o,name in sorted(((o,name) for o in emoji for name in o['short_names']),
-                                         key=lambda x: x[1])
-).replace("null", "NULL")[1:])
+print("{" + "\n".join(", {{ {0}, {1}, {2}, {3} }}".format(
+    c_string(name), c_string(unicode(o)), c_string(o['text']),
+    c_list(o['texts'] if o['texts'] else []))
+                      for name, o in by_name)[1:])
 print("};")
 print("")
+c_array("slack_emoji_by_name_displacements", name_displacements)
+c_array("slack_emoji_by_name_slots", name_slots)
+
 print("static struct t_slack_emoji_by_text slack_emoji_by_text[] =")
-print("{"+"\n".join(", {{ {0}, {1}, {2}, {3} }}".format(
-    json.dumps(text),
-    json.dumps(ast.parse("\"\\u"+"\\u".join(o['unified'].split('-'))+"\"", mode='eval').body.s),
-    json.dumps(":"+o['short_name']+":"),
-    "{"+json.dumps(list(map(lambda name: ":"+name+":", o['short_names']))+[None]
-                   if o['short_names'] else [None])[1:-1]+"}")
-                    for o,text in sorted(((o,text) for o in emoji if o['texts'] for text in o['texts']),
-                                         key=lambda x:x[1])
-).replace("null", "NULL")[1:])
+print("{" + "\n".join(", {{ {0}, {1}, {2}, {3} }}".format(
+    c_string(text), c_string(unicode(o)), c_string(":" + o['short_name'] + ":"),
+    c_list([":" + name + ":" for name in o['short_names']]))
+                      for text, o in by_text)[1:])
 print("};")
+print("")
+c_array("slack_emoji_by_text_displacements", text_displacements)
+c_array("slack_emoji_by_text_slots", text_slots)
@@ -0,0 +1,134 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, version 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "weechat-plugin.h"
+#include "slack.h"
+#include "slack-id.h"
+
+#define SLACK_ID_BASE 37
+
+static inline int slack_id_digit(char c)
+{
+    if (c >= '0' && c <= '9')
+        return 1 + (c - '0');
+    if (c >= 'A' && c <= 'Z')
+        return 11 + (c - 'A');
+    if (c >= 'a' && c <= 'z')
+        return 11 + (c - 'a');
+    return -1;
+}
+
+t_slack_id slack_id_encode(const char *str)
+{
+    t_slack_id id;
+    int i, digit;
+
+    if (!str || !str[0])
+        return SLACK_ID_NONE;
+
+    id = 0;
+    for (i = 0; str[i]; i++)
+    {
+        if (i >= SLACK_ID_MAX_LEN)
+            return SLACK_ID_NONE;
+        digit = slack_id_digit(str[i]);
+        if (digit < 0)
+            return SLACK_ID_NONE;
+        id = id * SLACK_ID_BASE + digit;
+    }
+    /* pad short ids so that the first character is always most significant */
+    for (; i < SLACK_ID_MAX_LEN; i++)
+        id *= SLACK_ID_BASE;
+
+    return id;
+}
+
+char *slack_id_decode(t_slack_id id, char *str)
+{
+    char digits[SLACK_ID_MAX_LEN];
+    int i, length, digit;
+
+    for (i = SLACK_ID_MAX_LEN - 1; i >= 0; i--)
+    {
+        digits[i] = id % SLACK_ID_BASE;
+        id /= SLACK_ID_BASE;
+    }
+
+    length = 0;
+    for (i = 0; i < SLACK_ID_MAX_LEN && digits[i]; i++)
+    {
+        digit = digits[i];
+        str[length++] = (digit <= 10) ? '0' + (digit - 1) : 'A' + (digit - 11);
+    }
+    str[length] = '\0';
+
+    return str;
+}
+
+unsigned long long slack_id_hash_cb(struct t_hashtable *hashtable,
+                                    const void *key)
+{
+    t_slack_id hash;
+
+    (void) hashtable;
+
+    /* low digits are often padding, so mix all bits down */
+    hash = *((const t_slack_id *)key);
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+
+    return hash;
+}
+
+int slack_id_keycmp_cb(struct t_hashtable *hashtable,
+                       const void *key1, const void *key2)
+{
+    t_slack_id id1, id2;
+
+    (void) hashtable;
+
+    id1 = *((const t_slack_id *)key1);
+    id2 = *((const t_slack_id *)key2);
+
+    return (id1 > id2) - (id1 < id2);
+}
+
+struct t_hashtable *slack_id_hashtable_new(int size)
+{
+    return weechat_hashtable_new(size,
+                                 WEECHAT_HASHTABLE_BUFFER,
+                                 WEECHAT_HASHTABLE_POINTER,
+                                 &slack_id_hash_cb,
+                                 &slack_id_keycmp_cb);
+}
+
+void slack_id_hashtable_set(struct t_hashtable *hashtable,
+                            t_slack_id id, void *pointer)
+{
+    if (!hashtable || id == SLACK_ID_NONE)
+        return;
+
+    weechat_hashtable_set_with_size(hashtable, &id, sizeof(id),
+                                    pointer, 0);
+}
+
+void *slack_id_hashtable_get(struct t_hashtable *hashtable, t_slack_id id)
+{
+    if (!hashtable || id == SLACK_ID_NONE)
+        return NULL;
+
+    return weechat_hashtable_get(hashtable, &id);
+}
+
+void slack_id_hashtable_remove(struct t_hashtable *hashtable, t_slack_id id)
+{
+    if (!hashtable || id == SLACK_ID_NONE)
+        return;
+
+    weechat_hashtable_remove(hashtable, &id);
+}
@@ -0,0 +1,40 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, version 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef _SLACK_ID_H_
+#define _SLACK_ID_H_
+
+#include <stdint.h>
+
+#define SLACK_ID_MAX_LEN 12
+#define SLACK_ID_NONE 0
+
+/*
+ * Slack object ids (U0123ABCD, C0123ABCD, T..., B...) are short uppercase
+ * alphanumerics, so they are packed as base-37 digits into a single integer,
+ * most significant character first (0 terminates, 1-10 are '0'-'9', 11-36
+ * are 'A'-'Z'). Ordering of packed ids matches ordering of the strings.
+ */
+typedef uint64_t t_slack_id;
+
+t_slack_id slack_id_encode(const char *str);
+
+char *slack_id_decode(t_slack_id id, char *str);
+
+unsigned long long slack_id_hash_cb(struct t_hashtable *hashtable,
+                                    const void *key);
+
+int slack_id_keycmp_cb(struct t_hashtable *hashtable,
+                       const void *key1, const void *key2);
+
+struct t_hashtable *slack_id_hashtable_new(int size);
+
+void slack_id_hashtable_set(struct t_hashtable *hashtable,
+                            t_slack_id id, void *pointer);
+
+void *slack_id_hashtable_get(struct t_hashtable *hashtable, t_slack_id id);
+
+void slack_id_hashtable_remove(struct t_hashtable *hashtable, t_slack_id id);
+
+#endif /*SLACK_ID_H*/
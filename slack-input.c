@@ -4,10 +4,16 @@
 
 #include <libwebsockets.h>
 #include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <ctype.h>
 
 #include "weechat-plugin.h"
 #include "slack.h"
+#include "slack-color.h"
+#include "slack-id.h"
 #include "slack-workspace.h"
+#include "slack-user.h"
 #include "slack-channel.h"
 #include "slack-buffer.h"
 #include "slack-request.h"
@@ -15,12 +21,192 @@
 #include "slack-input.h"
 #include "request/slack-request-chat-postmessage.h"
 
+/* "@ab" can become "<@" id ">", which outgrows any other replacement */
+#define SLACK_INPUT_ENCODE_MAX_GROWTH ((SLACK_ID_MAX_LEN + 3) / 2 + 1)
+
+#define SLACK_INPUT_MENTION_MAX_WORDS 3
+#define SLACK_INPUT_MENTION_MAX_LEN 255
+
+static const char *slack_input_special_mentions[] =
+{ "here", "channel", "everyone", NULL };
+
+static int slack_input_name_char(char c)
+{
+    return (unsigned char)c >= 0x80 || isalnum((unsigned char)c)
+        || c == '.' || c == '-' || c == '_';
+}
+
+/*
+ * Writes the markup for "@name" or "#name" (prefix is '@' or '#') at
+ * *ptr_encoded and moves it past. Returns 0 if the name is unknown.
+ */
+
+static int slack_input_encode_name(struct t_slack_workspace *workspace,
+                                   char prefix, const char *name,
+                                   char **ptr_encoded)
+{
+    struct t_slack_user *ptr_user;
+    struct t_slack_channel *ptr_channel;
+    char id[SLACK_ID_MAX_LEN + 1];
+    int i;
+
+    if (prefix == '@')
+    {
+        for (i = 0; slack_input_special_mentions[i]; i++)
+        {
+            if (weechat_strcasecmp(name, slack_input_special_mentions[i]) == 0)
+            {
+                *ptr_encoded += sprintf(*ptr_encoded, "<!%s>",
+                                        slack_input_special_mentions[i]);
+                return 1;
+            }
+        }
+
+        ptr_user = slack_user_search_name(workspace, name);
+        if (!ptr_user)
+            return 0;
+
+        *ptr_encoded += sprintf(*ptr_encoded, "<@%s>",
+                                slack_id_decode(ptr_user->id, id));
+        return 1;
+    }
+
+    ptr_channel = slack_channel_search_name(workspace, name);
+    if (!ptr_channel
+        || (ptr_channel->type != SLACK_CHANNEL_TYPE_CHANNEL
+            && ptr_channel->type != SLACK_CHANNEL_TYPE_GROUP))
+        return 0;
+
+    *ptr_encoded += sprintf(*ptr_encoded, "<#%s>",
+                            slack_id_decode(ptr_channel->id, id));
+    return 1;
+}
+
+/*
+ * Encodes the mention starting at the '@' or '#' of mention. Names run over
+ * name characters; user names may also span a few words, for real names.
+ * The longest known name wins, and trailing dots or dashes are dropped
+ * before giving up on a candidate since they usually end the sentence.
+ *
+ * Returns the number of bytes of mention consumed, 0 if nothing matched.
+ */
+
+static int slack_input_encode_mention(struct t_slack_workspace *workspace,
+                                      const char *mention, char **ptr_encoded)
+{
+    const char *ends[SLACK_INPUT_MENTION_MAX_WORDS], *ptr_end;
+    char name[SLACK_INPUT_MENTION_MAX_LEN + 1];
+    int words, length;
+
+    words = 0;
+    ptr_end = mention + 1;
+    while (words < SLACK_INPUT_MENTION_MAX_WORDS)
+    {
+        while (slack_input_name_char(*ptr_end))
+            ptr_end++;
+        ends[words++] = ptr_end;
+        if (mention[0] != '@' || ptr_end[0] != ' '
+            || !slack_input_name_char(ptr_end[1]))
+            break;
+        ptr_end++;
+    }
+
+    while (words > 0)
+    {
+        ptr_end = ends[--words];
+        while (1)
+        {
+            length = ptr_end - (mention + 1);
+            if (length <= 0)
+                break;
+            if (length <= SLACK_INPUT_MENTION_MAX_LEN)
+            {
+                memcpy(name, mention + 1, length);
+                name[length] = '\0';
+                if (slack_input_encode_name(workspace, mention[0], name,
+                                            ptr_encoded))
+                    return ptr_end - mention;
+            }
+            if (ptr_end[-1] != '.' && ptr_end[-1] != '-')
+                break;
+            ptr_end--;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Encodes typed text as Slack markup in one pass: "@name" and "#channel"
+ * become user, channel and special mentions, and the characters Slack
+ * reserves for markup are escaped. Unknown names are sent as typed.
+ *
+ * Note: result must be freed after use.
+ */
+
+static char *slack_input_encode(struct t_slack_workspace *workspace,
+                                const char *text)
+{
+    const char *ptr_text;
+    char *encoded, *ptr_encoded;
+    int length;
+
+    encoded = malloc(strlen(text) * SLACK_INPUT_ENCODE_MAX_GROWTH + 1);
+    if (!encoded)
+        return NULL;
+
+    ptr_encoded = encoded;
+    ptr_text = text;
+    while (*ptr_text)
+    {
+        switch (*ptr_text)
+        {
+            case '&':
+                memcpy(ptr_encoded, "&amp;", 5);
+                ptr_encoded += 5;
+                break;
+            case '<':
+                memcpy(ptr_encoded, "&lt;", 4);
+                ptr_encoded += 4;
+                break;
+            case '>':
+                memcpy(ptr_encoded, "&gt;", 4);
+                ptr_encoded += 4;
+                break;
+            case '@':
+            case '#':
+                /* a mention starts a word: "user@host" is left alone */
+                if ((ptr_text == text || !slack_input_name_char(ptr_text[-1]))
+                    && slack_input_name_char(ptr_text[1]))
+                {
+                    length = slack_input_encode_mention(workspace, ptr_text,
+                                                        &ptr_encoded);
+                    if (length > 0)
+                    {
+                        ptr_text += length;
+                        continue;
+                    }
+                }
+                *(ptr_encoded++) = *ptr_text;
+                break;
+            default:
+                *(ptr_encoded++) = *ptr_text;
+                break;
+        }
+        ptr_text++;
+    }
+    *ptr_encoded = '\0';
+
+    return encoded;
+}
+
 int slack_input_data(struct t_gui_buffer *buffer, const char *input_data)
 {
     struct t_slack_workspace *workspace = NULL;
     struct t_slack_channel *channel = NULL;
     struct t_slack_request *request;
-    char *text;
+    char channel_id[SLACK_ID_MAX_LEN + 1];
+    char *text, *encoded;
 
     slack_buffer_get_workspace_and_channel(buffer, &workspace, &channel);
 
@@ -33,24 +219,28 @@ int slack_input_data(struct t_gui_buffer *buffer, const char *input_data)
         {
             weechat_printf(buffer,
                            _("%s%s: you are not connected to server"),
-                           weechat_prefix("error"), SLACK_PLUGIN_NAME);
+                           SLACK_PREFIX_ERROR, SLACK_PLUGIN_NAME);
             return WEECHAT_RC_OK;
         }
 
+        encoded = slack_input_encode(workspace, input_data);
         text = malloc(SLACK_MESSAGE_MAX_LENGTH);
-        if (!text)
+        if (!encoded || !text)
         {
             weechat_printf(buffer,
                            _("%s%s: error allocating string"),
-                           weechat_prefix("error"), SLACK_PLUGIN_NAME);
+                           SLACK_PREFIX_ERROR, SLACK_PLUGIN_NAME);
+            free(encoded);
+            free(text);
             return WEECHAT_RC_ERROR;
         }
-        lws_urlencode(text, input_data, SLACK_MESSAGE_MAX_LENGTH);
+        lws_urlencode(text, encoded, SLACK_MESSAGE_MAX_LENGTH);
+        free(encoded);
 
         request = slack_request_chat_postmessage(workspace,
                     weechat_config_string(
                         workspace->options[SLACK_WORKSPACE_OPTION_TOKEN]),
-                    channel->id, text);
+                    slack_id_decode(channel->id, channel_id), text);
         if (request)
             slack_workspace_register_request(workspace, request);
 
@@ -60,7 +250,7 @@ int slack_input_data(struct t_gui_buffer *buffer, const char *input_data)
     {
         weechat_printf(buffer,
                        _("%s%s: this buffer is not a channel!"),
-                       weechat_prefix("error"), SLACK_PLUGIN_NAME);
+                       SLACK_PREFIX_ERROR, SLACK_PLUGIN_NAME);
     }
 
     return WEECHAT_RC_OK;
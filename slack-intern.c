@@ -0,0 +1,108 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, version 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "weechat-plugin.h"
+#include "slack.h"
+#include "slack-arena.h"
+#include "slack-intern.h"
+
+/*
+ * Keys are pointers to the arena copies, so the hashtable doesn't keep a
+ * second copy of every string; the callbacks hash and compare the contents.
+ */
+
+unsigned long long slack_intern_hash_cb(struct t_hashtable *hashtable,
+                                        const void *key)
+{
+    const unsigned char *ptr_str;
+    unsigned long long hash;
+
+    (void) hashtable;
+
+    /* FNV-1a */
+    hash = 14695981039346656037ULL;
+    for (ptr_str = key; *ptr_str; ptr_str++)
+    {
+        hash ^= *ptr_str;
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+int slack_intern_keycmp_cb(struct t_hashtable *hashtable,
+                           const void *key1, const void *key2)
+{
+    (void) hashtable;
+
+    return strcmp(key1, key2);
+}
+
+struct t_slack_intern *slack_intern_new()
+{
+    struct t_slack_intern *new_pool;
+
+    new_pool = malloc(sizeof(*new_pool));
+    if (!new_pool)
+        return NULL;
+
+    new_pool->strings = weechat_hashtable_new(256,
+                                              WEECHAT_HASHTABLE_POINTER,
+                                              WEECHAT_HASHTABLE_POINTER,
+                                              &slack_intern_hash_cb,
+                                              &slack_intern_keycmp_cb);
+    new_pool->arena = slack_arena_new(0);
+    if (!new_pool->strings || !new_pool->arena)
+    {
+        slack_intern_free(new_pool);
+        return NULL;
+    }
+
+    return new_pool;
+}
+
+const char *slack_intern_string(struct t_slack_intern *pool, const char *str)
+{
+    char *new_str;
+
+    if (!pool || !str)
+        return NULL;
+
+    new_str = weechat_hashtable_get(pool->strings, str);
+    if (new_str)
+        return new_str;
+
+    new_str = slack_arena_strdup(pool->arena, str);
+    if (!new_str)
+        return NULL;
+    weechat_hashtable_set(pool->strings, new_str, new_str);
+
+    return new_str;
+}
+
+void slack_intern_free(struct t_slack_intern *pool)
+{
+    if (!pool)
+        return;
+
+    if (pool->strings)
+        weechat_hashtable_free(pool->strings);
+    slack_arena_free(pool->arena);
+
+    free(pool);
+}
+
+size_t slack_intern_memory(struct t_slack_intern *pool)
+{
+    if (!pool)
+        return 0;
+
+    /* a hashtable item is key, value, their sizes and two links */
+    return sizeof(*pool) + slack_arena_memory(pool->arena)
+        + weechat_hashtable_get_integer(pool->strings, "items_count")
+          * 6 * sizeof(void *);
+}
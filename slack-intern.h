@@ -0,0 +1,28 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, version 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef _SLACK_INTERN_H_
+#define _SLACK_INTERN_H_
+
+#include <stddef.h>
+
+/*
+ * String pool: each distinct value is stored once and lives as long as the
+ * pool, so interned strings can be shared freely and compared by pointer.
+ */
+struct t_slack_intern
+{
+    struct t_hashtable *strings;
+    struct t_slack_arena *arena;
+};
+
+struct t_slack_intern *slack_intern_new();
+
+const char *slack_intern_string(struct t_slack_intern *pool, const char *str);
+
+void slack_intern_free(struct t_slack_intern *pool);
+
+size_t slack_intern_memory(struct t_slack_intern *pool);
+
+#endif /*SLACK_INTERN_H*/
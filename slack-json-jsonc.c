@@ -0,0 +1,71 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, version 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <json.h>
+
+#include "slack-json.h"
+
+/*
+ * json-c backend: values are json-c objects, handed out as is.
+ */
+
+#define JSON_OBJECT(__value) ((json_object *)(__value))
+#define JSON_VALUE(__object) ((struct t_slack_json_value *)(__object))
+
+struct t_slack_json_value *slack_json_parse(const char *string)
+{
+    return JSON_VALUE(json_tokener_parse(string));
+}
+
+void slack_json_free(struct t_slack_json_value *root)
+{
+    json_object_put(JSON_OBJECT(root));
+}
+
+struct t_slack_json_value *slack_json_object_get(struct t_slack_json_value *object,
+                                                 const char *key)
+{
+    return JSON_VALUE(json_object_object_get(JSON_OBJECT(object), key));
+}
+
+void slack_json_object_map(struct t_slack_json_value *object,
+                           t_slack_json_member_cb *callback, void *data)
+{
+    if (!json_object_is_type(JSON_OBJECT(object), json_type_object))
+        return;
+
+    json_object_object_foreach(JSON_OBJECT(object), key, val)
+    {
+        (*callback)(data, key, JSON_VALUE(val));
+    }
+}
+
+int slack_json_array_length(struct t_slack_json_value *array)
+{
+    if (!json_object_is_type(JSON_OBJECT(array), json_type_array))
+        return 0;
+
+    return json_object_array_length(JSON_OBJECT(array));
+}
+
+struct t_slack_json_value *slack_json_array_get(struct t_slack_json_value *array,
+                                                int index)
+{
+    return JSON_VALUE(json_object_array_get_idx(JSON_OBJECT(array), index));
+}
+
+const char *slack_json_get_string(struct t_slack_json_value *value)
+{
+    return json_object_get_string(JSON_OBJECT(value));
+}
+
+int slack_json_get_boolean(struct t_slack_json_value *value)
+{
+    return json_object_get_boolean(JSON_OBJECT(value));
+}
+
+int slack_json_get_int(struct t_slack_json_value *value)
+{
+    return json_object_get_int(JSON_OBJECT(value));
+}
@@ -0,0 +1,549 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, version 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <limits.h>
+
+#include "slack-json.h"
+
+/*
+ * Tape backend: a document is parsed in two passes over a copy of the
+ * input. The first only counts commas and containers outside strings,
+ * which bounds the number of values; the second lays every value out on
+ * a tape, in document order, with strings unescaped and terminated in
+ * place in the copy. Tape, child lists and text share one allocation
+ * that starts with the root, so freeing the root frees the document.
+ */
+
+enum t_slack_json_tape_type
+{
+    SLACK_JSON_TAPE_OBJECT = 0,
+    SLACK_JSON_TAPE_ARRAY,
+    SLACK_JSON_TAPE_STRING,
+    SLACK_JSON_TAPE_NUMBER,
+    SLACK_JSON_TAPE_TRUE,
+    SLACK_JSON_TAPE_FALSE,
+    SLACK_JSON_TAPE_NULL,
+};
+
+struct t_slack_json_value
+{
+    enum t_slack_json_tape_type type;
+    int count;                          /* members or elements */
+    struct t_slack_json_value **children;
+    const char *key;                    /* in an object, else NULL */
+    const char *string;                 /* text of strings and scalars */
+};
+
+enum t_slack_json_tape_state
+{
+    SLACK_JSON_TAPE_STATE_VALUE = 0,
+    SLACK_JSON_TAPE_STATE_OBJECT_START,
+    SLACK_JSON_TAPE_STATE_OBJECT_KEY,
+    SLACK_JSON_TAPE_STATE_COLON,
+    SLACK_JSON_TAPE_STATE_ARRAY_START,
+    SLACK_JSON_TAPE_STATE_AFTER_VALUE,
+};
+
+#define SLACK_JSON_TAPE_ONES 0x0101010101010101ULL
+#define SLACK_JSON_TAPE_HIGHS 0x8080808080808080ULL
+
+/* non-zero if any byte of word is byte */
+#define SLACK_JSON_TAPE_HAS_BYTE(__word, __byte)                        \
+    ((((__word) ^ (SLACK_JSON_TAPE_ONES * (__byte))) - SLACK_JSON_TAPE_ONES) \
+     & ~((__word) ^ (SLACK_JSON_TAPE_ONES * (__byte))) & SLACK_JSON_TAPE_HIGHS)
+
+/*
+ * Returns the first '"' or '\' from string on, reading eight bytes at a
+ * time; end must be readable (the NUL of the text) and stops the search.
+ */
+
+static const char *slack_json_tape_string_stop(const char *string,
+                                               const char *end)
+{
+    uint64_t word;
+
+    while (string + sizeof(word) <= end)
+    {
+        memcpy(&word, string, sizeof(word));
+        if (SLACK_JSON_TAPE_HAS_BYTE(word, '"')
+            || SLACK_JSON_TAPE_HAS_BYTE(word, '\\'))
+            break;
+        string += sizeof(word);
+    }
+    while (string < end && *string != '"' && *string != '\\')
+        string++;
+
+    return string;
+}
+
+/*
+ * First pass: values are at most one per comma and container, plus the
+ * root. Returns -1 if a string is not closed.
+ */
+
+static long slack_json_tape_count(const char *text, const char *end)
+{
+    const char *ptr;
+    long count;
+
+    count = 1;
+    for (ptr = text; ptr < end; ptr++)
+    {
+        switch (*ptr)
+        {
+            case ',':
+            case '{':
+            case '[':
+                count++;
+                break;
+            case '"':
+                for (ptr++; ; ptr += 2)
+                {
+                    ptr = slack_json_tape_string_stop(ptr, end);
+                    if (ptr >= end)
+                        return -1;
+                    if (*ptr == '"')
+                        break;
+                }
+                break;
+        }
+    }
+
+    return count;
+}
+
+static int slack_json_tape_hex(const char *ptr, unsigned int *code_point)
+{
+    int i;
+    char c;
+
+    *code_point = 0;
+    for (i = 0; i < 4; i++)
+    {
+        c = ptr[i];
+        if (c >= '0' && c <= '9')
+            *code_point = (*code_point << 4) | (c - '0');
+        else if ((c | 0x20) >= 'a' && (c | 0x20) <= 'f')
+            *code_point = (*code_point << 4) | ((c | 0x20) - 'a' + 10);
+        else
+            return 0;
+    }
+
+    return 1;
+}
+
+/*
+ * Unescapes the string starting after its opening quote, in place, and
+ * terminates it. Returns the position after the closing quote, or NULL.
+ */
+
+static char *slack_json_tape_string(char *string, const char *end)
+{
+    char *read, *write;
+    unsigned int code_point, low;
+
+    read = (char *)slack_json_tape_string_stop(string, end);
+    if (read >= end)
+        return NULL;
+    if (*read == '"')
+    {
+        /* the common case: nothing to unescape */
+        *read = '\0';
+        return read + 1;
+    }
+
+    write = read;
+    while (read < end)
+    {
+        if (*read == '"')
+        {
+            *write = '\0';
+            return read + 1;
+        }
+        if (*read != '\\')
+        {
+            *write++ = *read++;
+            continue;
+        }
+
+        read++;
+        switch (*read)
+        {
+            case '"': case '\\': case '/':
+                *write++ = *read;
+                break;
+            case 'b': *write++ = '\b'; break;
+            case 'f': *write++ = '\f'; break;
+            case 'n': *write++ = '\n'; break;
+            case 'r': *write++ = '\r'; break;
+            case 't': *write++ = '\t'; break;
+            case 'u':
+                if (end - read < 5 || !slack_json_tape_hex(read + 1, &code_point))
+                    return NULL;
+                read += 4;
+                if (code_point >= 0xD800 && code_point < 0xDC00
+                    && end - read >= 7 && read[1] == '\\' && read[2] == 'u'
+                    && slack_json_tape_hex(read + 3, &low)
+                    && low >= 0xDC00 && low < 0xE000)
+                {
+                    code_point = 0x10000 + ((code_point - 0xD800) << 10)
+                        + (low - 0xDC00);
+                    read += 6;
+                }
+                else if (code_point >= 0xD800 && code_point < 0xE000)
+                    code_point = 0xFFFD;
+                write += slack_json_utf8_encode(code_point, write);
+                break;
+            default:
+                return NULL;
+        }
+        read++;
+    }
+
+    return NULL;
+}
+
+/*
+ * Checks a number against the JSON grammar, returns its end or NULL.
+ */
+
+static const char *slack_json_tape_number(const char *ptr)
+{
+    if (*ptr == '-')
+        ptr++;
+    if (*ptr == '0')
+        ptr++;
+    else if (*ptr >= '1' && *ptr <= '9')
+        while (*ptr >= '0' && *ptr <= '9')
+            ptr++;
+    else
+        return NULL;
+
+    if (*ptr == '.')
+    {
+        ptr++;
+        if (*ptr < '0' || *ptr > '9')
+            return NULL;
+        while (*ptr >= '0' && *ptr <= '9')
+            ptr++;
+    }
+
+    if (*ptr == 'e' || *ptr == 'E')
+    {
+        ptr++;
+        if (*ptr == '+' || *ptr == '-')
+            ptr++;
+        if (*ptr < '0' || *ptr > '9')
+            return NULL;
+        while (*ptr >= '0' && *ptr <= '9')
+            ptr++;
+    }
+
+    return ptr;
+}
+
+/*
+ * Second pass: fills the tape. Returns 1 if text was a single JSON value.
+ */
+
+static int slack_json_tape_build(struct t_slack_json_value *tape, long size,
+                                 struct t_slack_json_value **children,
+                                 struct t_slack_json_value **stack,
+                                 char *text, const char *end)
+{
+    struct t_slack_json_value *value, *containers[SLACK_JSON_MAX_DEPTH + 1];
+    long stack_starts[SLACK_JSON_MAX_DEPTH + 1];
+    enum t_slack_json_tape_state state;
+    long used, stack_length;
+    int depth, count;
+    size_t word_length;
+    const char *key, *word;
+    char *ptr, *literal_end, c, saved;
+
+    used = 0;
+    stack_length = 0;
+    depth = 0;
+    key = NULL;
+    state = SLACK_JSON_TAPE_STATE_VALUE;
+
+    /* the byte after a number is saved before the number is terminated */
+    literal_end = NULL;
+    saved = '\0';
+
+    for (ptr = text; ; ptr++)
+    {
+        c = (ptr == literal_end) ? saved : *ptr;
+        if (c == ' ' || c == '\n' || c == '\r' || c == '\t')
+            continue;
+        if (ptr >= end)
+            return depth == 0 && used > 0
+                && state == SLACK_JSON_TAPE_STATE_AFTER_VALUE;
+
+        if ((c == '}' && (state == SLACK_JSON_TAPE_STATE_OBJECT_START
+                          || state == SLACK_JSON_TAPE_STATE_AFTER_VALUE))
+            || (c == ']' && (state == SLACK_JSON_TAPE_STATE_ARRAY_START
+                             || state == SLACK_JSON_TAPE_STATE_AFTER_VALUE)))
+        {
+            if (depth == 0
+                || (c == '}') != (containers[depth]->type == SLACK_JSON_TAPE_OBJECT))
+                return 0;
+            value = containers[depth];
+            count = stack_length - stack_starts[depth];
+            value->count = count;
+            value->children = children;
+            memcpy(children, stack + stack_starts[depth],
+                   count * sizeof(*children));
+            children += count;
+            stack_length = stack_starts[depth];
+            depth--;
+            state = SLACK_JSON_TAPE_STATE_AFTER_VALUE;
+            continue;
+        }
+
+        switch (state)
+        {
+            case SLACK_JSON_TAPE_STATE_VALUE:
+            case SLACK_JSON_TAPE_STATE_ARRAY_START:
+                if (used >= size)
+                    return 0;
+                value = &tape[used++];
+                value->count = 0;
+                value->children = NULL;
+                value->key = key;
+                value->string = NULL;
+                key = NULL;
+                if (depth > 0)
+                    stack[stack_length++] = value;
+
+                state = SLACK_JSON_TAPE_STATE_AFTER_VALUE;
+                switch (c)
+                {
+                    case '{':
+                    case '[':
+                        if (depth >= SLACK_JSON_MAX_DEPTH)
+                            return 0;
+                        value->type = (c == '{') ?
+                            SLACK_JSON_TAPE_OBJECT : SLACK_JSON_TAPE_ARRAY;
+                        depth++;
+                        containers[depth] = value;
+                        stack_starts[depth] = stack_length;
+                        state = (c == '{') ?
+                            SLACK_JSON_TAPE_STATE_OBJECT_START :
+                            SLACK_JSON_TAPE_STATE_ARRAY_START;
+                        break;
+                    case '"':
+                        value->type = SLACK_JSON_TAPE_STRING;
+                        value->string = ptr + 1;
+                        ptr = slack_json_tape_string(ptr + 1, end);
+                        if (!ptr)
+                            return 0;
+                        ptr--;
+                        break;
+                    case 't':
+                    case 'f':
+                    case 'n':
+                        value->type = (c == 't') ? SLACK_JSON_TAPE_TRUE :
+                            (c == 'f') ? SLACK_JSON_TAPE_FALSE :
+                            SLACK_JSON_TAPE_NULL;
+                        word = (c == 't') ? "true" :
+                            (c == 'f') ? "false" : "null";
+                        word_length = strlen(word);
+                        if (strncmp(ptr, word, word_length) != 0)
+                            return 0;
+                        if (c != 'n')
+                            value->string = word;
+                        ptr += word_length - 1;
+                        break;
+                    default:
+                        value->type = SLACK_JSON_TAPE_NUMBER;
+                        value->string = ptr;
+                        literal_end = (char *)slack_json_tape_number(ptr);
+                        if (!literal_end)
+                            return 0;
+                        saved = *literal_end;
+                        *literal_end = '\0';
+                        ptr = literal_end - 1;
+                        break;
+                }
+                break;
+            case SLACK_JSON_TAPE_STATE_OBJECT_START:
+            case SLACK_JSON_TAPE_STATE_OBJECT_KEY:
+                if (c != '"')
+                    return 0;
+                key = ptr + 1;
+                ptr = slack_json_tape_string(ptr + 1, end);
+                if (!ptr)
+                    return 0;
+                ptr--;
+                state = SLACK_JSON_TAPE_STATE_COLON;
+                break;
+            case SLACK_JSON_TAPE_STATE_COLON:
+                if (c != ':')
+                    return 0;
+                state = SLACK_JSON_TAPE_STATE_VALUE;
+                break;
+            case SLACK_JSON_TAPE_STATE_AFTER_VALUE:
+                if (depth == 0 || c != ',')
+                    return 0;
+                state = (containers[depth]->type == SLACK_JSON_TAPE_OBJECT) ?
+                    SLACK_JSON_TAPE_STATE_OBJECT_KEY :
+                    SLACK_JSON_TAPE_STATE_VALUE;
+                break;
+        }
+    }
+}
+
+struct t_slack_json_value *slack_json_parse(const char *string)
+{
+    struct t_slack_json_value *tape, **children, **stack;
+    size_t length;
+    long size;
+    char *text;
+
+    if (!string)
+        return NULL;
+
+    length = strlen(string);
+    size = slack_json_tape_count(string, string + length);
+    if (size < 0 || (size_t)size > INT_MAX)
+        return NULL;
+
+    tape = malloc(size * (sizeof(*tape) + sizeof(*children)) + length + 1);
+    stack = malloc(size * sizeof(*stack));
+    if (!tape || !stack)
+    {
+        free(tape);
+        free(stack);
+        return NULL;
+    }
+    children = (struct t_slack_json_value **)(tape + size);
+    text = (char *)(children + size);
+    memcpy(text, string, length + 1);
+
+    if (!slack_json_tape_build(tape, size, children, stack,
+                               text, text + length)
+        || tape->type == SLACK_JSON_TAPE_NULL)
+    {
+        free(tape);
+        tape = NULL;
+    }
+    free(stack);
+
+    return tape;
+}
+
+void slack_json_free(struct t_slack_json_value *root)
+{
+    free(root);
+}
+
+static struct t_slack_json_value *slack_json_tape_value(struct t_slack_json_value *value)
+{
+    return (value && value->type != SLACK_JSON_TAPE_NULL) ? value : NULL;
+}
+
+struct t_slack_json_value *slack_json_object_get(struct t_slack_json_value *object,
+                                                 const char *key)
+{
+    int i;
+
+    if (!object || object->type != SLACK_JSON_TAPE_OBJECT || !key)
+        return NULL;
+
+    /* the last of duplicate keys wins, as in json-c */
+    for (i = object->count - 1; i >= 0; i--)
+    {
+        if (strcmp(object->children[i]->key, key) == 0)
+            return slack_json_tape_value(object->children[i]);
+    }
+
+    return NULL;
+}
+
+void slack_json_object_map(struct t_slack_json_value *object,
+                           t_slack_json_member_cb *callback, void *data)
+{
+    int i;
+
+    if (!object || object->type != SLACK_JSON_TAPE_OBJECT)
+        return;
+
+    for (i = 0; i < object->count; i++)
+    {
+        (*callback)(data, object->children[i]->key,
+                    slack_json_tape_value(object->children[i]));
+    }
+}
+
+int slack_json_array_length(struct t_slack_json_value *array)
+{
+    if (!array || array->type != SLACK_JSON_TAPE_ARRAY)
+        return 0;
+
+    return array->count;
+}
+
+struct t_slack_json_value *slack_json_array_get(struct t_slack_json_value *array,
+                                                int index)
+{
+    if (!array || array->type != SLACK_JSON_TAPE_ARRAY
+        || index < 0 || index >= array->count)
+        return NULL;
+
+    return slack_json_tape_value(array->children[index]);
+}
+
+/*
+ * Scalars convert as in json-c; containers have no text here.
+ */
+
+const char *slack_json_get_string(struct t_slack_json_value *value)
+{
+    return (value) ? value->string : NULL;
+}
+
+int slack_json_get_boolean(struct t_slack_json_value *value)
+{
+    if (!value)
+        return 0;
+
+    switch (value->type)
+    {
+        case SLACK_JSON_TAPE_TRUE:
+            return 1;
+        case SLACK_JSON_TAPE_NUMBER:
+            return strtod(value->string, NULL) != 0;
+        case SLACK_JSON_TAPE_STRING:
+            return value->string[0] != '\0';
+        default:
+            return 0;
+    }
+}
+
+int slack_json_get_int(struct t_slack_json_value *value)
+{
+    double number;
+
+    if (!value)
+        return 0;
+
+    switch (value->type)
+    {
+        case SLACK_JSON_TAPE_TRUE:
+            return 1;
+        case SLACK_JSON_TAPE_NUMBER:
+        case SLACK_JSON_TAPE_STRING:
+            number = strtod(value->string, NULL);
+            if (number >= INT_MAX)
+                return INT_MAX;
+            if (number <= INT_MIN)
+                return INT_MIN;
+            return (int)number;
+        default:
+            return 0;
+    }
+}
@@ -0,0 +1,656 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, version 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "slack-json.h"
+
+/*
+ * Streaming decoder for API responses: input is fed in chunks as it comes
+ * off the socket, and only the values named in the endpoint's field table
+ * are kept, written straight into fixed-size structs. Memory use is the
+ * decoder itself, whatever the size of the response.
+ */
+
+enum t_slack_json_state
+{
+    SLACK_JSON_STATE_VALUE = 0,    /* a value is expected */
+    SLACK_JSON_STATE_OBJECT_START, /* after '{': a key or '}' */
+    SLACK_JSON_STATE_OBJECT_KEY,   /* after ',' in an object: a key */
+    SLACK_JSON_STATE_ARRAY_START,  /* after '[': a value or ']' */
+    SLACK_JSON_STATE_KEY,          /* inside a key */
+    SLACK_JSON_STATE_COLON,        /* after a key */
+    SLACK_JSON_STATE_STRING,       /* inside a string value */
+    SLACK_JSON_STATE_LITERAL,      /* inside a number, true, false or null */
+    SLACK_JSON_STATE_AFTER_VALUE,  /* a ',' or the end of the container */
+    SLACK_JSON_STATE_DONE,
+    SLACK_JSON_STATE_ERROR,
+};
+
+struct t_slack_json_decoder
+{
+    const struct t_slack_json_table *table;
+    void *data;
+    char *result;                  /* allocated after the decoder */
+    char *record;                  /* allocated after the result */
+
+    enum t_slack_json_state state;
+    int depth;
+    char containers[SLACK_JSON_MAX_DEPTH + 1];
+    int path_lengths[SLACK_JSON_MAX_DEPTH + 1];
+    char path[SLACK_JSON_MAX_PATH];
+    int path_length;
+    int records_depth;             /* depth of the records array, or 0 */
+    int record_depth;              /* depth of the current record, or 0 */
+
+    /* current key or literal */
+    char token[SLACK_JSON_MAX_TOKEN];
+    int token_length;
+    int token_overflow;
+
+    /* current string */
+    int escape;                    /* 1 after '\', 2 to 5 in \uXXXX */
+    unsigned int code_point;
+    unsigned int high_surrogate;
+    const struct t_slack_json_field *field; /* where the value goes */
+    char *destination;             /* result or record */
+    int field_index;
+    size_t string_length;
+    int string_cut;
+};
+
+static size_t slack_json_align(size_t size)
+{
+    return (size + sizeof(long double) - 1) & ~(sizeof(long double) - 1);
+}
+
+struct t_slack_json_decoder *slack_json_decoder_new(const struct t_slack_json_table *table,
+                                                    void *data)
+{
+    struct t_slack_json_decoder *decoder;
+    size_t size;
+
+    size = slack_json_align(sizeof(*decoder));
+    decoder = malloc(size + slack_json_align(table->result_size)
+                     + table->record_size);
+    if (!decoder)
+        return NULL;
+
+    decoder->table = table;
+    decoder->data = data;
+    decoder->result = (char *)decoder + size;
+    decoder->record = decoder->result + slack_json_align(table->result_size);
+    slack_json_decoder_reset(decoder);
+
+    return decoder;
+}
+
+void slack_json_decoder_reset(struct t_slack_json_decoder *decoder)
+{
+    if (!decoder)
+        return;
+
+    decoder->state = SLACK_JSON_STATE_VALUE;
+    decoder->depth = 0;
+    decoder->path_lengths[0] = 0;
+    decoder->path_length = 0;
+    decoder->records_depth = 0;
+    decoder->record_depth = 0;
+    decoder->token_length = 0;
+    decoder->token_overflow = 0;
+    decoder->escape = 0;
+    decoder->high_surrogate = 0;
+    decoder->field = NULL;
+    decoder->destination = NULL;
+    memset(decoder->result, 0, decoder->table->result_size);
+}
+
+static void slack_json_set_found(struct t_slack_json_decoder *decoder)
+{
+    *((unsigned int *)decoder->destination) |= 1U << decoder->field_index;
+}
+
+/*
+ * Looks up the field of the key that just ended, from its full path.
+ */
+
+static void slack_json_field_search(struct t_slack_json_decoder *decoder)
+{
+    const struct t_slack_json_field *fields;
+    const char *path;
+    int num_fields, i;
+
+    decoder->field = NULL;
+
+    if (decoder->record_depth)
+    {
+        /* record paths start after "records[]." */
+        path = decoder->path + decoder->path_lengths[decoder->record_depth] + 1;
+        fields = decoder->table->record_fields;
+        num_fields = decoder->table->num_record_fields;
+        decoder->destination = decoder->record;
+    }
+    else
+    {
+        path = decoder->path;
+        fields = decoder->table->fields;
+        num_fields = decoder->table->num_fields;
+        decoder->destination = decoder->result;
+    }
+
+    for (i = 0; i < num_fields; i++)
+    {
+        if (strcmp(fields[i].path, path) == 0)
+        {
+            decoder->field = &fields[i];
+            decoder->field_index = i;
+            return;
+        }
+    }
+}
+
+static int slack_json_key_end(struct t_slack_json_decoder *decoder)
+{
+    int length;
+
+    length = decoder->path_lengths[decoder->depth];
+    if (length + 1 + decoder->token_length + 1 > SLACK_JSON_MAX_PATH)
+        return 0;
+
+    if (length > 0)
+        decoder->path[length++] = '.';
+    memcpy(decoder->path + length, decoder->token, decoder->token_length);
+    length += decoder->token_length;
+    /* a key too long to keep must not match a shorter one */
+    if (decoder->token_overflow)
+        decoder->path[length++] = '\x01';
+    decoder->path[length] = '\0';
+    decoder->path_length = length;
+
+    slack_json_field_search(decoder);
+
+    return 1;
+}
+
+static int slack_json_push(struct t_slack_json_decoder *decoder, char container)
+{
+    if (decoder->depth >= SLACK_JSON_MAX_DEPTH)
+        return 0;
+
+    /* containers are skipped even where a scalar was expected */
+    decoder->field = NULL;
+
+    if (container == '['
+        && decoder->depth == 1 && decoder->table->records
+        && strcmp(decoder->path, decoder->table->records) == 0)
+        decoder->records_depth = decoder->depth + 1;
+
+    if (container == '{' && !decoder->record_depth
+        && decoder->records_depth && decoder->depth == decoder->records_depth)
+    {
+        decoder->record_depth = decoder->depth + 1;
+        memset(decoder->record, 0, decoder->table->record_size);
+    }
+
+    if (container == '[')
+    {
+        if (decoder->path_length + 3 > SLACK_JSON_MAX_PATH)
+            return 0;
+        memcpy(decoder->path + decoder->path_length, "[]", 3);
+        decoder->path_length += 2;
+    }
+
+    decoder->depth++;
+    decoder->containers[decoder->depth] = container;
+    decoder->path_lengths[decoder->depth] = decoder->path_length;
+
+    return 1;
+}
+
+static int slack_json_pop(struct t_slack_json_decoder *decoder, char end)
+{
+    if (decoder->depth == 0
+        || decoder->containers[decoder->depth] != ((end == '}') ? '{' : '['))
+        return 0;
+
+    if (decoder->depth == decoder->record_depth)
+    {
+        decoder->record_depth = 0;
+        if (decoder->table->record_cb)
+            (decoder->table->record_cb)(decoder->data, decoder->record);
+    }
+    if (decoder->depth == decoder->records_depth)
+        decoder->records_depth = 0;
+
+    decoder->depth--;
+    decoder->path_length = decoder->path_lengths[decoder->depth];
+    decoder->path[decoder->path_length] = '\0';
+
+    return 1;
+}
+
+/*
+ * Appends bytes to the current key, or to the current string field if it
+ * still fits; strings are cut later on a UTF-8 boundary.
+ */
+
+static void slack_json_string_append(struct t_slack_json_decoder *decoder,
+                                     const char *bytes, int length)
+{
+    char *string;
+    size_t space;
+
+    if (decoder->state == SLACK_JSON_STATE_KEY)
+    {
+        if (decoder->token_length + length >= SLACK_JSON_MAX_TOKEN)
+        {
+            decoder->token_overflow = 1;
+            return;
+        }
+        memcpy(decoder->token + decoder->token_length, bytes, length);
+        decoder->token_length += length;
+        return;
+    }
+
+    if (!decoder->field || decoder->field->type != SLACK_JSON_STRING)
+        return;
+
+    if (decoder->string_cut)
+        return;
+
+    space = decoder->field->size - 1 - decoder->string_length;
+    if ((size_t)length > space)
+    {
+        length = space;
+        decoder->string_cut = 1;
+    }
+
+    string = decoder->destination + decoder->field->offset;
+    memcpy(string + decoder->string_length, bytes, length);
+    decoder->string_length += length;
+}
+
+/*
+ * Writes a code point as UTF-8 (up to 4 bytes), returns the length.
+ */
+
+int slack_json_utf8_encode(unsigned int code_point, char *utf8)
+{
+    if (code_point < 0x80)
+    {
+        utf8[0] = code_point;
+        return 1;
+    }
+    if (code_point < 0x800)
+    {
+        utf8[0] = 0xC0 | (code_point >> 6);
+        utf8[1] = 0x80 | (code_point & 0x3F);
+        return 2;
+    }
+    if (code_point < 0x10000)
+    {
+        utf8[0] = 0xE0 | (code_point >> 12);
+        utf8[1] = 0x80 | ((code_point >> 6) & 0x3F);
+        utf8[2] = 0x80 | (code_point & 0x3F);
+        return 3;
+    }
+    utf8[0] = 0xF0 | (code_point >> 18);
+    utf8[1] = 0x80 | ((code_point >> 12) & 0x3F);
+    utf8[2] = 0x80 | ((code_point >> 6) & 0x3F);
+    utf8[3] = 0x80 | (code_point & 0x3F);
+    return 4;
+}
+
+static void slack_json_string_append_code_point(struct t_slack_json_decoder *decoder,
+                                                unsigned int c)
+{
+    char utf8[4];
+
+    slack_json_string_append(decoder, utf8, slack_json_utf8_encode(c, utf8));
+}
+
+/* a high surrogate not followed by a low one stands for nothing valid */
+static void slack_json_string_flush_surrogate(struct t_slack_json_decoder *decoder)
+{
+    if (decoder->high_surrogate)
+    {
+        decoder->high_surrogate = 0;
+        slack_json_string_append_code_point(decoder, 0xFFFD);
+    }
+}
+
+static int slack_json_string_escape(struct t_slack_json_decoder *decoder, char c)
+{
+    unsigned int code_point;
+
+    if (decoder->escape == 1)
+    {
+        decoder->escape = 0;
+        switch (c)
+        {
+            case '"': case '\\': case '/':
+                break;
+            case 'b': c = '\b'; break;
+            case 'f': c = '\f'; break;
+            case 'n': c = '\n'; break;
+            case 'r': c = '\r'; break;
+            case 't': c = '\t'; break;
+            case 'u':
+                decoder->escape = 2;
+                decoder->code_point = 0;
+                return 1;
+            default:
+                return 0;
+        }
+        slack_json_string_flush_surrogate(decoder);
+        slack_json_string_append(decoder, &c, 1);
+        return 1;
+    }
+
+    if (!isxdigit((unsigned char)c))
+        return 0;
+    decoder->code_point = (decoder->code_point << 4)
+        | ((c <= '9') ? c - '0' : (c | 0x20) - 'a' + 10);
+    if (++decoder->escape < 6)
+        return 1;
+
+    decoder->escape = 0;
+    code_point = decoder->code_point;
+    if (code_point >= 0xDC00 && code_point < 0xE000 && decoder->high_surrogate)
+    {
+        code_point = 0x10000 + ((decoder->high_surrogate - 0xD800) << 10)
+            + (code_point - 0xDC00);
+        decoder->high_surrogate = 0;
+    }
+    else
+    {
+        slack_json_string_flush_surrogate(decoder);
+        if (code_point >= 0xD800 && code_point < 0xDC00)
+        {
+            decoder->high_surrogate = code_point;
+            return 1;
+        }
+        if (code_point >= 0xDC00 && code_point < 0xE000)
+            code_point = 0xFFFD;
+    }
+    slack_json_string_append_code_point(decoder, code_point);
+
+    return 1;
+}
+
+static void slack_json_string_end(struct t_slack_json_decoder *decoder)
+{
+    char *string;
+    size_t length, start, sequence;
+    unsigned char lead;
+
+    slack_json_string_flush_surrogate(decoder);
+
+    if (!decoder->field || decoder->field->type != SLACK_JSON_STRING)
+        return;
+
+    string = decoder->destination + decoder->field->offset;
+    length = decoder->string_length;
+    if (decoder->string_cut)
+    {
+        /* drop a last character that lost its trailing bytes */
+        start = length;
+        while (start > 0 && ((unsigned char)string[start - 1] & 0xC0) == 0x80)
+            start--;
+        if (start > 0)
+        {
+            lead = string[start - 1];
+            sequence = (lead >= 0xF0) ? 4 : (lead >= 0xE0) ? 3 :
+                (lead >= 0xC0) ? 2 : 1;
+            if (start - 1 + sequence > length)
+                length = start - 1;
+        }
+    }
+    string[length] = '\0';
+    slack_json_set_found(decoder);
+}
+
+static int slack_json_literal_end(struct t_slack_json_decoder *decoder)
+{
+    const struct t_slack_json_field *field;
+    char *end;
+    long number;
+    int boolean;
+
+    if (decoder->token_overflow)
+        return 0;
+    decoder->token[decoder->token_length] = '\0';
+
+    field = decoder->field;
+    if (strcmp(decoder->token, "null") == 0)
+        return 1;
+    if (strcmp(decoder->token, "true") == 0
+        || strcmp(decoder->token, "false") == 0)
+    {
+        if (field && field->type == SLACK_JSON_BOOLEAN)
+        {
+            boolean = (decoder->token[0] == 't');
+            memcpy(decoder->destination + field->offset, &boolean,
+                   sizeof(boolean));
+            slack_json_set_found(decoder);
+        }
+        return 1;
+    }
+
+    strtod(decoder->token, &end);
+    if (end == decoder->token || *end)
+        return 0;
+    if (field && field->type == SLACK_JSON_INTEGER)
+    {
+        number = strtol(decoder->token, NULL, 10);
+        memcpy(decoder->destination + field->offset, &number, sizeof(number));
+        slack_json_set_found(decoder);
+    }
+
+    return 1;
+}
+
+static void slack_json_value_end(struct t_slack_json_decoder *decoder)
+{
+    decoder->field = NULL;
+    decoder->state = (decoder->depth == 0) ?
+        SLACK_JSON_STATE_DONE : SLACK_JSON_STATE_AFTER_VALUE;
+}
+
+/*
+ * Feeds the next chunk of the document. Returns 0 once the input is known
+ * not to be JSON, after which further input is ignored.
+ */
+
+int slack_json_decoder_feed(struct t_slack_json_decoder *decoder,
+                            const char *input, size_t length)
+{
+    size_t i;
+    char c;
+
+    if (!decoder)
+        return 0;
+
+    i = 0;
+    while (i < length && decoder->state != SLACK_JSON_STATE_ERROR)
+    {
+        c = input[i];
+
+        switch (decoder->state)
+        {
+            case SLACK_JSON_STATE_KEY:
+            case SLACK_JSON_STATE_STRING:
+                if (decoder->escape)
+                {
+                    if (!slack_json_string_escape(decoder, c))
+                        decoder->state = SLACK_JSON_STATE_ERROR;
+                }
+                else if (c == '\\')
+                    decoder->escape = 1;
+                else if (c == '"')
+                {
+                    if (decoder->state == SLACK_JSON_STATE_KEY)
+                    {
+                        slack_json_string_flush_surrogate(decoder);
+                        decoder->state = (slack_json_key_end(decoder)) ?
+                            SLACK_JSON_STATE_COLON : SLACK_JSON_STATE_ERROR;
+                    }
+                    else
+                    {
+                        slack_json_string_end(decoder);
+                        slack_json_value_end(decoder);
+                    }
+                }
+                else
+                {
+                    slack_json_string_flush_surrogate(decoder);
+                    slack_json_string_append(decoder, &c, 1);
+                }
+                i++;
+                continue;
+            case SLACK_JSON_STATE_LITERAL:
+                if (isalnum((unsigned char)c) || c == '-' || c == '+' || c == '.')
+                {
+                    if (decoder->token_length + 1 >= SLACK_JSON_MAX_TOKEN)
+                        decoder->token_overflow = 1;
+                    else
+                        decoder->token[decoder->token_length++] = c;
+                    i++;
+                    continue;
+                }
+                if (!slack_json_literal_end(decoder))
+                {
+                    decoder->state = SLACK_JSON_STATE_ERROR;
+                    continue;
+                }
+                slack_json_value_end(decoder);
+                /* the byte ending the literal belongs to what follows */
+                continue;
+            default:
+                break;
+        }
+
+        if (isspace((unsigned char)c))
+        {
+            i++;
+            continue;
+        }
+
+        switch (decoder->state)
+        {
+            case SLACK_JSON_STATE_ARRAY_START:
+                if (c == ']')
+                {
+                    if (slack_json_pop(decoder, c))
+                        slack_json_value_end(decoder);
+                    else
+                        decoder->state = SLACK_JSON_STATE_ERROR;
+                    break;
+                }
+                /* fallthrough */
+            case SLACK_JSON_STATE_VALUE:
+                if (decoder->depth > 0 && decoder->containers[decoder->depth] == '[')
+                {
+                    decoder->path_length = decoder->path_lengths[decoder->depth];
+                    decoder->path[decoder->path_length] = '\0';
+                    decoder->field = NULL;
+                }
+                if (c == '{' || c == '[')
+                {
+                    decoder->state = (!slack_json_push(decoder, c)) ?
+                        SLACK_JSON_STATE_ERROR : (c == '{') ?
+                        SLACK_JSON_STATE_OBJECT_START : SLACK_JSON_STATE_ARRAY_START;
+                }
+                else if (c == '"')
+                {
+                    decoder->string_length = 0;
+                    decoder->string_cut = 0;
+                    decoder->escape = 0;
+                    decoder->state = SLACK_JSON_STATE_STRING;
+                }
+                else if (isalnum((unsigned char)c) || c == '-')
+                {
+                    decoder->token_length = 0;
+                    decoder->token_overflow = 0;
+                    decoder->state = SLACK_JSON_STATE_LITERAL;
+                    continue;
+                }
+                else
+                    decoder->state = SLACK_JSON_STATE_ERROR;
+                break;
+            case SLACK_JSON_STATE_OBJECT_START:
+                if (c == '}')
+                {
+                    if (slack_json_pop(decoder, c))
+                        slack_json_value_end(decoder);
+                    else
+                        decoder->state = SLACK_JSON_STATE_ERROR;
+                    break;
+                }
+                /* fallthrough */
+            case SLACK_JSON_STATE_OBJECT_KEY:
+                if (c == '"')
+                {
+                    decoder->token_length = 0;
+                    decoder->token_overflow = 0;
+                    decoder->escape = 0;
+                    decoder->state = SLACK_JSON_STATE_KEY;
+                }
+                else
+                    decoder->state = SLACK_JSON_STATE_ERROR;
+                break;
+            case SLACK_JSON_STATE_COLON:
+                decoder->state = (c == ':') ?
+                    SLACK_JSON_STATE_VALUE : SLACK_JSON_STATE_ERROR;
+                break;
+            case SLACK_JSON_STATE_AFTER_VALUE:
+                if (c == ',')
+                {
+                    decoder->state =
+                        (decoder->containers[decoder->depth] == '{') ?
+                        SLACK_JSON_STATE_OBJECT_KEY : SLACK_JSON_STATE_VALUE;
+                }
+                else if ((c == '}' || c == ']') && slack_json_pop(decoder, c))
+                    slack_json_value_end(decoder);
+                else
+                    decoder->state = SLACK_JSON_STATE_ERROR;
+                break;
+            default: /* done: only whitespace may follow */
+                decoder->state = SLACK_JSON_STATE_ERROR;
+                break;
+        }
+        i++;
+    }
+
+    return decoder->state != SLACK_JSON_STATE_ERROR;
+}
+
+/*
+ * Ends the document. Returns the result struct if a complete JSON value
+ * was read, NULL otherwise.
+ */
+
+const void *slack_json_decoder_finish(struct t_slack_json_decoder *decoder)
+{
+    if (!decoder)
+        return NULL;
+
+    /* a number can only end with the input */
+    if (decoder->state == SLACK_JSON_STATE_LITERAL)
+    {
+        if (slack_json_literal_end(decoder))
+            slack_json_value_end(decoder);
+        else
+            decoder->state = SLACK_JSON_STATE_ERROR;
+    }
+
+    return (decoder->state == SLACK_JSON_STATE_DONE) ? decoder->result : NULL;
+}
+
+void slack_json_decoder_free(struct t_slack_json_decoder *decoder)
+{
+    free(decoder);
+}
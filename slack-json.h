@@ -0,0 +1,107 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, version 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef _SLACK_JSON_H_
+#define _SLACK_JSON_H_
+
+#include <stddef.h>
+
+#define SLACK_JSON_MAX_DEPTH 32
+#define SLACK_JSON_MAX_PATH 256
+#define SLACK_JSON_MAX_TOKEN 64
+
+enum t_slack_json_type
+{
+    SLACK_JSON_STRING = 0, /* char[], cut to fit on a UTF-8 boundary */
+    SLACK_JSON_BOOLEAN,    /* int */
+    SLACK_JSON_INTEGER,    /* long */
+};
+
+/*
+ * A value to keep: path is the dot-separated keys leading to it (from the
+ * record for record fields), offset and size locate it in the destination
+ * struct. Values found set the bit of the field's index in the struct's
+ * found mask; anything else in the document is skipped.
+ */
+struct t_slack_json_field
+{
+    const char *path;
+    enum t_slack_json_type type;
+    size_t offset;
+    size_t size;
+};
+
+#define SLACK_JSON_FIELD(__struct, __path, __type, __member)            \
+    { __path, __type, offsetof(__struct, __member),                     \
+      sizeof(((__struct *)0)->__member) }
+
+#define SLACK_JSON_FOUND(__struct_ptr, __index)                         \
+    ((__struct_ptr)->found & (1U << (__index)))
+
+/*
+ * Fields of a response: top-level fields go to a result struct, and each
+ * object of the top-level array named records is decoded into a record
+ * struct handed to record_cb as soon as it ends. Both structs start with
+ * an unsigned int found mask.
+ */
+struct t_slack_json_table
+{
+    const struct t_slack_json_field *fields;
+    int num_fields;
+    size_t result_size;
+    const char *records;
+    const struct t_slack_json_field *record_fields;
+    int num_record_fields;
+    size_t record_size;
+    void (*record_cb)(void *data, const void *record);
+};
+
+struct t_slack_json_decoder;
+
+struct t_slack_json_decoder *slack_json_decoder_new(const struct t_slack_json_table *table,
+                                                    void *data);
+
+void slack_json_decoder_reset(struct t_slack_json_decoder *decoder);
+
+int slack_json_decoder_feed(struct t_slack_json_decoder *decoder,
+                            const char *input, size_t length);
+
+const void *slack_json_decoder_finish(struct t_slack_json_decoder *decoder);
+
+void slack_json_decoder_free(struct t_slack_json_decoder *decoder);
+
+int slack_json_utf8_encode(unsigned int code_point, char *utf8);
+
+/*
+ * Whole documents, for responses and events read as a tree. The backend
+ * is chosen at build time (JSON_BACKEND in the Makefile): json-c, or the
+ * tape parser. As with json-c, a JSON null reads as a missing value.
+ */
+struct t_slack_json_value;
+
+typedef void (t_slack_json_member_cb)(void *data, const char *key,
+                                      struct t_slack_json_value *value);
+
+struct t_slack_json_value *slack_json_parse(const char *string);
+
+void slack_json_free(struct t_slack_json_value *root);
+
+struct t_slack_json_value *slack_json_object_get(struct t_slack_json_value *object,
+                                                 const char *key);
+
+void slack_json_object_map(struct t_slack_json_value *object,
+                           t_slack_json_member_cb *callback, void *data);
+
+int slack_json_array_length(struct t_slack_json_value *array);
+
+struct t_slack_json_value *slack_json_array_get(struct t_slack_json_value *array,
+                                                int index);
+
+const char *slack_json_get_string(struct t_slack_json_value *value);
+
+int slack_json_get_boolean(struct t_slack_json_value *value);
+
+int slack_json_get_int(struct t_slack_json_value *value);
+
+#endif /*SLACK_JSON_H*/
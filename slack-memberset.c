@@ -0,0 +1,205 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, version 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "slack-memberset.h"
+
+static uint32_t slack_memberset_lower_bound(struct t_slack_memberset *set,
+                                            uint32_t index)
+{
+    uint32_t low, high, middle;
+
+    low = 0;
+    high = set->count;
+    while (low < high)
+    {
+        middle = low + (high - low) / 2;
+        if (set->indexes[middle] < index)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    return low;
+}
+
+static int slack_memberset_bitmap_reserve(struct t_slack_memberset *set,
+                                          uint32_t words)
+{
+    uint32_t *new_bitmap;
+
+    if (words <= set->bitmap_words)
+        return 1;
+
+    new_bitmap = realloc(set->bitmap, words * sizeof(*new_bitmap));
+    if (!new_bitmap)
+        return 0;
+    memset(new_bitmap + set->bitmap_words, 0,
+           (words - set->bitmap_words) * sizeof(*new_bitmap));
+
+    set->bitmap = new_bitmap;
+    set->bitmap_words = words;
+
+    return 1;
+}
+
+static void slack_memberset_to_bitmap(struct t_slack_memberset *set,
+                                      uint32_t universe)
+{
+    uint32_t i, words;
+
+    words = (universe + 31) / 32;
+    if (set->count && set->indexes[set->count - 1] / 32 >= words)
+        words = set->indexes[set->count - 1] / 32 + 1;
+
+    if (!slack_memberset_bitmap_reserve(set, words))
+        return; /* stay a sorted array */
+
+    for (i = 0; i < set->count; i++)
+        set->bitmap[set->indexes[i] / 32] |= 1u << (set->indexes[i] % 32);
+
+    free(set->indexes);
+    set->indexes = NULL;
+    set->size = 0;
+}
+
+struct t_slack_memberset *slack_memberset_new()
+{
+    struct t_slack_memberset *new_set;
+
+    new_set = malloc(sizeof(*new_set));
+    if (!new_set)
+        return NULL;
+
+    new_set->indexes = NULL;
+    new_set->count = 0;
+    new_set->size = 0;
+    new_set->bitmap = NULL;
+    new_set->bitmap_words = 0;
+
+    return new_set;
+}
+
+void slack_memberset_clear(struct t_slack_memberset *set)
+{
+    if (set->indexes)
+        free(set->indexes);
+    if (set->bitmap)
+        free(set->bitmap);
+
+    set->indexes = NULL;
+    set->count = 0;
+    set->size = 0;
+    set->bitmap = NULL;
+    set->bitmap_words = 0;
+}
+
+void slack_memberset_free(struct t_slack_memberset *set)
+{
+    if (!set)
+        return;
+
+    slack_memberset_clear(set);
+    free(set);
+}
+
+int slack_memberset_add(struct t_slack_memberset *set,
+                        uint32_t index, uint32_t universe)
+{
+    uint32_t position, new_size, *new_indexes;
+
+    if (set->bitmap)
+    {
+        if (!slack_memberset_bitmap_reserve(set, index / 32 + 1))
+            return -1;
+        if (set->bitmap[index / 32] & (1u << (index % 32)))
+            return 0;
+        set->bitmap[index / 32] |= 1u << (index % 32);
+        set->count++;
+        return 1;
+    }
+
+    position = slack_memberset_lower_bound(set, index);
+    if (position < set->count && set->indexes[position] == index)
+        return 0;
+
+    if (set->count == set->size)
+    {
+        new_size = set->size ? set->size * 2 : 8;
+        new_indexes = realloc(set->indexes, new_size * sizeof(*new_indexes));
+        if (!new_indexes)
+            return -1;
+        set->indexes = new_indexes;
+        set->size = new_size;
+    }
+
+    memmove(&set->indexes[position + 1], &set->indexes[position],
+            (set->count - position) * sizeof(*set->indexes));
+    set->indexes[position] = index;
+    set->count++;
+
+    /* a bitmap costs universe / 8 bytes, the array 4 bytes per member */
+    if (set->count >= SLACK_MEMBERSET_BITMAP_MIN
+        && (uint64_t)set->count * 32 > universe)
+        slack_memberset_to_bitmap(set, universe);
+
+    return 1;
+}
+
+int slack_memberset_contains(struct t_slack_memberset *set, uint32_t index)
+{
+    uint32_t position;
+
+    if (set->bitmap)
+        return index / 32 < set->bitmap_words
+            && (set->bitmap[index / 32] & (1u << (index % 32)));
+
+    position = slack_memberset_lower_bound(set, index);
+    return position < set->count && set->indexes[position] == index;
+}
+
+/*
+ * Iterates over the set in ascending order: *position must be 0 on the first
+ * call; returns 0 when there are no more members.
+ */
+
+int slack_memberset_next(struct t_slack_memberset *set,
+                         uint32_t *position, uint32_t *index)
+{
+    uint32_t word, bits;
+
+    if (!set->bitmap)
+    {
+        if (*position >= set->count)
+            return 0;
+        *index = set->indexes[(*position)++];
+        return 1;
+    }
+
+    for (word = *position / 32; word < set->bitmap_words; word++)
+    {
+        bits = set->bitmap[word];
+        if (word == *position / 32)
+            bits &= ~0u << (*position % 32);
+        if (bits)
+        {
+            *index = word * 32 + __builtin_ctz(bits);
+            *position = *index + 1;
+            return 1;
+        }
+    }
+    *position = set->bitmap_words * 32;
+
+    return 0;
+}
+
+size_t slack_memberset_memory(struct t_slack_memberset *set)
+{
+    if (!set)
+        return 0;
+
+    return sizeof(*set) + (set->size + set->bitmap_words) * sizeof(uint32_t);
+}
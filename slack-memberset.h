@@ -0,0 +1,44 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, version 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef _SLACK_MEMBERSET_H_
+#define _SLACK_MEMBERSET_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* sets larger than this switch to a bitmap once it is the smaller form */
+#define SLACK_MEMBERSET_BITMAP_MIN 1024
+
+/*
+ * Set of workspace user indexes (see t_slack_user.index). Small sets are a
+ * sorted array of indexes (4 bytes per member, binary searched); very large
+ * sets become a bitmap over the whole user index space.
+ */
+struct t_slack_memberset
+{
+    uint32_t *indexes;
+    uint32_t count;
+    uint32_t size;
+    uint32_t *bitmap;
+    uint32_t bitmap_words;
+};
+
+struct t_slack_memberset *slack_memberset_new();
+
+void slack_memberset_clear(struct t_slack_memberset *set);
+
+void slack_memberset_free(struct t_slack_memberset *set);
+
+int slack_memberset_add(struct t_slack_memberset *set,
+                        uint32_t index, uint32_t universe);
+
+int slack_memberset_contains(struct t_slack_memberset *set, uint32_t index);
+
+int slack_memberset_next(struct t_slack_memberset *set,
+                         uint32_t *position, uint32_t *index);
+
+size_t slack_memberset_memory(struct t_slack_memberset *set);
+
+#endif /*SLACK_MEMBERSET_H*/
@@ -3,247 +3,710 @@
 // file, You can obtain one at http://mozilla.org/MPL/2.0/.
 
 #include <libwebsockets.h>
+#include <ctype.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
-#include <regex.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
-#include "../weechat-plugin.h"
-#include "../slack.h"
-#include "../slack-workspace.h"
-#include "../slack-channel.h"
-#include "../slack-user.h"
-#include "../slack-message.h"
+#include "weechat-plugin.h"
+#include "slack.h"
+#include "slack-color.h"
+#include "slack-config.h"
+#include "slack-id.h"
+#include "slack-workspace.h"
+#include "slack-channel.h"
+#include "slack-user.h"
+#include "slack-emoji.h"
+#include "slack-message.h"
 
-static const char format_regex[] = "<([^>]*?)>";
-static const size_t max_groups = 2;
+/* growable output string, sized from the input so it rarely grows */
+struct t_slack_message_builder
+{
+    char *string;
+    size_t length;
+    size_t size;
+};
+
+static int slack_message_builder_init(struct t_slack_message_builder *builder,
+                                      size_t size)
+{
+    builder->string = malloc(size);
+    builder->length = 0;
+    builder->size = (builder->string) ? size : 0;
+
+    return builder->string != NULL;
+}
+
+static int slack_message_builder_reserve(struct t_slack_message_builder *builder,
+                                         size_t length)
+{
+    char *new_string;
+    size_t new_size;
+
+    if (!builder->string)
+        return 0;
+    if (builder->length + length < builder->size)
+        return 1;
+
+    new_size = builder->size * 2;
+    while (builder->length + length >= new_size)
+        new_size *= 2;
+    new_string = realloc(builder->string, new_size);
+    if (!new_string)
+    {
+        free(builder->string);
+        builder->string = NULL;
+        return 0;
+    }
+    builder->string = new_string;
+    builder->size = new_size;
+
+    return 1;
+}
+
+static void slack_message_builder_append(struct t_slack_message_builder *builder,
+                                         const char *str, size_t length)
+{
+    if (!slack_message_builder_reserve(builder, length))
+        return;
+
+    memcpy(builder->string + builder->length, str, length);
+    builder->length += length;
+}
+
+static inline void slack_message_builder_append_string(
+    struct t_slack_message_builder *builder, const char *str)
+{
+    slack_message_builder_append(builder, str, strlen(str));
+}
+
+static inline void slack_message_builder_append_color(
+    struct t_slack_message_builder *builder, enum t_slack_color color)
+{
+    slack_message_builder_append(builder, slack_color_escapes[color].string,
+                                 slack_color_escapes[color].length);
+}
 
-char *slack_message_translate_code(struct t_slack_workspace *workspace,
-                                   const char *code)
+/*
+ * Appends the entity at str (which starts with '&'), decoding the three that
+ * Slack escapes (&amp; &lt; &gt;); returns the number of bytes consumed.
+ */
+
+static size_t slack_message_builder_append_entity(
+    struct t_slack_message_builder *builder, const char *str, size_t length)
+{
+    if (length >= 4 && memcmp(str, "&gt;", 4) == 0)
+    {
+        slack_message_builder_append(builder, ">", 1);
+        return 4;
+    }
+    if (length >= 4 && memcmp(str, "&lt;", 4) == 0)
+    {
+        slack_message_builder_append(builder, "<", 1);
+        return 4;
+    }
+    if (length >= 5 && memcmp(str, "&amp;", 5) == 0)
+    {
+        slack_message_builder_append(builder, "&", 1);
+        return 5;
+    }
+
+    slack_message_builder_append(builder, "&", 1);
+    return 1;
+}
+
+static void slack_message_builder_append_text(struct t_slack_message_builder *builder,
+                                              const char *str, size_t length)
+{
+    const char *ptr_str, *end, *amp;
+
+    ptr_str = str;
+    end = str + length;
+    while (ptr_str < end
+           && (amp = memchr(ptr_str, '&', end - ptr_str)))
+    {
+        slack_message_builder_append(builder, ptr_str, amp - ptr_str);
+        ptr_str = amp + slack_message_builder_append_entity(builder, amp,
+                                                            end - amp);
+    }
+    slack_message_builder_append(builder, ptr_str, end - ptr_str);
+}
+
+static t_slack_id slack_message_code_id(const char *str, size_t length)
+{
+    char id[SLACK_ID_MAX_LEN + 1];
+
+    if (length == 0 || length > SLACK_ID_MAX_LEN)
+        return SLACK_ID_NONE;
+
+    memcpy(id, str, length);
+    id[length] = '\0';
+
+    return slack_id_encode(id);
+}
+
+/*
+ * Appends the rendering of a <...> code (without the angle brackets).
+ */
+
+static void slack_message_translate_code(struct t_slack_workspace *workspace,
+                                         struct t_slack_message_builder *builder,
+                                         const char *code, size_t length)
 {
     struct t_slack_channel *channel;
     struct t_slack_user *user;
-    size_t resultlen;
-    char *identifier, *alttext, *result, *symbol, *prefix;
+    const char *alttext, *prefix, *symbol;
+    size_t identifier_length, symbol_length;
 
-    identifier = strdup(code);
-    alttext = strchr(identifier, '|');
-    if (alttext)
-        *alttext++ = '\0';
+    alttext = memchr(code, '|', length);
+    identifier_length = (alttext) ? (size_t)(alttext - code) : length;
 
-    switch (identifier[0])
+    prefix = "";
+    symbol = code;
+    symbol_length = length;
+    if (length > 0)
     {
-        case '#': /* channel */
-            if (alttext)
-            {
-                prefix = "#";
-                symbol = strdup(alttext);
-            }
-            else
-            {
-                channel = slack_channel_search(workspace, identifier+1);
-                if (channel)
+        switch (code[0])
+        {
+            case '#': /* channel */
+            case '@': /* user */
+                prefix = (code[0] == '#') ? "#" : "@";
+                if (alttext)
+                {
+                    symbol = alttext + 1;
+                    symbol_length = length - identifier_length - 1;
+                    break;
+                }
+                symbol = code + 1;
+                symbol_length = identifier_length - 1;
+                if (code[0] == '#')
                 {
-                    prefix = "#";
-                    symbol = strdup(channel->name);
+                    channel = slack_channel_search_id(
+                        workspace, slack_message_code_id(symbol, symbol_length));
+                    if (channel)
+                    {
+                        symbol = channel->name;
+                        symbol_length = strlen(symbol);
+                    }
+                    else
+                        prefix = "Channel:";
                 }
                 else
                 {
-                    prefix = "Channel:";
-                    symbol = strdup(identifier+1);
+                    user = slack_user_search_id(
+                        workspace, slack_message_code_id(symbol, symbol_length));
+                    if (user)
+                    {
+                        symbol = user->profile.display_name;
+                        symbol_length = strlen(symbol);
+                    }
+                    else
+                        prefix = "User:";
                 }
-            }
-            break;
-        case '@': /* user */
-            if (alttext)
-            {
+                break;
+            case '!': /* special */
                 prefix = "@";
-                symbol = strdup(alttext);
-            }
-            else
-            {
-                user = slack_user_search(workspace, identifier+1);
-                if (user)
+                if (alttext)
                 {
-                    prefix = "@";
-                    symbol = strdup(user->profile.display_name);
+                    symbol = alttext + 1;
+                    symbol_length = length - identifier_length - 1;
                 }
                 else
                 {
-                    prefix = "User:";
-                    symbol = strdup(identifier+1);
+                    symbol = code + 1;
+                    symbol_length = length - 1;
                 }
-            }
+                break;
+            default: /* url */
+                break;
+        }
+    }
+
+    slack_message_builder_append_color(builder, SLACK_COLOR_CHAT_NICK);
+    slack_message_builder_append_string(builder, prefix);
+    slack_message_builder_append_text(builder, symbol, symbol_length);
+    slack_message_builder_append_color(builder, SLACK_COLOR_RESETCOLOR);
+}
+
+enum t_slack_message_style
+{
+    SLACK_MESSAGE_STYLE_BOLD = 0,
+    SLACK_MESSAGE_STYLE_ITALIC,
+    SLACK_MESSAGE_STYLE_STRIKE,
+    SLACK_MESSAGE_STYLE_CODE,
+    /* number of styles */
+    SLACK_MESSAGE_NUM_STYLES,
+};
+
+static const char slack_message_style_markers[SLACK_MESSAGE_NUM_STYLES] =
+{ '*', '_', '~', '`' };
+
+/*
+ * mrkdwn state while decoding: offsets are into the message text, 0 meaning
+ * unset (a closing marker can never be the first byte).
+ */
+struct t_slack_message_format
+{
+    size_t close[SLACK_MESSAGE_NUM_STYLES];   /* closing marker of open span */
+    size_t no_close[SLACK_MESSAGE_NUM_STYLES];/* no closer before this offset */
+    int fenced;                               /* code span is a ``` block */
+};
+
+/* bytes that start markup: '<' codes, entities, mrkdwn and :emoji: */
+static const unsigned char slack_message_special[256] =
+{
+    ['<'] = 1, ['&'] = 1, ['*'] = 1, ['_'] = 1, ['~'] = 1, ['`'] = 1,
+    [':'] = 1,
+};
+
+static inline int slack_message_is_word(char c)
+{
+    return (unsigned char)c >= 0x80 || isalnum((unsigned char)c);
+}
+
+static void slack_message_format_on(struct t_slack_message_builder *builder,
+                                    enum t_slack_message_style style)
+{
+    switch (style)
+    {
+        case SLACK_MESSAGE_STYLE_BOLD:
+            slack_message_builder_append_color(builder, SLACK_COLOR_BOLD);
             break;
-        case '!': /* special */
-            if (alttext)
-            {
-                prefix = "@";
-                symbol = strdup(alttext);
-            }
-            else
-            {
-                prefix = "@";
-                symbol = strdup(identifier+1);
-            }
+        case SLACK_MESSAGE_STYLE_ITALIC:
+            slack_message_builder_append_color(builder, SLACK_COLOR_ITALIC);
+            break;
+        case SLACK_MESSAGE_STYLE_STRIKE:
+            /* no strikethrough attribute: keep the markers, dimmed */
+            slack_message_builder_append_color(builder,
+                                               SLACK_COLOR_CHAT_DELIMITERS);
+            slack_message_builder_append(builder, "~", 1);
+            slack_message_builder_append_color(builder, SLACK_COLOR_RESETCOLOR);
             break;
-        default: /* url */
-            prefix = "";
-            symbol = strdup(code);
+        case SLACK_MESSAGE_STYLE_CODE:
+            slack_message_builder_append_color(builder, SLACK_COLOR_CHAT_VALUE);
+            break;
+        case SLACK_MESSAGE_NUM_STYLES:
             break;
     }
-    
-    free(identifier);
-    resultlen = snprintf(NULL, 0, "%s%s%s%s", weechat_color("chat_nick"), prefix, symbol, weechat_color("reset")) + 1;
-    result = malloc(resultlen);
-    snprintf(result, resultlen, "%s%s%s%s", weechat_color("chat_nick"), prefix, symbol, weechat_color("reset"));
-    free(symbol);
-    
-    return result;
 }
 
-void slack_message_htmldecode(char *dest, const char *src, size_t n)
+static void slack_message_format_off(struct t_slack_message_builder *builder,
+                                     enum t_slack_message_style style)
 {
-    size_t i, j;
+    switch (style)
+    {
+        case SLACK_MESSAGE_STYLE_BOLD:
+            slack_message_builder_append_color(builder, SLACK_COLOR_UNBOLD);
+            break;
+        case SLACK_MESSAGE_STYLE_ITALIC:
+            slack_message_builder_append_color(builder, SLACK_COLOR_UNITALIC);
+            break;
+        case SLACK_MESSAGE_STYLE_STRIKE:
+            slack_message_format_on(builder, style);
+            break;
+        case SLACK_MESSAGE_STYLE_CODE:
+            slack_message_builder_append_color(builder, SLACK_COLOR_RESETCOLOR);
+            break;
+        case SLACK_MESSAGE_NUM_STYLES:
+            break;
+    }
+}
+
+/*
+ * Searches the closing marker of a *bold*, _italic_ or ~strike~ span opened
+ * at position: it must be on the same line, follow a non-space byte and not
+ * be followed by a word character. Returns 0 if there is none.
+ */
 
-    for (i = 0, j = 0; i < n; i++, j++)
-        switch (src[i])
+static size_t slack_message_format_closer(const char *text, size_t length,
+                                          size_t position, char marker,
+                                          size_t *line_end)
+{
+    const char *ptr_line_end, *ptr_close;
+    size_t close;
+
+    ptr_line_end = memchr(text + position, '\n', length - position);
+    *line_end = (ptr_line_end) ? (size_t)(ptr_line_end - text) : length;
+
+    close = position + 2;
+    while (close < *line_end
+           && (ptr_close = memchr(text + close, marker, *line_end - close)))
+    {
+        close = ptr_close - text;
+        if (!isspace((unsigned char)text[close - 1])
+            && (close + 1 == length || !slack_message_is_word(text[close + 1])))
+            return close;
+        close++;
+    }
+
+    return 0;
+}
+
+/*
+ * Renders the mrkdwn marker at position; returns the offset of the first
+ * byte after it.
+ */
+
+static size_t slack_message_format_marker(struct t_slack_message_format *format,
+                                          struct t_slack_message_builder *builder,
+                                          const char *text, size_t length,
+                                          size_t position)
+{
+    const char *ptr_close;
+    size_t close, line_end;
+    int style;
+
+    for (style = 0; style < SLACK_MESSAGE_NUM_STYLES; style++)
+    {
+        if (slack_message_style_markers[style] == text[position])
+            break;
+    }
+
+    if (format->close[style] && format->close[style] == position)
+    {
+        slack_message_format_off(builder, style);
+        format->close[style] = 0;
+        if (style == SLACK_MESSAGE_STYLE_CODE && format->fenced)
         {
-            case '\0':
-                dest[j] = '\0';
-                return;
-            case '&':
-                if (src[i+1] == 'g' &&
-                    src[i+2] == 't' &&
-                    src[i+3] == ';')
-                {
-                    dest[j] = '>';
-                    i += 3;
-                    break;
-                }
-                else if (src[i+1] == 'l' &&
-                         src[i+2] == 't' &&
-                         src[i+3] == ';')
-                {
-                    dest[j] = '<';
-                    i += 3;
-                    break;
-                }
-                else if (src[i+1] == 'a' &&
-                         src[i+2] == 'm' &&
-                         src[i+3] == 'p' &&
-                         src[i+4] == ';')
-                {
-                    dest[j] = '&';
-                    i += 4;
-                    break;
-                }
-                /* fallthrough */
-            default:
-                dest[j] = src[i];
-                break;
+            format->fenced = 0;
+            return position + 3;
+        }
+        return position + 1;
+    }
+
+    /* markers are literal inside code and inside a span of the same style */
+    if (format->close[SLACK_MESSAGE_STYLE_CODE] || format->close[style]
+        || position < format->no_close[style])
+    {
+        slack_message_builder_append(builder, text + position, 1);
+        return position + 1;
+    }
+
+    if (style == SLACK_MESSAGE_STYLE_CODE)
+    {
+        if (length - position >= 6 && memcmp(text + position, "```", 3) == 0)
+        {
+            ptr_close = text + position + 3;
+            while ((ptr_close = memchr(ptr_close, '`',
+                                       text + length - ptr_close))
+                   && text + length - ptr_close >= 3
+                   && memcmp(ptr_close, "```", 3) != 0)
+                ptr_close++;
+            if (ptr_close && text + length - ptr_close >= 3)
+            {
+                format->close[style] = ptr_close - text;
+                format->fenced = 1;
+                slack_message_format_on(builder, style);
+                return position + 3;
+            }
+        }
+        ptr_close = memchr(text + position + 1, '`', length - position - 1);
+        if (ptr_close && ptr_close > text + position + 1
+            && !memchr(text + position + 1, '\n', ptr_close - text - position - 1))
+        {
+            format->close[style] = ptr_close - text;
+            slack_message_format_on(builder, style);
+            return position + 1;
         }
-    dest[j-1] = '\0';
-    return;
+        slack_message_builder_append(builder, text + position, 1);
+        return position + 1;
+    }
+
+    if ((position == 0 || !slack_message_is_word(text[position - 1]))
+        && position + 1 < length && !isspace((unsigned char)text[position + 1]))
+    {
+        close = slack_message_format_closer(text, length, position,
+                                            text[position], &line_end);
+        if (close)
+        {
+            format->close[style] = close;
+            slack_message_format_on(builder, style);
+            return position + 1;
+        }
+        /* later markers on this line cannot be closed either */
+        format->no_close[style] = line_end;
+    }
+
+    slack_message_builder_append(builder, text + position, 1);
+    return position + 1;
 }
 
-char *slack_message_decode(struct t_slack_workspace *workspace,
-                           const char *text)
+/*
+ * Ends spans whose closing marker was consumed as part of something else
+ * (for example a <...> code), and resumes the code colour after a mention.
+ */
+
+static void slack_message_format_resume(struct t_slack_message_format *format,
+                                        struct t_slack_message_builder *builder,
+                                        size_t position)
 {
-    int rc;
-    regex_t reg;
-    regmatch_t groups[max_groups];
-    char msgbuf[100];
-    char *decoded_text;
-    const char *cursor;
-    size_t offset;
+    int style;
 
-    if ((rc = regcomp(&reg, format_regex, REG_EXTENDED)))
+    for (style = 0; style < SLACK_MESSAGE_NUM_STYLES; style++)
     {
-        regerror(rc, &reg, msgbuf, sizeof(msgbuf));
-        weechat_printf(
-            workspace->buffer,
-            _("%s%s: error compiling message formatting regex: %s"),
-            weechat_prefix("error"), SLACK_PLUGIN_NAME,
-            msgbuf);
-        return strdup(text);
+        if (format->close[style] && format->close[style] < position)
+        {
+            slack_message_format_off(builder, style);
+            format->close[style] = 0;
+            if (style == SLACK_MESSAGE_STYLE_CODE)
+                format->fenced = 0;
+        }
     }
+    if (format->close[SLACK_MESSAGE_STYLE_CODE])
+        slack_message_format_on(builder, SLACK_MESSAGE_STYLE_CODE);
+}
+
+/*
+ * Returns the offset of the nearest closing marker of an open span, or
+ * length if no span is open: markup ending past it would swallow the marker
+ * and leave its span open.
+ */
 
-    decoded_text = malloc(SLACK_MESSAGE_MAX_LENGTH);
-    if (!decoded_text)
+static size_t slack_message_format_limit(struct t_slack_message_format *format,
+                                         size_t length)
+{
+    int style;
+
+    for (style = 0; style < SLACK_MESSAGE_NUM_STYLES; style++)
+    {
+        if (format->close[style] && format->close[style] < length)
+            length = format->close[style];
+    }
+
+    return length;
+}
+
+/*
+ * Renders the ":shortcode:" starting at position as its unicode emoji;
+ * returns the offset after it, or 0 if it is not a known emoji.
+ */
+
+static size_t slack_message_emoji(struct t_slack_workspace *workspace,
+                                  struct t_slack_message_builder *builder,
+                                  const char *text, size_t length,
+                                  size_t position)
+{
+    const char *unicode;
+    size_t end;
+    char c;
+
+    for (end = position + 1;
+         end < length && end - position < SLACK_WORKSPACE_EMOJI_SHORTNAME_MAX_LEN;
+         end++)
+    {
+        c = text[end];
+        if (c == ':')
+            break;
+        if (!isalnum((unsigned char)c) && c != '_' && c != '-' && c != '+'
+            && c != '\'')
+            return 0;
+    }
+    if (end >= length || text[end] != ':' || end == position + 1)
+        return 0;
+
+    unicode = slack_emoji_get_unicode_by_shortcode(workspace, text + position,
+                                                   end - position + 1);
+    if (!unicode)
+        return 0;
+
+    slack_message_builder_append_string(builder, unicode);
+
+    return end + 1;
+}
+
+#if defined(__AVX2__)
+static inline unsigned int slack_message_scan_mask32(__m256i chunk)
+{
+    __m256i match;
+
+    match = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('<')),
+                        _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('&'))),
+        _mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('*')),
+                        _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('_'))));
+    match = _mm256_or_si256(
+        match,
+        _mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('~')),
+                        _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('`'))));
+    match = _mm256_or_si256(match,
+                            _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(':')));
+
+    return (unsigned int)_mm256_movemask_epi8(match);
+}
+#endif
+
+#if defined(__SSE2__)
+static inline unsigned int slack_message_scan_mask16(__m128i chunk)
+{
+    __m128i match;
+
+    match = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('<')),
+                     _mm_cmpeq_epi8(chunk, _mm_set1_epi8('&'))),
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('*')),
+                     _mm_cmpeq_epi8(chunk, _mm_set1_epi8('_'))));
+    match = _mm_or_si128(
+        match,
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('~')),
+                     _mm_cmpeq_epi8(chunk, _mm_set1_epi8('`'))));
+    match = _mm_or_si128(match, _mm_cmpeq_epi8(chunk, _mm_set1_epi8(':')));
+
+    return (unsigned int)_mm_movemask_epi8(match);
+}
+#endif
+
+/*
+ * Returns the offset of the first byte that may need decoding (see
+ * slack_message_special), or length if there is none. Compares 32 or 16
+ * bytes at a time when the compiler targets AVX2 or SSE2.
+ */
+
+static size_t slack_message_scan(const char *text, size_t length)
+{
+    size_t i;
+    unsigned int mask;
+
+    i = 0;
+#if defined(__AVX2__)
+    for (; i + 32 <= length; i += 32)
+    {
+        mask = slack_message_scan_mask32(
+            _mm256_loadu_si256((const __m256i *)(text + i)));
+        if (mask)
+            return i + __builtin_ctz(mask);
+    }
+#endif
+#if defined(__SSE2__)
+    for (; i + 16 <= length; i += 16)
+    {
+        mask = slack_message_scan_mask16(
+            _mm_loadu_si128((const __m128i *)(text + i)));
+        if (mask)
+            return i + __builtin_ctz(mask);
+    }
+#endif
+    (void) mask;
+    for (; i < length; i++)
+    {
+        if (slack_message_special[(unsigned char)text[i]])
+            return i;
+    }
+
+    return length;
+}
+
+/*
+ * Decodes Slack message markup in one left-to-right pass: <...> codes are
+ * rendered, entities decoded, :emoji: shortcodes replaced and mrkdwn (*bold*,
+ * _italic_, ~strike~, `code` and ``` blocks) turned into WeeChat attributes
+ * unless slack.look.render_mrkdwn is off, straight into a single output
+ * string. Runs of plain text between markup are copied in bulk.
+ *
+ * Returns NULL if the text has nothing to decode, so that callers can print
+ * it as is; otherwise the result must be freed by the caller.
+ */
+
+char *slack_message_decode(struct t_slack_workspace *workspace,
+                           const char *text)
+{
+    struct t_slack_message_builder builder;
+    struct t_slack_message_format format;
+    const char *end;
+    size_t length, position, next;
+    int closed, style, mrkdwn;
+
+    length = strlen(text);
+    position = slack_message_scan(text, length);
+    if (position == length)
+        return NULL;
+
+    if (!slack_message_builder_init(&builder, length + length / 2 + 64))
     {
-        regfree(&reg);
         weechat_printf(
             workspace->buffer,
             _("%s%s: error allocating space for message"),
-            weechat_prefix("error"), SLACK_PLUGIN_NAME);
-        return strdup(text);
+            SLACK_PREFIX_ERROR, SLACK_PLUGIN_NAME);
+        return NULL;
     }
-    decoded_text[0] = '\0';
+    slack_message_builder_append(&builder, text, position);
 
-    for (cursor = text; regexec(&reg, cursor, max_groups, groups, 0) == 0; cursor += offset)
+    memset(&format, 0, sizeof(format));
+    closed = 1;
+    mrkdwn = weechat_config_boolean(slack_config_look_render_mrkdwn);
+    while (position < length)
     {
-        offset = groups[0].rm_eo;
-
-        char *copy = strdup(cursor);
-        if (!copy)
+        if (text[position] == '<' && closed
+            && (end = memchr(text + position + 1, '>',
+                             length - position - 1)))
         {
-            regfree(&reg);
-            free(decoded_text);
-            weechat_printf(
-                workspace->buffer,
-                _("%s%s: error allocating space for message"),
-                weechat_prefix("error"), SLACK_PLUGIN_NAME);
-            return strdup(text);
+            slack_message_translate_code(workspace, &builder,
+                                         text + position + 1,
+                                         end - text - position - 1);
+            next = end - text + 1;
+            slack_message_format_resume(&format, &builder, next);
         }
-        copy[groups[1].rm_eo] = '\0';
-
-        char *match = strdup(copy + groups[1].rm_so);
-        if (!match)
+        else if (text[position] == '&')
         {
-            free(copy);
-            regfree(&reg);
-            free(decoded_text);
-            weechat_printf(
-                workspace->buffer,
-                _("%s%s: error allocating space for message"),
-                weechat_prefix("error"), SLACK_PLUGIN_NAME);
-            return strdup(text);
+            next = position + slack_message_builder_append_entity(
+                &builder, text + position, length - position);
         }
-        copy[groups[0].rm_so] = '\0';
-
-        char *prematch = strdup(copy);
-        if (!prematch)
+        else if (text[position] == ':')
         {
-            free(match);
-            free(copy);
-            regfree(&reg);
-            free(decoded_text);
-            weechat_printf(
-                workspace->buffer,
-                _("%s%s: error allocating space for message"),
-                weechat_prefix("error"), SLACK_PLUGIN_NAME);
-            return strdup(text);
+            next = (format.close[SLACK_MESSAGE_STYLE_CODE]) ? 0 :
+                slack_message_emoji(workspace, &builder, text,
+                                    slack_message_format_limit(&format, length),
+                                    position);
+            if (!next)
+            {
+                slack_message_builder_append(&builder, ":", 1);
+                next = position + 1;
+            }
+        }
+        else if (text[position] == '<')
+        {
+            /* no '>' left after this '<': copy it and stop looking */
+            slack_message_builder_append(&builder, "<", 1);
+            closed = 0;
+            next = position + 1;
+        }
+        else if (mrkdwn)
+        {
+            next = slack_message_format_marker(&format, &builder,
+                                               text, length, position);
+        }
+        else
+        {
+            slack_message_builder_append(&builder, text + position, 1);
+            next = position + 1;
         }
-        free(copy);
-
-        strncat(decoded_text, prematch,
-                SLACK_MESSAGE_MAX_LENGTH - strlen(decoded_text) - 1);
-        free(prematch);
 
-        char *replacement = slack_message_translate_code(workspace, match);
-        free(match);
+        position = next + slack_message_scan(text + next, length - next);
+        slack_message_builder_append(&builder, text + next, position - next);
+    }
 
-        strncat(decoded_text, replacement,
-                SLACK_MESSAGE_MAX_LENGTH - strlen(decoded_text) - 1);
-        free(replacement);
+    for (style = 0; style < SLACK_MESSAGE_NUM_STYLES; style++)
+    {
+        if (format.close[style])
+        {
+            slack_message_builder_append_color(&builder, SLACK_COLOR_RESET);
+            break;
+        }
     }
-    strncat(decoded_text, cursor,
-            SLACK_MESSAGE_MAX_LENGTH - strlen(decoded_text) - 1);
 
-    slack_message_htmldecode(decoded_text, decoded_text,
-                             SLACK_MESSAGE_MAX_LENGTH);
+    if (!slack_message_builder_reserve(&builder, 1))
+    {
+        weechat_printf(
+            workspace->buffer,
+            _("%s%s: error allocating space for message"),
+            SLACK_PREFIX_ERROR, SLACK_PLUGIN_NAME);
+        return NULL;
+    }
+    builder.string[builder.length] = '\0';
 
-    regfree(&reg);
-    return decoded_text;
+    return builder.string;
 }
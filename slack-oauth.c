@@ -5,10 +5,11 @@
 #include <stdlib.h>
 #include <string.h>
 #include <libwebsockets.h>
-#include <json.h>
 
 #include "weechat-plugin.h"
 #include "slack.h"
+#include "slack-json.h"
+#include "slack-color.h"
 #include "slack-oauth.h"
 
 static void (*weechat_callback)(char *token);
@@ -23,14 +24,14 @@ static struct lws_context *context = NULL;
 
 static struct t_hook *slack_oauth_hook_timer = NULL;
 
-static inline int json_valid(json_object *object)
+static inline int json_valid(struct t_slack_json_value *object)
 {
     if (!object)
     {
         weechat_printf(
             NULL,
             _("%s%s: error retrieving token: unexpected response from server"),
-            weechat_prefix("error"), SLACK_PLUGIN_NAME);
+            SLACK_PREFIX_ERROR, SLACK_PLUGIN_NAME);
         return 0;
     }
 
@@ -49,7 +50,7 @@ static int callback_http(struct lws *wsi, enum lws_callback_reasons reason,
         weechat_printf(
             NULL,
             _("%s%s: error connecting to slack: %s"),
-            weechat_prefix("error"), SLACK_PLUGIN_NAME,
+            SLACK_PREFIX_ERROR, SLACK_PLUGIN_NAME,
             in ? (char *)in : "(null)");
         client_wsi = NULL;
         break;
@@ -59,7 +60,7 @@ static int callback_http(struct lws *wsi, enum lws_callback_reasons reason,
         weechat_printf(
             NULL,
             _("%s%s: retrieving token... (%d)"),
-            weechat_prefix("network"), SLACK_PLUGIN_NAME,
+            SLACK_PREFIX_NETWORK, SLACK_PLUGIN_NAME,
             status);
         break;
 
@@ -67,29 +68,29 @@ static int callback_http(struct lws *wsi, enum lws_callback_reasons reason,
     case LWS_CALLBACK_RECEIVE_CLIENT_HTTP_READ:
         {
             char *json_string = weechat_strndup(in, (int)len);
-            json_object *response, *ok, *error, *token;
+            struct t_slack_json_value *response, *ok, *error, *token;
 
             weechat_printf(
                 NULL,
                 _("%s%s: got response: %s"),
-                weechat_prefix("network"), SLACK_PLUGIN_NAME,
+                SLACK_PREFIX_NETWORK, SLACK_PLUGIN_NAME,
                 json_string);
             
-            response = json_tokener_parse(json_string);
-            ok = json_object_object_get(response, "ok");
+            response = slack_json_parse(json_string);
+            ok = slack_json_object_get(response, "ok");
             if (!json_valid(ok))
             {
-                json_object_put(response);
+                slack_json_free(response);
                 free(json_string);
                 return 0;
             }
 
-            if(json_object_get_boolean(ok))
+            if(slack_json_get_boolean(ok))
             {
-                token = json_object_object_get(response, "access_token");
+                token = slack_json_object_get(response, "access_token");
                 if (!json_valid(token))
                 {
-                    json_object_put(response);
+                    slack_json_free(response);
                     free(json_string);
                     return 0;
                 }
@@ -97,17 +98,17 @@ static int callback_http(struct lws *wsi, enum lws_callback_reasons reason,
                 weechat_printf(
                     NULL,
                     _("%s%s: retrieved token: %s"),
-                    weechat_prefix("network"), SLACK_PLUGIN_NAME,
-                    json_object_get_string(token));
+                    SLACK_PREFIX_NETWORK, SLACK_PLUGIN_NAME,
+                    slack_json_get_string(token));
 
-                weechat_callback(strdup(json_object_get_string(token)));
+                weechat_callback(strdup(slack_json_get_string(token)));
             }
             else
             {
-                error = json_object_object_get(response, "error");
+                error = slack_json_object_get(response, "error");
                 if (!json_valid(error))
                 {
-                    json_object_put(response);
+                    slack_json_free(response);
                     free(json_string);
                     return 0;
                 }
@@ -115,11 +116,11 @@ static int callback_http(struct lws *wsi, enum lws_callback_reasons reason,
                 weechat_printf(
                     NULL,
                     _("%s%s: failed to retrieve token: %s"),
-                    weechat_prefix("error"), SLACK_PLUGIN_NAME,
-                    json_object_get_string(error));
+                    SLACK_PREFIX_ERROR, SLACK_PLUGIN_NAME,
+                    slack_json_get_string(error));
             }
 
-            json_object_put(response);
+            slack_json_free(response);
             free(json_string);
         }
         return 0; /* don't passthru */
@@ -193,7 +194,7 @@ void slack_oauth_request_token(char *code, void (*callback)(char *token))
         weechat_printf(
             NULL,
             _("%s%s: error: a registration is already in progress"),
-            weechat_prefix("error"), SLACK_PLUGIN_NAME);
+            SLACK_PREFIX_ERROR, SLACK_PLUGIN_NAME);
         return;
     }
 
@@ -212,7 +213,7 @@ void slack_oauth_request_token(char *code, void (*callback)(char *token))
         weechat_printf(
             NULL,
             _("%s%s: error connecting to slack: lws init failed"),
-            weechat_prefix("error"), SLACK_PLUGIN_NAME);
+            SLACK_PREFIX_ERROR, SLACK_PLUGIN_NAME);
         return;
     }
     else
@@ -220,7 +221,7 @@ void slack_oauth_request_token(char *code, void (*callback)(char *token))
         weechat_printf(
             NULL,
             _("%s%s: contacting slack.com:443"),
-            weechat_prefix("network"), SLACK_PLUGIN_NAME);
+            SLACK_PREFIX_NETWORK, SLACK_PLUGIN_NAME);
     }
 
     memset(&i, 0, sizeof i); /* otherwise uninitialized garbage */
@@ -18,6 +18,7 @@ struct t_slack_request
     struct lws *client_wsi;
     struct lws_context *context;
     struct t_json_chunk *json_chunks;
+    struct t_slack_json_decoder *decoder;
 
     struct t_slack_request *prev_request;
     struct t_slack_request *next_request;
@@ -5,10 +5,11 @@
 #include <stdlib.h>
 #include <string.h>
 #include <libwebsockets.h>
-#include <json.h>
 
 #include "weechat-plugin.h"
 #include "slack.h"
+#include "slack-json.h"
+#include "slack-color.h"
 #include "slack-teaminfo.h"
 
 static void (*weechat_callback)(struct t_slack_teaminfo *slack_teaminfo);
@@ -32,14 +33,14 @@ struct t_json_chunk
 static struct t_json_chunk *slack_teaminfo_chunks = NULL;
 static struct t_slack_teaminfo slack_teaminfo;
 
-static inline int json_valid(json_object *object)
+static inline int json_valid(struct t_slack_json_value *object)
 {
     if (!object)
     {
         weechat_printf(
             NULL,
             _("%s%s: error retrieving workspace info: unexpected response from server"),
-            weechat_prefix("error"), SLACK_PLUGIN_NAME);
+            SLACK_PREFIX_ERROR, SLACK_PLUGIN_NAME);
         return 0;
     }
 
@@ -58,7 +59,7 @@ static int callback_http(struct lws *wsi, enum lws_callback_reasons reason,
         weechat_printf(
             NULL,
             _("%s%s: error connecting to slack: %s"),
-            weechat_prefix("error"), SLACK_PLUGIN_NAME,
+            SLACK_PREFIX_ERROR, SLACK_PLUGIN_NAME,
             in ? (char *)in : "(null)");
         client_wsi = NULL;
         break;
@@ -68,7 +69,7 @@ static int callback_http(struct lws *wsi, enum lws_callback_reasons reason,
         weechat_printf(
             NULL,
             _("%s%s: retrieving workspace details... (%d)"),
-            weechat_prefix("network"), SLACK_PLUGIN_NAME,
+            SLACK_PREFIX_NETWORK, SLACK_PLUGIN_NAME,
             status);
         break;
 
@@ -113,8 +114,8 @@ static int callback_http(struct lws *wsi, enum lws_callback_reasons reason,
         {
             int chunk_count, i;
             char *json_string;
-            json_object *response, *ok, *error, *team;
-            json_object *id, *name, *domain, *email_domain;
+            struct t_slack_json_value *response, *ok, *error, *team;
+            struct t_slack_json_value *id, *name, *domain, *email_domain;
             struct t_json_chunk *chunk_ptr;
 
             chunk_count = 0;
@@ -145,56 +146,56 @@ static int callback_http(struct lws *wsi, enum lws_callback_reasons reason,
             weechat_printf(
                 NULL,
                 _("%s%s: got response: %s"),
-                weechat_prefix("network"), SLACK_PLUGIN_NAME,
+                SLACK_PREFIX_NETWORK, SLACK_PLUGIN_NAME,
                 json_string);
             
-            response = json_tokener_parse(json_string);
-            ok = json_object_object_get(response, "ok");
+            response = slack_json_parse(json_string);
+            ok = slack_json_object_get(response, "ok");
             if (!json_valid(ok))
             {
-                json_object_put(response);
+                slack_json_free(response);
                 free(json_string);
                 return 0;
             }
 
-            if(json_object_get_boolean(ok))
+            if(slack_json_get_boolean(ok))
             {
-                team = json_object_object_get(response, "team");
+                team = slack_json_object_get(response, "team");
                 if (!json_valid(team))
                 {
-                    json_object_put(response);
+                    slack_json_free(response);
                     free(json_string);
                     return 0;
                 }
 
-                id = json_object_object_get(team, "id");
+                id = slack_json_object_get(team, "id");
                 if (!json_valid(id))
                 {
-                    json_object_put(response);
+                    slack_json_free(response);
                     free(json_string);
                     return 0;
                 }
 
-                name = json_object_object_get(team, "name");
+                name = slack_json_object_get(team, "name");
                 if (!json_valid(name))
                 {
-                    json_object_put(response);
+                    slack_json_free(response);
                     free(json_string);
                     return 0;
                 }
 
-                domain = json_object_object_get(team, "domain");
+                domain = slack_json_object_get(team, "domain");
                 if (!json_valid(domain))
                 {
-                    json_object_put(response);
+                    slack_json_free(response);
                     free(json_string);
                     return 0;
                 }
 
-                email_domain = json_object_object_get(team, "email_domain");
+                email_domain = slack_json_object_get(team, "email_domain");
                 if (!json_valid(email_domain))
                 {
-                    json_object_put(response);
+                    slack_json_free(response);
                     free(json_string);
                     return 0;
                 }
@@ -202,22 +203,22 @@ static int callback_http(struct lws *wsi, enum lws_callback_reasons reason,
                 weechat_printf(
                     NULL,
                     _("%s%s: retrieved workspace details for %s@%s"),
-                    weechat_prefix("network"), SLACK_PLUGIN_NAME,
-                    json_object_get_string(name), json_object_get_string(domain));
+                    SLACK_PREFIX_NETWORK, SLACK_PLUGIN_NAME,
+                    slack_json_get_string(name), slack_json_get_string(domain));
 
-                slack_teaminfo.id = json_object_get_string(id);
-                slack_teaminfo.name = json_object_get_string(name);
-                slack_teaminfo.domain = json_object_get_string(domain);
-                slack_teaminfo.email_domain = json_object_get_string(email_domain);
+                slack_teaminfo.id = slack_json_get_string(id);
+                slack_teaminfo.name = slack_json_get_string(name);
+                slack_teaminfo.domain = slack_json_get_string(domain);
+                slack_teaminfo.email_domain = slack_json_get_string(email_domain);
 
                 weechat_callback(&slack_teaminfo);
             }
             else
             {
-                error = json_object_object_get(response, "error");
+                error = slack_json_object_get(response, "error");
                 if (!json_valid(error))
                 {
-                    json_object_put(response);
+                    slack_json_free(response);
                     free(json_string);
                     return 0;
                 }
@@ -225,11 +226,11 @@ static int callback_http(struct lws *wsi, enum lws_callback_reasons reason,
                 weechat_printf(
                     NULL,
                     _("%s%s: failed to retrieve workspace details: %s"),
-                    weechat_prefix("error"), SLACK_PLUGIN_NAME,
-                    json_object_get_string(error));
+                    SLACK_PREFIX_ERROR, SLACK_PLUGIN_NAME,
+                    slack_json_get_string(error));
             }
 
-            json_object_put(response);
+            slack_json_free(response);
             free(json_string);
         }
         /* fallthrough */
@@ -289,7 +290,7 @@ void slack_teaminfo_fetch(char *token, void (*callback)(struct t_slack_teaminfo
         weechat_printf(
             NULL,
             _("%s%s: error: a registration is already in progress"),
-            weechat_prefix("error"), SLACK_PLUGIN_NAME);
+            SLACK_PREFIX_ERROR, SLACK_PLUGIN_NAME);
         return;
     }
 
@@ -310,7 +311,7 @@ void slack_teaminfo_fetch(char *token, void (*callback)(struct t_slack_teaminfo
         weechat_printf(
             NULL,
             _("%s%s: error connecting to slack: lws init failed"),
-            weechat_prefix("error"), SLACK_PLUGIN_NAME);
+            SLACK_PREFIX_ERROR, SLACK_PLUGIN_NAME);
         return;
     }
     else
@@ -318,7 +319,7 @@ void slack_teaminfo_fetch(char *token, void (*callback)(struct t_slack_teaminfo
         weechat_printf(
             NULL,
             _("%s%s: contacting slack.com:443"),
-            weechat_prefix("network"), SLACK_PLUGIN_NAME);
+            SLACK_PREFIX_NETWORK, SLACK_PLUGIN_NAME);
     }
 
     memset(&i, 0, sizeof i); /* otherwise uninitialized garbage */
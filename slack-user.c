@@ -5,21 +5,73 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <wctype.h>
 
 #include "weechat-plugin.h"
 #include "slack.h"
+#include "slack-id.h"
+#include "slack-arena.h"
+#include "slack-intern.h"
 #include "slack-workspace.h"
 #include "slack-user.h"
 #include "slack-channel.h"
+#include "slack-memberset.h"
 
-const char *slack_user_get_colour(struct t_slack_user *user)
+/* bumped when the nick colour options change, see slack_user_nick_colors_cb */
+static unsigned int slack_user_colour_generation = 0;
+
+/* user whose nick is being added, see slack_buffer_nickcmp_cb */
+struct t_slack_user *slack_user_nicklist_inserted = NULL;
+
+int slack_user_nick_colors_cb(const void *pointer, void *data,
+                              const char *option, const char *value)
+{
+    /* make C compiler happy */
+    (void) pointer;
+    (void) data;
+    (void) option;
+    (void) value;
+
+    slack_user_colour_generation++;
+
+    return WEECHAT_RC_OK;
+}
+
+/*
+ * Looks up the nick colours of a user once per display name and colour
+ * settings. Colours are shared by many users, so they are interned.
+ */
+
+static void slack_user_update_colour(struct t_slack_workspace *workspace,
+                                     struct t_slack_user *user)
+{
+    if (user->colour && user->colour_generation == slack_user_colour_generation)
+        return;
+
+    user->colour = slack_intern_string(
+        workspace->strings,
+        weechat_info_get("nick_color", user->profile.display_name));
+    user->colour_name = slack_intern_string(
+        workspace->strings,
+        weechat_info_get("nick_color_name", user->profile.display_name));
+    user->prefix = NULL;
+    user->colour_generation = slack_user_colour_generation;
+}
+
+const char *slack_user_get_colour(struct t_slack_workspace *workspace,
+                                  struct t_slack_user *user)
 {
-    return weechat_info_get("nick_color", user->profile.display_name);
+    slack_user_update_colour(workspace, user);
+
+    return (user->colour) ? user->colour : "";
 }
 
-const char *slack_user_get_colour_for_nicklist(struct t_slack_user *user)
+static const char *slack_user_get_colour_for_nicklist(struct t_slack_workspace *workspace,
+                                                      struct t_slack_user *user)
 {
-    return weechat_info_get("nick_color_name", user->profile.display_name);
+    slack_user_update_colour(workspace, user);
+
+    return (user->colour_name) ? user->colour_name : "default";
 }
 
 const char *slack_user_as_prefix(struct t_slack_workspace *workspace,
@@ -27,29 +79,49 @@ const char *slack_user_as_prefix(struct t_slack_workspace *workspace,
                                  const char *name)
 {
     static char result[256];
+    const char *colour;
+    int length;
 
-    (void) workspace;
+    colour = slack_user_get_colour(workspace, user);
+
+    if (!user->profile.display_name
+        || (name && strcmp(name, user->profile.display_name) != 0))
+    {
+        snprintf(result, sizeof(result), "%s%s\t", colour, name);
+        return result;
+    }
 
-    snprintf(result, sizeof(result), "%s%s\t",
-             slack_user_get_colour(user),
-             name ? name : user->profile.display_name);
+    if (!user->prefix)
+    {
+        length = snprintf(result, sizeof(result), "%s%s\t",
+                          colour, user->profile.display_name);
+        if (length >= (int)sizeof(result))
+            return result;
+        user->prefix = slack_arena_strdup(workspace->users_arena, result);
+        if (!user->prefix)
+            return result;
+    }
 
-    return result;
+    return user->prefix;
 }
 
 struct t_slack_user *slack_user_bot_search(struct t_slack_workspace *workspace,
                                            const char *bot_id)
 {
     struct t_slack_user *ptr_user;
+    t_slack_id id;
 
     if (!workspace || !bot_id)
         return NULL;
 
+    id = slack_id_encode(bot_id);
+    if (id == SLACK_ID_NONE)
+        return NULL;
+
     for (ptr_user = workspace->users; ptr_user;
          ptr_user = ptr_user->next_user)
     {
-        if (ptr_user->profile.bot_id &&
-            weechat_strcasecmp(ptr_user->profile.bot_id, bot_id) == 0)
+        if (ptr_user->profile.bot_id == id)
             return ptr_user;
     }
 
@@ -59,67 +131,428 @@ struct t_slack_user *slack_user_bot_search(struct t_slack_workspace *workspace,
 struct t_slack_user *slack_user_search(struct t_slack_workspace *workspace,
                                        const char *id)
 {
-    struct t_slack_user *ptr_user;
-
     if (!workspace || !id)
         return NULL;
 
-    for (ptr_user = workspace->users; ptr_user;
-         ptr_user = ptr_user->next_user)
+    return slack_user_search_id(workspace, slack_id_encode(id));
+}
+
+struct t_slack_user *slack_user_search_id(struct t_slack_workspace *workspace,
+                                          t_slack_id id)
+{
+    if (!workspace)
+        return NULL;
+
+    return slack_id_hashtable_get(workspace->users_by_id, id);
+}
+
+struct t_slack_user *slack_user_search_display_name(struct t_slack_workspace *workspace,
+                                                    const char *display_name)
+{
+    if (!workspace || !display_name)
+        return NULL;
+
+    return weechat_hashtable_get(workspace->users_by_display_name,
+                                 display_name);
+}
+
+/*
+ * Searches a user by display name or, failing that, real name, regardless
+ * of case.
+ */
+
+struct t_slack_user *slack_user_search_name(struct t_slack_workspace *workspace,
+                                            const char *name)
+{
+    if (!workspace || !name)
+        return NULL;
+
+    return weechat_hashtable_get(workspace->users_by_name, name);
+}
+
+/*
+ * Display names take precedence over real names in the name index: they
+ * replace any entry, real names are only added to free keys.
+ */
+
+static void slack_user_name_index_add(struct t_slack_workspace *workspace,
+                                      const char *name,
+                                      struct t_slack_user *user,
+                                      int replace)
+{
+    if (!name || !name[0])
+        return;
+
+    if (!replace && weechat_hashtable_has_key(workspace->users_by_name, name))
+        return;
+
+    weechat_hashtable_set(workspace->users_by_name, name, user);
+}
+
+static void slack_user_name_index_remove(struct t_slack_workspace *workspace,
+                                         const char *name,
+                                         struct t_slack_user *user)
+{
+    if (name && weechat_hashtable_get(workspace->users_by_name, name) == user)
+        weechat_hashtable_remove(workspace->users_by_name, name);
+}
+
+static int slack_user_utf8_encode(wint_t c, char *str)
+{
+    if (c < 0x80)
     {
-        if (weechat_strcasecmp(ptr_user->id, id) == 0)
-            return ptr_user;
+        str[0] = c;
+        return 1;
+    }
+    if (c < 0x800)
+    {
+        str[0] = 0xC0 | (c >> 6);
+        str[1] = 0x80 | (c & 0x3F);
+        return 2;
+    }
+    if (c < 0x10000)
+    {
+        str[0] = 0xE0 | (c >> 12);
+        str[1] = 0x80 | ((c >> 6) & 0x3F);
+        str[2] = 0x80 | (c & 0x3F);
+        return 3;
     }
+    str[0] = 0xF0 | (c >> 18);
+    str[1] = 0x80 | ((c >> 12) & 0x3F);
+    str[2] = 0x80 | ((c >> 6) & 0x3F);
+    str[3] = 0x80 | (c & 0x3F);
+    return 4;
+}
 
-    return NULL;
+/*
+ * Builds the nicklist sort key of a user: the display name with every
+ * character lowercased, so that memcmp orders keys like weechat_strcasecmp
+ * orders names.
+ */
+
+static void slack_user_set_sort_key(struct t_slack_workspace *workspace,
+                                    struct t_slack_user *user)
+{
+    const char *ptr_name;
+    char utf8[4];
+    int length;
+
+    user->sort_key = NULL;
+    user->sort_key_length = 0;
+
+    length = 0;
+    for (ptr_name = user->profile.display_name; ptr_name && *ptr_name;
+         ptr_name = weechat_utf8_next_char(ptr_name))
+        length += slack_user_utf8_encode(
+            towlower(weechat_utf8_char_int(ptr_name)), utf8);
+
+    user->sort_key = slack_arena_alloc(workspace->users_arena, length + 1);
+    if (!user->sort_key)
+        return;
+
+    length = 0;
+    for (ptr_name = user->profile.display_name; ptr_name && *ptr_name;
+         ptr_name = weechat_utf8_next_char(ptr_name))
+        length += slack_user_utf8_encode(
+            towlower(weechat_utf8_char_int(ptr_name)),
+            user->sort_key + length);
+    user->sort_key[length] = '\0';
+    user->sort_key_length = length;
 }
 
-void slack_user_nicklist_add(struct t_slack_workspace *workspace,
-                             struct t_slack_channel *channel,
-                             struct t_slack_user *user)
+int slack_user_sort_key_cmp(struct t_slack_user *user1,
+                            struct t_slack_user *user2)
 {
-    struct t_gui_nick_group *ptr_group;
-    struct t_gui_buffer *ptr_buffer;
+    int length, rc;
 
-    ptr_buffer = channel ? channel->buffer : workspace->buffer;
+    if (!user1->sort_key || !user2->sort_key)
+        return weechat_strcasecmp(user1->profile.display_name,
+                                  user2->profile.display_name);
+
+    length = (user1->sort_key_length < user2->sort_key_length) ?
+        user1->sort_key_length : user2->sort_key_length;
+    rc = memcmp(user1->sort_key, user2->sort_key, length);
+    if (rc)
+        return rc;
+
+    return user1->sort_key_length - user2->sort_key_length;
+}
+
+/*
+ * Compares the sort key of a user with a nick, folding the nick as it is
+ * read instead of looking up whose it is: the key depends on the name only.
+ */
+
+int slack_user_sort_key_cmp_name(struct t_slack_user *user, const char *name)
+{
+    char utf8[4];
+    int pos, length, rc;
+
+    pos = 0;
+    for (; name && *name; name = weechat_utf8_next_char(name))
+    {
+        length = slack_user_utf8_encode(
+            towlower(weechat_utf8_char_int(name)), utf8);
+        if (pos + length > user->sort_key_length)
+        {
+            rc = memcmp(user->sort_key + pos, utf8,
+                        user->sort_key_length - pos);
+            return (rc) ? rc : -1;
+        }
+        rc = memcmp(user->sort_key + pos, utf8, length);
+        if (rc)
+            return rc;
+        pos += length;
+    }
+
+    return (pos < user->sort_key_length) ? 1 : 0;
+}
+
+struct t_slack_user *slack_user_search_index(struct t_slack_workspace *workspace,
+                                             uint32_t index)
+{
+    if (!workspace || index >= workspace->users_index_count)
+        return NULL;
+
+    return workspace->users_by_index[index];
+}
+
+static int slack_user_add_index(struct t_slack_workspace *workspace,
+                                struct t_slack_user *user)
+{
+    struct t_slack_user **new_index;
+    uint32_t new_size;
+
+    if (workspace->users_index_count == workspace->users_index_size)
+    {
+        new_size = workspace->users_index_size ?
+            workspace->users_index_size * 2 : 256;
+        new_index = realloc(workspace->users_by_index,
+                            new_size * sizeof(*new_index));
+        if (!new_index)
+            return 0;
+        workspace->users_by_index = new_index;
+        workspace->users_index_size = new_size;
+    }
+
+    user->index = workspace->users_index_count++;
+    workspace->users_by_index[user->index] = user;
+
+    return 1;
+}
+
+static void slack_user_nicklist_insert(struct t_slack_workspace *workspace,
+                                       struct t_gui_buffer *ptr_buffer,
+                                       struct t_slack_user *user)
+{
+    struct t_gui_nick_group *ptr_group;
 
     ptr_group = weechat_nicklist_search_group(ptr_buffer, NULL,
                                               user->is_away ?
                                               "+" : "...");
+    slack_user_nicklist_inserted = (user->sort_key) ? user : NULL;
     weechat_nicklist_add_nick(ptr_buffer, ptr_group,
                               user->profile.display_name,
                               user->is_away ? 
                               "weechat.color.nicklist_away" :
-                              slack_user_get_colour_for_nicklist(user),
+                              slack_user_get_colour_for_nicklist(workspace, user),
                               user->is_away ? "+" : "",
                               "bar_fg",
                               1);
+    slack_user_nicklist_inserted = NULL;
+}
+
+static int slack_user_nicklist_cmp(const void *user1, const void *user2)
+{
+    return slack_user_sort_key_cmp(*(struct t_slack_user **)user1,
+                                   *(struct t_slack_user **)user2);
+}
+
+/*
+ * Fills the nicklist of a channel (or of the workspace buffer if channel
+ * is NULL) in one go. Nicks are inserted in descending order: weechat
+ * scans a group from its first nick for the insert position, so each
+ * insert then stops at the first comparison.
+ */
+
+void slack_user_nicklist_populate(struct t_slack_workspace *workspace,
+                                  struct t_slack_channel *channel)
+{
+    struct t_slack_user **users, *ptr_user;
+    struct t_gui_buffer *ptr_buffer;
+    uint32_t count;
+    int i;
+
+    ptr_buffer = channel ? channel->buffer : workspace->buffer;
+    if (!ptr_buffer)
+        return;
+
+    if (channel)
+        channel->nicklist_loaded = 1;
+    else
+    {
+        workspace->nicklist_loaded = 1;
+        slack_channel_add_nicklist_groups(workspace, NULL);
+    }
+
+    if (channel)
+    {
+        /* members are kept sorted on the channel */
+        users = slack_channel_members_sorted(workspace, channel, &i);
+        while (i > 0)
+            slack_user_nicklist_insert(workspace, ptr_buffer, users[--i]);
+        return;
+    }
+
+    count = workspace->users_index_count;
+    if (count == 0)
+        return;
+
+    users = malloc(count * sizeof(*users));
+    if (!users)
+        return;
+
+    i = 0;
+    for (ptr_user = workspace->users; ptr_user && (uint32_t)i < count;
+         ptr_user = ptr_user->next_user)
+        users[i++] = ptr_user;
+
+    qsort(users, i, sizeof(*users), &slack_user_nicklist_cmp);
+
+    while (i > 0)
+        slack_user_nicklist_insert(workspace, ptr_buffer, users[--i]);
+
+    free(users);
+}
+
+void slack_user_nicklist_add(struct t_slack_workspace *workspace,
+                             struct t_slack_channel *channel,
+                             struct t_slack_user *user)
+{
+    struct t_gui_buffer *ptr_buffer;
+    int loaded;
+
+    ptr_buffer = channel ? channel->buffer : workspace->buffer;
+    if (!ptr_buffer)
+        return;
+
+    loaded = (channel) ? channel->nicklist_loaded : workspace->nicklist_loaded;
+    if (loaded)
+    {
+        slack_user_nicklist_insert(workspace, ptr_buffer, user);
+        return;
+    }
+
+    /* nobody looks at this nicklist yet: fill it when it's displayed */
+    if (weechat_buffer_get_integer(ptr_buffer, "num_displayed") > 0)
+        slack_user_nicklist_populate(workspace, channel);
+}
+
+/*
+ * Moves a nick to its new name in a nicklist that has been filled.
+ */
+
+static void slack_user_nicklist_rename(struct t_slack_workspace *workspace,
+                                       struct t_gui_buffer *ptr_buffer,
+                                       struct t_slack_user *user,
+                                       const char *old_name)
+{
+    struct t_gui_nick *ptr_nick;
+
+    if (!ptr_buffer)
+        return;
+
+    ptr_nick = weechat_nicklist_search_nick(ptr_buffer, NULL, old_name);
+    if (!ptr_nick)
+        return;
+
+    weechat_nicklist_remove_nick(ptr_buffer, ptr_nick);
+    slack_user_nicklist_insert(workspace, ptr_buffer, user);
+}
+
+/*
+ * Updates the display name of a known user (users.list is fetched again on
+ * reconnect), keeping the name index, sort key and nicklists in step.
+ */
+
+static void slack_user_rename(struct t_slack_workspace *workspace,
+                              struct t_slack_user *user,
+                              const char *display_name)
+{
+    struct t_slack_channel *ptr_channel;
+    const char *old_name;
+
+    old_name = user->profile.display_name;
+    if (old_name && strcmp(old_name, display_name) == 0)
+        return;
+
+    if (old_name
+        && weechat_hashtable_get(workspace->users_by_display_name,
+                                 old_name) == user)
+        weechat_hashtable_remove(workspace->users_by_display_name, old_name);
+    slack_user_name_index_remove(workspace, old_name, user);
+
+    user->profile.display_name = slack_intern_string(workspace->strings,
+                                                     display_name);
+    slack_user_set_sort_key(workspace, user);
+    user->colour = NULL;
+    user->prefix = NULL;
+    if (user->profile.display_name)
+        weechat_hashtable_set(workspace->users_by_display_name,
+                              user->profile.display_name, user);
+    slack_user_name_index_add(workspace, user->profile.display_name, user, 1);
+    workspace->users_generation++;
+
+    if (!old_name)
+        return;
+
+    if (workspace->nicklist_loaded)
+        slack_user_nicklist_rename(workspace, workspace->buffer, user,
+                                   old_name);
+    for (ptr_channel = workspace->channels; ptr_channel;
+         ptr_channel = ptr_channel->next_channel)
+    {
+        if (ptr_channel->nicklist_loaded && ptr_channel->members
+            && slack_memberset_contains(ptr_channel->members, user->index))
+            slack_user_nicklist_rename(workspace, ptr_channel->buffer, user,
+                                       old_name);
+    }
 }
 
 struct t_slack_user *slack_user_new(struct t_slack_workspace *workspace,
                                     const char *id, const char *display_name)
 {
     struct t_slack_user *new_user, *ptr_user;
+    t_slack_id user_id;
 
     if (!workspace || !id || !display_name)
     {
         return NULL;
     }
 
-    if (!display_name[0] && strcmp("USLACKBOT", id) == 0)
+    user_id = slack_id_encode(id);
+    if (user_id == SLACK_ID_NONE)
         return NULL;
 
-    if (!workspace->users)
-        slack_channel_add_nicklist_groups(workspace, NULL);
+    if (!display_name[0] && strcmp("USLACKBOT", id) == 0)
+        return NULL;
 
-    ptr_user = slack_user_search(workspace, id);
+    ptr_user = slack_user_search_id(workspace, user_id);
     if (ptr_user)
     {
+        slack_user_rename(workspace, ptr_user,
+                          display_name[0] ? display_name : "slackbot");
         slack_user_nicklist_add(workspace, NULL, ptr_user);
         return ptr_user;
     }
 
-    if ((new_user = malloc(sizeof(*new_user))) == NULL)
+    new_user = slack_arena_alloc(workspace->users_arena, sizeof(*new_user));
+    if (!new_user)
+    {
+        return NULL;
+    }
+
+    if (!slack_user_add_index(workspace, new_user))
     {
         return NULL;
     }
@@ -132,11 +565,14 @@ struct t_slack_user *slack_user_new(struct t_slack_workspace *workspace,
         workspace->users = new_user;
     workspace->last_user = new_user;
 
-    new_user->id = strdup(id);
+    new_user->id = user_id;
     new_user->name = NULL;
-    new_user->team_id = NULL;
+    new_user->team_id = SLACK_ID_NONE;
     new_user->real_name = NULL;
     new_user->colour = NULL;
+    new_user->colour_name = NULL;
+    new_user->prefix = NULL;
+    new_user->colour_generation = 0;
     new_user->deleted = 0;
 
     new_user->tz = NULL;
@@ -148,13 +584,13 @@ struct t_slack_user *slack_user_new(struct t_slack_workspace *workspace,
     new_user->profile.status_text = NULL;
     new_user->profile.status_emoji = NULL;
     new_user->profile.real_name = NULL;
-    new_user->profile.display_name = display_name[0] ?
-        strdup(display_name) :
-        strdup("slackbot");
+    new_user->profile.display_name = slack_intern_string(
+        workspace->strings, display_name[0] ? display_name : "slackbot");
+    slack_user_set_sort_key(workspace, new_user);
     new_user->profile.real_name_normalized = NULL;
     new_user->profile.email = NULL;
-    new_user->profile.team = NULL;
-    new_user->profile.bot_id = NULL;
+    new_user->profile.team = SLACK_ID_NONE;
+    new_user->profile.bot_id = SLACK_ID_NONE;
     new_user->updated = 0;
     new_user->is_away = 0;
 
@@ -168,11 +604,37 @@ struct t_slack_user *slack_user_new(struct t_slack_workspace *workspace,
     new_user->is_app_user = 0;
     new_user->has_2fa = 0;
 
+    slack_id_hashtable_set(workspace->users_by_id, new_user->id, new_user);
+    if (new_user->profile.display_name)
+        weechat_hashtable_set(workspace->users_by_display_name,
+                              new_user->profile.display_name, new_user);
+    slack_user_name_index_add(workspace, new_user->profile.display_name,
+                              new_user, 1);
+
     slack_user_nicklist_add(workspace, NULL, new_user);
 
     return new_user;
 }
 
+void slack_user_set_real_name(struct t_slack_workspace *workspace,
+                              struct t_slack_user *user,
+                              const char *real_name)
+{
+    if (!workspace || !user)
+        return;
+
+    if (user->profile.real_name && real_name
+        && strcmp(user->profile.real_name, real_name) == 0)
+        return;
+
+    slack_user_name_index_remove(workspace, user->profile.real_name, user);
+
+    /* previous value stays in the arena until the next resync */
+    user->profile.real_name = slack_arena_strdup(workspace->users_arena,
+                                                 real_name);
+    slack_user_name_index_add(workspace, user->profile.real_name, user, 0);
+}
+
 void slack_user_free(struct t_slack_workspace *workspace,
                      struct t_slack_user *user)
 {
@@ -195,47 +657,44 @@ void slack_user_free(struct t_slack_workspace *workspace,
     if (user->next_user)
         (user->next_user)->prev_user = user->prev_user;
 
-    /* free user data */
-    if (user->id)
-        free(user->id);
-    if (user->name)
-        free(user->name);
-    if (user->team_id)
-        free(user->team_id);
-    if (user->real_name)
-        free(user->real_name);
-    if (user->colour)
-        free(user->colour);
-    if (user->tz)
-        free(user->tz);
-    if (user->tz_label)
-        free(user->tz_label);
-    if (user->locale)
-        free(user->locale);
-    if (user->profile.avatar_hash)
-        free(user->profile.avatar_hash);
-    if (user->profile.status_text)
-        free(user->profile.status_text);
-    if (user->profile.status_emoji)
-        free(user->profile.status_emoji);
-    if (user->profile.real_name)
-        free(user->profile.real_name);
-    if (user->profile.display_name)
-        free(user->profile.display_name);
-    if (user->profile.real_name_normalized)
-        free(user->profile.real_name_normalized);
-    if (user->profile.email)
-        free(user->profile.email);
-    if (user->profile.team)
-        free(user->profile.team);
+    slack_id_hashtable_remove(workspace->users_by_id, user->id);
+    if (user->profile.display_name
+        && weechat_hashtable_get(workspace->users_by_display_name,
+                                 user->profile.display_name) == user)
+        weechat_hashtable_remove(workspace->users_by_display_name,
+                                 user->profile.display_name);
+    slack_user_name_index_remove(workspace, user->profile.display_name, user);
+    slack_user_name_index_remove(workspace, user->profile.real_name, user);
+    workspace->users_by_index[user->index] = NULL;
+    workspace->users_generation++;
 
-    free(user);
+    /* user data lives in the users arena, released by slack_user_free_all */
 
     workspace->users = new_users;
 }
 
 void slack_user_free_all(struct t_slack_workspace *workspace)
 {
-    while (workspace->users)
-        slack_user_free(workspace, workspace->users);
+    struct t_slack_channel *ptr_channel;
+
+    /* release the whole directory at once */
+    workspace->users = NULL;
+    workspace->last_user = NULL;
+    if (workspace->users_by_id)
+        weechat_hashtable_remove_all(workspace->users_by_id);
+    if (workspace->users_by_display_name)
+        weechat_hashtable_remove_all(workspace->users_by_display_name);
+    if (workspace->users_by_name)
+        weechat_hashtable_remove_all(workspace->users_by_name);
+    slack_arena_clear(workspace->users_arena);
+    workspace->users_generation++;
+
+    /* member sets hold user indexes, which are reused from now on */
+    for (ptr_channel = workspace->channels; ptr_channel;
+         ptr_channel = ptr_channel->next_channel)
+    {
+        if (ptr_channel->members)
+            slack_memberset_clear(ptr_channel->members);
+    }
+    workspace->users_index_count = 0;
 }
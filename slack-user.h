@@ -9,28 +9,34 @@ struct t_slack_user_profile
 {
     char *avatar_hash;
     char *status_text;
-    char *status_emoji;
+    const char *status_emoji;
     char *real_name;
-    char *display_name;
+    const char *display_name;
     char *real_name_normalized;
     char *email;
-    char *team;
-    char *bot_id;
+    t_slack_id team;
+    t_slack_id bot_id;
 };
 
 struct t_slack_user
 {
-    char *id;
+    t_slack_id id;
+    uint32_t index;
+    char *sort_key; /* casefolded display name, compared with memcmp */
+    int sort_key_length;
     char *name;
-    char *team_id;
+    t_slack_id team_id;
     char *real_name;
-    char *colour;
+    const char *colour; /* cached, see slack_user_get_colour */
+    const char *colour_name; /* cached nicklist colour */
+    const char *prefix; /* cached, see slack_user_as_prefix */
+    unsigned int colour_generation;
 
     int deleted;
-    char *tz;
-    char *tz_label;
+    const char *tz;
+    const char *tz_label;
     int tz_offset;
-    char *locale;
+    const char *locale;
 
     struct t_slack_user_profile profile;
     int updated;
@@ -50,7 +56,13 @@ struct t_slack_user
     struct t_slack_user *next_user;
 };
 
-const char *slack_user_get_colour(struct t_slack_user *user);
+extern struct t_slack_user *slack_user_nicklist_inserted;
+
+int slack_user_nick_colors_cb(const void *pointer, void *data,
+                              const char *option, const char *value);
+
+const char *slack_user_get_colour(struct t_slack_workspace *workspace,
+                                  struct t_slack_user *user);
 
 const char *slack_user_as_prefix(struct t_slack_workspace *workspace,
                                  struct t_slack_user *user,
@@ -62,11 +74,35 @@ struct t_slack_user *slack_user_bot_search(struct t_slack_workspace *workspace,
 struct t_slack_user *slack_user_search(struct t_slack_workspace *workspace,
                                        const char *id);
 
+struct t_slack_user *slack_user_search_id(struct t_slack_workspace *workspace,
+                                          t_slack_id id);
+
+struct t_slack_user *slack_user_search_display_name(struct t_slack_workspace *workspace,
+                                                    const char *display_name);
+
+struct t_slack_user *slack_user_search_name(struct t_slack_workspace *workspace,
+                                            const char *name);
+
+int slack_user_sort_key_cmp(struct t_slack_user *user1,
+                            struct t_slack_user *user2);
+
+int slack_user_sort_key_cmp_name(struct t_slack_user *user, const char *name);
+
+struct t_slack_user *slack_user_search_index(struct t_slack_workspace *workspace,
+                                             uint32_t index);
+
+void slack_user_set_real_name(struct t_slack_workspace *workspace,
+                              struct t_slack_user *user,
+                              const char *real_name);
+
 struct t_slack_user *slack_user_new(struct t_slack_workspace *workspace,
                                     const char *id, const char *display_name);
 
 void slack_user_free_all(struct t_slack_workspace *workspace);
 
+void slack_user_nicklist_populate(struct t_slack_workspace *workspace,
+                                  struct t_slack_channel *channel);
+
 void slack_user_nicklist_add(struct t_slack_workspace *workspace,
                              struct t_slack_channel *channel,
                              struct t_slack_user *user);
@@ -3,14 +3,19 @@
 // file, You can obtain one at http://mozilla.org/MPL/2.0/.
 
 #include <libwebsockets.h>
-#include <json.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 #include <assert.h>
+#include <wctype.h>
 
 #include "weechat-plugin.h"
 #include "slack.h"
+#include "slack-color.h"
+#include "slack-id.h"
+#include "slack-arena.h"
+#include "slack-intern.h"
+#include "slack-json.h"
 #include "slack-config.h"
 #include "slack-input.h"
 #include "slack-workspace.h"
@@ -18,6 +23,7 @@
 #include "slack-request.h"
 #include "slack-user.h"
 #include "slack-channel.h"
+#include "slack-memberset.h"
 #include "slack-buffer.h"
 
 struct t_slack_workspace *slack_workspaces = NULL;
@@ -30,14 +36,15 @@ char *slack_workspace_options[SLACK_WORKSPACE_NUM_OPTIONS][2] =
 static const char *const endpoint = "/api/rtm.connect?"
     "token=%s&batch_presence_aware=true&presence_sub=false&";
 
-static inline int json_valid(json_object *object, struct t_slack_workspace *workspace)
+static inline int json_valid(struct t_slack_json_value *object,
+                             struct t_slack_workspace *workspace)
 {
     if (!object)
     {
         weechat_printf(
             workspace->buffer,
             _("%s%s: error requesting websocket: unexpected response from server"),
-            weechat_prefix("error"), SLACK_PLUGIN_NAME);
+            SLACK_PREFIX_ERROR, SLACK_PLUGIN_NAME);
         return 0;
     }
 
@@ -57,7 +64,7 @@ static int callback_http(struct lws *wsi, enum lws_callback_reasons reason,
         weechat_printf(
             workspace->buffer,
             _("%s%s: error connecting to slack: %s"),
-            weechat_prefix("error"), SLACK_PLUGIN_NAME,
+            SLACK_PREFIX_ERROR, SLACK_PLUGIN_NAME,
             in ? (char *)in : "(null)");
         workspace->client_wsi = NULL;
         break;
@@ -67,7 +74,7 @@ static int callback_http(struct lws *wsi, enum lws_callback_reasons reason,
         weechat_printf(
             workspace->buffer,
             _("%s%s: requesting a websocket... (%d)"),
-            weechat_prefix("network"), SLACK_PLUGIN_NAME,
+            SLACK_PREFIX_NETWORK, SLACK_PLUGIN_NAME,
             status);
         break;
 
@@ -112,8 +119,8 @@ static int callback_http(struct lws *wsi, enum lws_callback_reasons reason,
         {
             int chunk_count, i;
             char *json_string;
-            json_object *response, *ok, *error, *self, *team, *url;
-            json_object *id, *name, *domain;
+            struct t_slack_json_value *response, *ok, *error, *self, *team, *url;
+            struct t_slack_json_value *id, *name, *domain;
             struct t_json_chunk *chunk_ptr;
 
             chunk_count = 0;
@@ -144,99 +151,99 @@ static int callback_http(struct lws *wsi, enum lws_callback_reasons reason,
             weechat_printf(
                 workspace->buffer,
                 _("%s%s: got response: %s"),
-                weechat_prefix("network"), SLACK_PLUGIN_NAME,
+                SLACK_PREFIX_NETWORK, SLACK_PLUGIN_NAME,
                 json_string);
             
-            response = json_tokener_parse(json_string);
-            ok = json_object_object_get(response, "ok");
+            response = slack_json_parse(json_string);
+            ok = slack_json_object_get(response, "ok");
             if (!json_valid(ok, workspace))
             {
-                json_object_put(response);
+                slack_json_free(response);
                 free(json_string);
                 return 0;
             }
 
-            if(json_object_get_boolean(ok))
+            if(slack_json_get_boolean(ok))
             {
-                self = json_object_object_get(response, "self");
+                self = slack_json_object_get(response, "self");
                 if (!json_valid(self, workspace))
                 {
-                    json_object_put(response);
+                    slack_json_free(response);
                     free(json_string);
                     return 0;
                 }
                 else
                 {
-                    id = json_object_object_get(self, "id");
+                    id = slack_json_object_get(self, "id");
                     if (!json_valid(id, workspace))
                     {
-                        json_object_put(response);
+                        slack_json_free(response);
                         free(json_string);
                         return 0;
                     }
-                    workspace->user = strdup(json_object_get_string(id));
+                    workspace->user = strdup(slack_json_get_string(id));
 
-                    name = json_object_object_get(self, "name");
+                    name = slack_json_object_get(self, "name");
                     if (!json_valid(name, workspace))
                     {
-                        json_object_put(response);
+                        slack_json_free(response);
                         free(json_string);
                         return 0;
                     }
-                    workspace->nick = strdup(json_object_get_string(name));
+                    workspace->nick = strdup(slack_json_get_string(name));
                 }
 
-                team = json_object_object_get(response, "team");
+                team = slack_json_object_get(response, "team");
                 if (!json_valid(team, workspace))
                 {
-                    json_object_put(response);
+                    slack_json_free(response);
                     free(json_string);
                     return 0;
                 }
                 else
                 {
-                    domain = json_object_object_get(team, "domain");
+                    domain = slack_json_object_get(team, "domain");
                     if (!json_valid(domain, workspace))
                     {
-                        json_object_put(response);
+                        slack_json_free(response);
                         free(json_string);
                         return 0;
                     }
 
-                    id = json_object_object_get(team, "id");
+                    id = slack_json_object_get(team, "id");
                     if (!json_valid(id, workspace))
                     {
-                        json_object_put(response);
+                        slack_json_free(response);
                         free(json_string);
                         return 0;
                     }
-                    workspace->id = strdup(json_object_get_string(id));
+                    workspace->id = strdup(slack_json_get_string(id));
 
-                    name = json_object_object_get(team, "name");
+                    name = slack_json_object_get(team, "name");
                     if (!json_valid(name, workspace))
                     {
-                        json_object_put(response);
+                        slack_json_free(response);
                         free(json_string);
                         return 0;
                     }
-                    workspace->name = strdup(json_object_get_string(name));
+                    workspace->name = strdup(slack_json_get_string(name));
                 }
 
-                url = json_object_object_get(response, "url");
+                url = slack_json_object_get(response, "url");
                 if (!json_valid(url, workspace))
                 {
-                    json_object_put(response);
+                    slack_json_free(response);
                     free(json_string);
                     return 0;
                 }
-                workspace->ws_url = strdup(json_object_get_string(url));
+                workspace->ws_url = strdup(slack_json_get_string(url));
             }
             else
             {
-                error = json_object_object_get(response, "error");
+                error = slack_json_object_get(response, "error");
                 if (!json_valid(error, workspace))
                 {
-                    json_object_put(response);
+                    slack_json_free(response);
                     free(json_string);
                     return 0;
                 }
@@ -244,11 +251,11 @@ static int callback_http(struct lws *wsi, enum lws_callback_reasons reason,
                 weechat_printf(
                     workspace->buffer,
                     _("%s%s: failed to request websocket: %s"),
-                    weechat_prefix("error"), SLACK_PLUGIN_NAME,
-                    json_object_get_string(error));
+                    SLACK_PREFIX_ERROR, SLACK_PLUGIN_NAME,
+                    slack_json_get_string(error));
             }
 
-            json_object_put(response);
+            slack_json_free(response);
             free(json_string);
         }
         /* fallthrough */
@@ -328,6 +335,68 @@ int slack_workspace_search_option(const char *option_name)
     return -1;
 }
 
+/*
+ * Hashes a name the way slack_workspace_name_keycmp_cb compares it: by
+ * characters lowercased with towlower.
+ */
+
+static unsigned long long slack_workspace_name_hash_cb(struct t_hashtable *hashtable,
+                                                       const void *key)
+{
+    const char *ptr_name;
+    unsigned long long hash;
+
+    (void) hashtable;
+
+    hash = 0xcbf29ce484222325ULL;
+    for (ptr_name = key; ptr_name && *ptr_name;
+         ptr_name = weechat_utf8_next_char(ptr_name))
+    {
+        hash ^= (unsigned long long)towlower(weechat_utf8_char_int(ptr_name));
+        hash *= 0x100000001b3ULL;
+    }
+
+    return hash;
+}
+
+static int slack_workspace_name_keycmp_cb(struct t_hashtable *hashtable,
+                                          const void *key1, const void *key2)
+{
+    const char *ptr_name1, *ptr_name2;
+    wint_t c1, c2;
+
+    (void) hashtable;
+
+    ptr_name1 = key1;
+    ptr_name2 = key2;
+    while (*ptr_name1 && *ptr_name2)
+    {
+        c1 = towlower(weechat_utf8_char_int(ptr_name1));
+        c2 = towlower(weechat_utf8_char_int(ptr_name2));
+        if (c1 != c2)
+            return (c1 > c2) - (c1 < c2);
+        ptr_name1 = weechat_utf8_next_char(ptr_name1);
+        ptr_name2 = weechat_utf8_next_char(ptr_name2);
+    }
+
+    return (*ptr_name1 != '\0') - (*ptr_name2 != '\0');
+}
+
+/*
+ * Creates a hashtable of names to pointers where keys match regardless of
+ * case, so that mentions and buffer names typed in any case resolve with
+ * a single lookup.
+ */
+
+struct t_hashtable *slack_workspace_name_hashtable_new(int size)
+{
+    return weechat_hashtable_new(size,
+                                 WEECHAT_HASHTABLE_STRING,
+                                 WEECHAT_HASHTABLE_POINTER,
+                                 &slack_workspace_name_hash_cb,
+                                 &slack_workspace_name_keycmp_cb);
+}
+
 struct t_slack_workspace *slack_workspace_alloc(const char *domain)
 {
     struct t_slack_workspace *new_workspace;
@@ -343,7 +412,7 @@ struct t_slack_workspace *slack_workspace_alloc(const char *domain)
     {
         weechat_printf(NULL,
                        _("%s%s: error when allocating new workspace"),
-                       weechat_prefix("error"), SLACK_PLUGIN_NAME);
+                       SLACK_PREFIX_ERROR, SLACK_PLUGIN_NAME);
         return NULL;
     }
 
@@ -376,6 +445,15 @@ struct t_slack_workspace *slack_workspace_alloc(const char *domain)
     new_workspace->client_wsi = NULL;
     new_workspace->context = NULL;
     new_workspace->json_chunks = NULL;
+    new_workspace->events_received = 0;
+    new_workspace->events_unhandled = 0;
+    new_workspace->events_dropped = 0;
+    new_workspace->events_handled_by_type = weechat_hashtable_new(
+        32, WEECHAT_HASHTABLE_STRING, WEECHAT_HASHTABLE_INTEGER, NULL, NULL);
+    new_workspace->events_unhandled_by_type = weechat_hashtable_new(
+        32, WEECHAT_HASHTABLE_STRING, WEECHAT_HASHTABLE_INTEGER, NULL, NULL);
+    new_workspace->events_dropped_by_type = weechat_hashtable_new(
+        32, WEECHAT_HASHTABLE_STRING, WEECHAT_HASHTABLE_INTEGER, NULL, NULL);
     new_workspace->requests = NULL;
     new_workspace->last_request = NULL;
 
@@ -384,12 +462,41 @@ struct t_slack_workspace *slack_workspace_alloc(const char *domain)
 
     new_workspace->buffer = NULL;
     new_workspace->buffer_as_string = NULL;
+    new_workspace->nicklist_loaded = 0;
+    new_workspace->strings = slack_intern_new();
+    new_workspace->users_arena = slack_arena_new(0);
     new_workspace->users = NULL;
     new_workspace->last_user = NULL;
+    new_workspace->users_by_id = slack_id_hashtable_new(256);
+    new_workspace->users_by_display_name = weechat_hashtable_new(
+        256, WEECHAT_HASHTABLE_STRING, WEECHAT_HASHTABLE_POINTER, NULL, NULL);
+    new_workspace->users_by_name = slack_workspace_name_hashtable_new(256);
+    new_workspace->users_by_index = NULL;
+    new_workspace->users_index_count = 0;
+    new_workspace->users_index_size = 0;
+    new_workspace->users_generation = 0;
+    new_workspace->channels_arena = slack_arena_new(0);
     new_workspace->channels = NULL;
     new_workspace->last_channel = NULL;
+    new_workspace->channels_by_id = slack_id_hashtable_new(64);
+    new_workspace->channels_by_name = slack_workspace_name_hashtable_new(64);
+    new_workspace->buffer_queue = NULL;
+    new_workspace->buffer_queue_next = 0;
+    new_workspace->buffer_queue_count = 0;
+    new_workspace->buffer_queue_size = 0;
+    new_workspace->typing_heap = NULL;
+    new_workspace->typing_heap_count = 0;
+    new_workspace->typing_heap_size = 0;
+    new_workspace->typing_timer = NULL;
+    new_workspace->emoji_arena = slack_arena_new(0);
     new_workspace->emoji = NULL;
     new_workspace->last_emoji = NULL;
+    new_workspace->emoji_by_name = weechat_hashtable_new(
+        64, WEECHAT_HASHTABLE_STRING, WEECHAT_HASHTABLE_POINTER, NULL, NULL);
+    new_workspace->emoji_count = 0;
+    new_workspace->emoji_sorted = NULL;
+    new_workspace->emoji_sorted_count = 0;
+    new_workspace->emoji_sorted_size = 0;
 
     /* create options with null value */
     for (i = 0; i < SLACK_WORKSPACE_NUM_OPTIONS; i++)
@@ -496,6 +603,7 @@ void slack_workspace_free_data(struct t_slack_workspace *workspace)
                 workspace->requests->uri = NULL;
             }
         }
+        slack_json_decoder_free(workspace->requests->decoder);
         free(workspace->requests);
         workspace->requests = request_ptr;
     }
@@ -508,8 +616,95 @@ void slack_workspace_free_data(struct t_slack_workspace *workspace)
     if (workspace->buffer_as_string)
         free(workspace->buffer_as_string);
 
+    slack_buffer_unregister(workspace->buffer);
+
     slack_channel_free_all(workspace);
     slack_user_free_all(workspace);
+
+    /* free hashtables */
+    if (workspace->users_by_id)
+    {
+        weechat_hashtable_free(workspace->users_by_id);
+        workspace->users_by_id = NULL;
+    }
+    if (workspace->users_by_display_name)
+    {
+        weechat_hashtable_free(workspace->users_by_display_name);
+        workspace->users_by_display_name = NULL;
+    }
+    if (workspace->users_by_name)
+    {
+        weechat_hashtable_free(workspace->users_by_name);
+        workspace->users_by_name = NULL;
+    }
+    if (workspace->channels_by_id)
+    {
+        weechat_hashtable_free(workspace->channels_by_id);
+        workspace->channels_by_id = NULL;
+    }
+    if (workspace->channels_by_name)
+    {
+        weechat_hashtable_free(workspace->channels_by_name);
+        workspace->channels_by_name = NULL;
+    }
+    if (workspace->events_handled_by_type)
+    {
+        weechat_hashtable_free(workspace->events_handled_by_type);
+        workspace->events_handled_by_type = NULL;
+    }
+    if (workspace->events_unhandled_by_type)
+    {
+        weechat_hashtable_free(workspace->events_unhandled_by_type);
+        workspace->events_unhandled_by_type = NULL;
+    }
+    if (workspace->events_dropped_by_type)
+    {
+        weechat_hashtable_free(workspace->events_dropped_by_type);
+        workspace->events_dropped_by_type = NULL;
+    }
+    if (workspace->users_by_index)
+    {
+        free(workspace->users_by_index);
+        workspace->users_by_index = NULL;
+    }
+
+    /* free typing scheduler (emptied by slack_channel_free_all) */
+    if (workspace->typing_timer)
+    {
+        weechat_unhook(workspace->typing_timer);
+        workspace->typing_timer = NULL;
+    }
+    if (workspace->typing_heap)
+    {
+        free(workspace->typing_heap);
+        workspace->typing_heap = NULL;
+    }
+    if (workspace->buffer_queue)
+    {
+        free(workspace->buffer_queue);
+        workspace->buffer_queue = NULL;
+    }
+
+    /* free arenas */
+    slack_workspace_emoji_free_all(workspace);
+    if (workspace->emoji_by_name)
+    {
+        weechat_hashtable_free(workspace->emoji_by_name);
+        workspace->emoji_by_name = NULL;
+    }
+    if (workspace->emoji_sorted)
+    {
+        free(workspace->emoji_sorted);
+        workspace->emoji_sorted = NULL;
+    }
+    slack_arena_free(workspace->users_arena);
+    workspace->users_arena = NULL;
+    slack_arena_free(workspace->channels_arena);
+    workspace->channels_arena = NULL;
+    slack_arena_free(workspace->emoji_arena);
+    workspace->emoji_arena = NULL;
+    slack_intern_free(workspace->strings);
+    workspace->strings = NULL;
 }
 
 void slack_workspace_free(struct t_slack_workspace *workspace)
@@ -571,14 +766,18 @@ void slack_workspace_disconnect(struct t_slack_workspace *workspace,
          */
         slack_user_free_all(workspace);
         weechat_nicklist_remove_all(workspace->buffer);
+        workspace->nicklist_loaded = 0;
         for (ptr_channel = workspace->channels; ptr_channel;
              ptr_channel = ptr_channel->next_channel)
         {
+            if (!ptr_channel->buffer)
+                continue;
             weechat_nicklist_remove_all(ptr_channel->buffer);
+            ptr_channel->nicklist_loaded = 0;
             weechat_printf(
                 ptr_channel->buffer,
                 _("%s%s: disconnected from workspace"),
-                weechat_prefix("network"), SLACK_PLUGIN_NAME);
+                SLACK_PREFIX_NETWORK, SLACK_PLUGIN_NAME);
         }
         /* remove away status on workspace buffer */
         //weechat_buffer_set(workspace->buffer, "localvar_del_away", "");
@@ -591,7 +790,7 @@ void slack_workspace_disconnect(struct t_slack_workspace *workspace,
         weechat_printf(
             workspace->buffer,
             _("%s%s: disconnected from workspace"),
-            weechat_prefix ("network"), SLACK_PLUGIN_NAME);
+            SLACK_PREFIX_NETWORK, SLACK_PLUGIN_NAME);
     }
 
     /*
@@ -675,6 +874,9 @@ struct t_gui_buffer *slack_workspace_create_buffer(struct t_slack_workspace *wor
     if (!workspace->buffer)
         return NULL;
 
+    slack_buffer_register(workspace->buffer, workspace, NULL);
+    workspace->nicklist_loaded = 0;
+
     if (!weechat_buffer_get_integer(workspace->buffer, "short_name_is_set"))
         weechat_buffer_set(workspace->buffer, "short_name", workspace->domain);
     weechat_buffer_set(workspace->buffer, "localvar_set_type", "server");
@@ -719,6 +921,8 @@ void slack_workspace_close_connection(struct t_slack_workspace *workspace)
                 free(ptr_request->uri);
                 ptr_request->uri = NULL;
             }
+            slack_json_decoder_free(ptr_request->decoder);
+            ptr_request->decoder = NULL;
 
             /* remove request from requests list */
             if (workspace->last_request == ptr_request)
@@ -750,7 +954,7 @@ void slack_workspace_websocket_create(struct t_slack_workspace *workspace)
         weechat_printf(
             workspace->buffer,
             _("%s%s: error: a websocket already exists"),
-            weechat_prefix("error"), SLACK_PLUGIN_NAME);
+            SLACK_PREFIX_ERROR, SLACK_PLUGIN_NAME);
         return;
     }
 
@@ -771,7 +975,7 @@ void slack_workspace_websocket_create(struct t_slack_workspace *workspace)
         weechat_printf(
             workspace->buffer,
             _("%s%s: error connecting to slack: lws init failed"),
-            weechat_prefix("error"), SLACK_PLUGIN_NAME);
+            SLACK_PREFIX_ERROR, SLACK_PLUGIN_NAME);
         return;
     }
     else
@@ -779,7 +983,7 @@ void slack_workspace_websocket_create(struct t_slack_workspace *workspace)
         weechat_printf(
             workspace->buffer,
             _("%s%s: contacting slack.com:443"),
-            weechat_prefix("network"), SLACK_PLUGIN_NAME);
+            SLACK_PREFIX_NETWORK, SLACK_PLUGIN_NAME);
     }
 
     memset(&i, 0, sizeof i); /* otherwise uninitialized garbage */
@@ -834,6 +1038,9 @@ int slack_workspace_timer_cb(const void *pointer, void *data, int remaining_call
         if (!ptr_workspace->is_connected)
             continue;
 
+        slack_channel_open_queued_buffers(ptr_workspace,
+                                          SLACK_WORKSPACE_BUFFERS_PER_TICK);
+
         for (ptr_request = ptr_workspace->requests; ptr_request;
              ptr_request = ptr_request->next_request)
         {
@@ -852,6 +1059,8 @@ int slack_workspace_timer_cb(const void *pointer, void *data, int remaining_call
                     free(ptr_request->uri);
                     ptr_request->uri = NULL;
                 }
+                slack_json_decoder_free(ptr_request->decoder);
+                ptr_request->decoder = NULL;
                 ptr_request->pointer = NULL;
                 if (ptr_request->data)
                 {
@@ -918,19 +1127,20 @@ struct t_slack_workspace_emoji *slack_workspace_emoji_search(
     struct t_slack_workspace *workspace,
     const char *name)
 {
-    struct t_slack_workspace_emoji *ptr_emoji;
+    char key[SLACK_WORKSPACE_EMOJI_SHORTNAME_MAX_LEN + 1];
+    int i;
 
-    if (!workspace || !name)
+    if (!workspace || !name || !workspace->emoji_by_name)
         return NULL;
 
-    for (ptr_emoji = workspace->emoji; ptr_emoji;
-         ptr_emoji = ptr_emoji->next_emoji)
-    {
-        if (weechat_strcasecmp(ptr_emoji->name, name) == 0)
-            return ptr_emoji;
-    }
+    /* emoji_by_name is keyed by lowercase shortname */
+    for (i = 0; name[i] && i < SLACK_WORKSPACE_EMOJI_SHORTNAME_MAX_LEN; i++)
+        key[i] = (name[i] >= 'A' && name[i] <= 'Z') ? name[i] - 'A' + 'a' : name[i];
+    if (name[i])
+        return NULL;
+    key[i] = '\0';
 
-    return NULL;
+    return weechat_hashtable_get(workspace->emoji_by_name, key);
 }
 
 struct t_slack_workspace_emoji *slack_workspace_add_emoji(
@@ -939,8 +1149,7 @@ struct t_slack_workspace_emoji *slack_workspace_add_emoji(
 {
     struct t_slack_workspace_emoji *ptr_emoji, *new_emoji;
     char shortname[SLACK_WORKSPACE_EMOJI_SHORTNAME_MAX_LEN + 1];
-    
-    (void) url;
+    int i;
     
     if (!workspace || !name || !name[0])
         return NULL;
@@ -954,11 +1163,20 @@ struct t_slack_workspace_emoji *slack_workspace_add_emoji(
         return ptr_emoji;
     }
 
-    if ((new_emoji = malloc(sizeof(*new_emoji))) == NULL)
+    new_emoji = slack_arena_alloc(workspace->emoji_arena, sizeof(*new_emoji));
+    if (!new_emoji)
         return NULL;
 
-    new_emoji->name = strdup(shortname);
-    new_emoji->url = strdup(url);
+    new_emoji->name = slack_arena_strdup(workspace->emoji_arena, shortname);
+    new_emoji->url = slack_arena_strdup(workspace->emoji_arena, url);
+    if (!new_emoji->name)
+        return NULL;
+    for (i = 0; new_emoji->name[i]; i++)
+    {
+        if (new_emoji->name[i] >= 'A' && new_emoji->name[i] <= 'Z')
+            new_emoji->name[i] += 'a' - 'A';
+    }
+    weechat_hashtable_set(workspace->emoji_by_name, new_emoji->name, new_emoji);
 
     new_emoji->prev_emoji = workspace->last_emoji;
     new_emoji->next_emoji = NULL;
@@ -967,6 +1185,85 @@ struct t_slack_workspace_emoji *slack_workspace_add_emoji(
     else
         workspace->emoji = new_emoji;
     workspace->last_emoji = new_emoji;
+    workspace->emoji_count++;
     
     return new_emoji;
 }
+
+void slack_workspace_emoji_free_all(struct t_slack_workspace *workspace)
+{
+    if (workspace->emoji_by_name)
+        weechat_hashtable_remove_all(workspace->emoji_by_name);
+    workspace->emoji = NULL;
+    workspace->last_emoji = NULL;
+    workspace->emoji_count = 0;
+    workspace->emoji_sorted_count = 0;
+    slack_arena_clear(workspace->emoji_arena);
+}
+
+static int slack_workspace_emoji_cmp(const void *p1, const void *p2)
+{
+    return strcmp((*(struct t_slack_workspace_emoji **)p1)->name,
+                  (*(struct t_slack_workspace_emoji **)p2)->name);
+}
+
+/*
+ * Returns the workspace emoji sorted by name, rebuilding the array only after
+ * emoji were added since the last call.
+ */
+
+struct t_slack_workspace_emoji **slack_workspace_emoji_sorted(
+    struct t_slack_workspace *workspace, int *count)
+{
+    struct t_slack_workspace_emoji *ptr_emoji, **new_sorted;
+    int i;
+
+    *count = 0;
+    if (!workspace)
+        return NULL;
+
+    if (workspace->emoji_sorted_count != workspace->emoji_count)
+    {
+        if (workspace->emoji_count > workspace->emoji_sorted_size)
+        {
+            new_sorted = realloc(workspace->emoji_sorted,
+                                 workspace->emoji_count * sizeof(*new_sorted));
+            if (!new_sorted)
+                return NULL;
+            workspace->emoji_sorted = new_sorted;
+            workspace->emoji_sorted_size = workspace->emoji_count;
+        }
+        i = 0;
+        for (ptr_emoji = workspace->emoji; ptr_emoji;
+             ptr_emoji = ptr_emoji->next_emoji)
+            workspace->emoji_sorted[i++] = ptr_emoji;
+        qsort(workspace->emoji_sorted, i, sizeof(*workspace->emoji_sorted),
+              &slack_workspace_emoji_cmp);
+        workspace->emoji_sorted_count = i;
+    }
+
+    *count = workspace->emoji_sorted_count;
+    return workspace->emoji_sorted;
+}
+
+size_t slack_workspace_memory(struct t_slack_workspace *workspace)
+{
+    struct t_slack_channel *ptr_channel;
+    size_t memory;
+
+    memory = slack_arena_memory(workspace->users_arena)
+        + slack_arena_memory(workspace->channels_arena)
+        + slack_arena_memory(workspace->emoji_arena)
+        + slack_intern_memory(workspace->strings)
+        + workspace->users_index_size * sizeof(*workspace->users_by_index)
+        + workspace->emoji_sorted_size * sizeof(*workspace->emoji_sorted);
+
+    for (ptr_channel = workspace->channels; ptr_channel;
+         ptr_channel = ptr_channel->next_channel)
+    {
+        memory += slack_memberset_memory(ptr_channel->members)
+            + ptr_channel->members_sorted_size * sizeof(*ptr_channel->members_sorted);
+    }
+
+    return memory;
+}
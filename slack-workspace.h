@@ -5,8 +5,14 @@
 #ifndef _SLACK_WORKSPACE_H_
 #define _SLACK_WORKSPACE_H_
 
+#include <stddef.h>
+#include <stdint.h>
+
 #define SLACK_WORKSPACE_EMOJI_SHORTNAME_MAX_LEN 1 + 100 + 1
 
+/* channel buffers created per timer tick while joining */
+#define SLACK_WORKSPACE_BUFFERS_PER_TICK 4
+
 extern struct t_slack_workspace *slack_workspaces;
 extern struct t_slack_workspace *last_slack_workspace;
 
@@ -50,6 +56,12 @@ struct t_slack_workspace
     struct lws *client_wsi;
     struct lws_context *context;
     struct t_json_chunk *json_chunks;
+    unsigned long events_received;
+    unsigned long events_unhandled;
+    unsigned long events_dropped; /* see slack.network.ignored_events */
+    struct t_hashtable *events_handled_by_type; /* type -> count */
+    struct t_hashtable *events_unhandled_by_type;
+    struct t_hashtable *events_dropped_by_type;
     struct t_slack_request *requests;
     struct t_slack_request *last_request;
 
@@ -58,12 +70,39 @@ struct t_slack_workspace
 
 	struct t_gui_buffer *buffer;
     char *buffer_as_string;
+    int nicklist_loaded;
+    struct t_slack_intern *strings;
+    struct t_slack_arena *users_arena;
     struct t_slack_user *users;
     struct t_slack_user *last_user;
+    struct t_hashtable *users_by_id;
+    struct t_hashtable *users_by_display_name;
+    struct t_hashtable *users_by_name; /* casefolded display and real names */
+    struct t_slack_user **users_by_index;
+    uint32_t users_index_count;
+    uint32_t users_index_size;
+    unsigned int users_generation; /* bumped when users are renamed or freed */
+    struct t_slack_arena *channels_arena;
     struct t_slack_channel *channels;
     struct t_slack_channel *last_channel;
+    struct t_hashtable *channels_by_id;
+    struct t_hashtable *channels_by_name; /* casefolded */
+    struct t_slack_channel **buffer_queue;
+    int buffer_queue_next;
+    int buffer_queue_count;
+    int buffer_queue_size;
+    struct t_slack_channel_typing **typing_heap;
+    int typing_heap_count;
+    int typing_heap_size;
+    struct t_hook *typing_timer;
+    struct t_slack_arena *emoji_arena;
 	struct t_slack_workspace_emoji *emoji;
     struct t_slack_workspace_emoji *last_emoji;
+    struct t_hashtable *emoji_by_name;
+    int emoji_count;
+    struct t_slack_workspace_emoji **emoji_sorted; /* by name, built lazily */
+    int emoji_sorted_count;
+    int emoji_sorted_size;
 	struct t_slack_workspace *prev_workspace;
     struct t_slack_workspace *next_workspace;
 };
@@ -73,6 +112,7 @@ extern char *slack_workspace_options[][2];
 struct t_slack_workspace *slack_workspace_search(const char *workspace_domain);
 struct t_slack_workspace *slack_workspace_casesearch (const char *workspace_domain);
 int slack_workspace_search_option(const char *option_name);
+struct t_hashtable *slack_workspace_name_hashtable_new(int size);
 struct t_slack_workspace *slack_workspace_alloc(const char *domain);
 void slack_workspace_free_data(struct t_slack_workspace *workspace);
 void slack_workspace_free(struct t_slack_workspace *workspace);
@@ -91,5 +131,10 @@ struct t_slack_workspace_emoji *slack_workspace_emoji_search(
 struct t_slack_workspace_emoji *slack_workspace_add_emoji(
     struct t_slack_workspace *workspace,
     const char *name, const char *url);
+void slack_workspace_emoji_free_all(struct t_slack_workspace *workspace);
+
+struct t_slack_workspace_emoji **slack_workspace_emoji_sorted(
+    struct t_slack_workspace *workspace, int *count);
+size_t slack_workspace_memory(struct t_slack_workspace *workspace);
 
 #endif /*SLACK_WORKSPACE_H*/
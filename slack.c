@@ -6,13 +6,17 @@
 #include <string.h>
 #include <time.h>
 #include <libwebsockets.h>
-#include <json.h>
 
 #include "weechat-plugin.h"
 #include "slack.h"
+#include "slack-json.h"
 #include "slack-config.h"
+#include "slack-color.h"
 #include "slack-command.h"
+#include "slack-id.h"
 #include "slack-workspace.h"
+#include "slack-user.h"
+#include "slack-emoji.h"
 #include "slack-api.h"
 #include "slack-buffer.h"
 #include "slack-completion.h"
@@ -28,6 +32,12 @@ WEECHAT_PLUGIN_PRIORITY(5500);
 struct t_weechat_plugin *weechat_slack_plugin = NULL;
 
 struct t_hook *slack_hook_timer = NULL;
+struct t_hook *slack_hook_buffer_switch = NULL;
+struct t_hook *slack_hook_window_switch = NULL;
+struct t_hook *slack_hook_input_return = NULL;
+struct t_hook *slack_hook_nick_colors = NULL;
+struct t_hook *slack_hook_nick_color_options = NULL;
+struct t_hook *slack_hook_colors = NULL;
 
 struct t_gui_bar_item *slack_typing_bar_item = NULL;
 
@@ -60,12 +70,39 @@ int weechat_plugin_init(struct t_weechat_plugin *plugin, int argc, char *argv[])
 
     slack_config_read();
 
-    slack_command_init();
+    slack_color_init();
 
-    slack_api_init();
+    slack_command_init();
 
     slack_completion_init();
 
+    slack_buffer_init();
+
+    slack_hook_buffer_switch = weechat_hook_signal("buffer_switch",
+                                                   &slack_buffer_switch_cb,
+                                                   NULL, NULL);
+    slack_hook_window_switch = weechat_hook_signal("window_switch",
+                                                   &slack_buffer_switch_cb,
+                                                   NULL, NULL);
+
+    slack_hook_input_return = weechat_hook_command_run("/input return",
+                                                       &slack_emoji_input_replace_cb,
+                                                       NULL, NULL);
+
+    /* colors, prefixes and palette all live under weechat.* */
+    slack_hook_colors = weechat_hook_config("weechat.*",
+                                            &slack_color_config_cb,
+                                            NULL, NULL);
+
+    /* cached nick colours follow the options weechat derives them from */
+    slack_hook_nick_colors = weechat_hook_config("weechat.color.chat_nick_colors",
+                                                 &slack_user_nick_colors_cb,
+                                                 NULL, NULL);
+
+    slack_hook_nick_color_options = weechat_hook_config("weechat.look.nick_color_*",
+                                                        &slack_user_nick_colors_cb,
+                                                        NULL, NULL);
+
     slack_hook_timer = weechat_hook_timer(0.1 * 1000, 0, 0,
                                           &slack_workspace_timer_cb,
                                           NULL, NULL);
@@ -96,11 +133,35 @@ int weechat_plugin_end(struct t_weechat_plugin *plugin)
     if (slack_hook_timer)
         weechat_unhook(slack_hook_timer);
 
+    if (slack_hook_buffer_switch)
+        weechat_unhook(slack_hook_buffer_switch);
+
+    if (slack_hook_window_switch)
+        weechat_unhook(slack_hook_window_switch);
+
+    if (slack_hook_input_return)
+        weechat_unhook(slack_hook_input_return);
+
+    if (slack_hook_nick_colors)
+        weechat_unhook(slack_hook_nick_colors);
+
+    if (slack_hook_nick_color_options)
+        weechat_unhook(slack_hook_nick_color_options);
+
+    if (slack_hook_colors)
+        weechat_unhook(slack_hook_colors);
+
     slack_config_write();
 
+    slack_config_free();
+
     slack_workspace_disconnect_all();
 
     slack_workspace_free_all();
 
+    slack_buffer_end();
+
+    slack_color_end();
+
     return WEECHAT_RC_OK;
 }
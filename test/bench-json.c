@@ -0,0 +1,630 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, version 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../weechat-plugin.h"
+#include "../slack-id.h"
+#include "../slack-json.h"
+
+/*
+ * Time and peak heap of JSON decoding on the fixtures in test/fixtures:
+ * RTM frames as received on the websocket, and Web API pages. Built once
+ * per JSON backend (bench-json-jsonc, bench-json-tape).
+ */
+
+#define BENCH_JSON_SECONDS 0.2
+
+/* what the users.list request reads from the socket at a time */
+#define BENCH_JSON_CHUNK 1024
+
+/*
+ * Heap accounting: malloc and friends are replaced (glibc forwards to its
+ * __libc_* entry points), so that allocations made inside json-c count too.
+ */
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *pointer, size_t size);
+extern void __libc_free(void *pointer);
+
+static size_t bench_json_heap = 0;
+static size_t bench_json_heap_peak = 0;
+
+static inline void bench_json_heap_add(void *pointer)
+{
+    bench_json_heap += malloc_usable_size(pointer);
+    if (bench_json_heap > bench_json_heap_peak)
+        bench_json_heap_peak = bench_json_heap;
+}
+
+void *malloc(size_t size)
+{
+    void *pointer;
+
+    pointer = __libc_malloc(size);
+    if (pointer)
+        bench_json_heap_add(pointer);
+
+    return pointer;
+}
+
+void *calloc(size_t count, size_t size)
+{
+    void *pointer;
+
+    pointer = __libc_calloc(count, size);
+    if (pointer)
+        bench_json_heap_add(pointer);
+
+    return pointer;
+}
+
+void *realloc(void *pointer, size_t size)
+{
+    void *new_pointer;
+    size_t old_size;
+
+    old_size = (pointer) ? malloc_usable_size(pointer) : 0;
+    new_pointer = __libc_realloc(pointer, size);
+    if (new_pointer || size == 0)
+        bench_json_heap -= old_size;
+    if (new_pointer)
+        bench_json_heap_add(new_pointer);
+
+    return new_pointer;
+}
+
+void free(void *pointer)
+{
+    if (!pointer)
+        return;
+
+    bench_json_heap -= malloc_usable_size(pointer);
+    __libc_free(pointer);
+}
+
+/* a fixture: a whole page, or frames split on newlines */
+struct t_bench_json_input
+{
+    char *text;
+    size_t length;
+    char **frames;
+    int num_frames;
+};
+
+/* a field read from each record of a page, as the request reads it */
+struct t_bench_json_path
+{
+    const char *path;
+    enum t_slack_json_type type;
+};
+
+static const struct t_bench_json_path bench_json_member_paths[] =
+{
+    { "id", SLACK_JSON_STRING },
+    { "name", SLACK_JSON_STRING },
+    { "profile.display_name", SLACK_JSON_STRING },
+    { "profile.real_name", SLACK_JSON_STRING },
+    { "profile.bot_id", SLACK_JSON_STRING },
+    { "team_id", SLACK_JSON_STRING },
+    { "profile.team", SLACK_JSON_STRING },
+    { "tz", SLACK_JSON_STRING },
+    { "tz_label", SLACK_JSON_STRING },
+    { "locale", SLACK_JSON_STRING },
+    { "profile.status_emoji", SLACK_JSON_STRING },
+    { "tz_offset", SLACK_JSON_INTEGER },
+    { NULL, 0 },
+};
+
+static const struct t_bench_json_path bench_json_channel_paths[] =
+{
+    { "id", SLACK_JSON_STRING },
+    { "name", SLACK_JSON_STRING },
+    { "created", SLACK_JSON_INTEGER },
+    { "is_general", SLACK_JSON_BOOLEAN },
+    { "name_normalized", SLACK_JSON_STRING },
+    { "is_shared", SLACK_JSON_BOOLEAN },
+    { "is_org_shared", SLACK_JSON_BOOLEAN },
+    { "is_member", SLACK_JSON_BOOLEAN },
+    { "topic.value", SLACK_JSON_STRING },
+    { "topic.creator", SLACK_JSON_STRING },
+    { "topic.last_set", SLACK_JSON_INTEGER },
+    { "purpose.value", SLACK_JSON_STRING },
+    { "purpose.creator", SLACK_JSON_STRING },
+    { "purpose.last_set", SLACK_JSON_INTEGER },
+    { "is_archived", SLACK_JSON_BOOLEAN },
+    { "creator", SLACK_JSON_STRING },
+    { NULL, 0 },
+};
+
+/* checksum of what was read, so that nothing is optimised away */
+static unsigned long bench_json_sum = 0;
+
+static double bench_json_now()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int bench_json_load(struct t_bench_json_input *input,
+                           const char *directory, const char *name)
+{
+    char path[4096], *ptr_text, *ptr_end;
+    FILE *file;
+    long size;
+
+    memset(input, 0, sizeof(*input));
+
+    snprintf(path, sizeof(path), "%s/%s", directory, name);
+    file = fopen(path, "rb");
+    if (!file)
+    {
+        fprintf(stderr, "bench-json: cannot open %s\n", path);
+        return 0;
+    }
+    fseek(file, 0, SEEK_END);
+    size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    input->text = malloc(size + 1);
+    if (!input->text || fread(input->text, 1, size, file) != (size_t)size)
+    {
+        fclose(file);
+        return 0;
+    }
+    fclose(file);
+    input->text[size] = '\0';
+    input->length = size;
+
+    /* one frame per line */
+    input->frames = malloc((size + 1) * sizeof(*input->frames));
+    if (!input->frames)
+        return 0;
+    for (ptr_text = input->text; *ptr_text; ptr_text = ptr_end + 1)
+    {
+        ptr_end = strchr(ptr_text, '\n');
+        if (!ptr_end)
+            ptr_end = ptr_text + strlen(ptr_text) - 1;
+        else
+            *ptr_end = '\0';
+        if (*ptr_text)
+            input->frames[input->num_frames++] = ptr_text;
+    }
+
+    return 1;
+}
+
+static void bench_json_input_free(struct t_bench_json_input *input)
+{
+    free(input->frames);
+    free(input->text);
+}
+
+/*
+ * Runs work once to measure its peak heap, then repeatedly for a while to
+ * time it; prints both.
+ */
+
+static void bench_json_run(const char *name, const char *unit, int units,
+                           size_t bytes, void (*work)(const void *data),
+                           const void *data)
+{
+    size_t heap;
+    double start, elapsed;
+    long count;
+
+    heap = bench_json_heap;
+    bench_json_heap_peak = heap;
+    work(data);
+    heap = bench_json_heap_peak - heap;
+
+    count = 0;
+    start = bench_json_now();
+    do
+    {
+        work(data);
+        count++;
+        elapsed = bench_json_now() - start;
+    }
+    while (elapsed < BENCH_JSON_SECONDS);
+
+    printf("  %-38s %8.2f us/%-6s %7.1f MB/s %9zu bytes peak heap\n",
+           name, elapsed * 1e6 / count / units, unit,
+           (double)bytes * count / elapsed / 1e6, heap);
+}
+
+static struct t_slack_json_value *bench_json_tree_get(struct t_slack_json_value *value,
+                                                      const char *path)
+{
+    char key[64];
+    const char *ptr_dot;
+    size_t length;
+
+    while (value && (ptr_dot = strchr(path, '.')))
+    {
+        length = ptr_dot - path;
+        if (length >= sizeof(key))
+            return NULL;
+        memcpy(key, path, length);
+        key[length] = '\0';
+        value = slack_json_object_get(value, key);
+        path = ptr_dot + 1;
+    }
+
+    return (value) ? slack_json_object_get(value, path) : NULL;
+}
+
+static void bench_json_tree_read(struct t_slack_json_value *record,
+                                 const struct t_bench_json_path *paths)
+{
+    struct t_slack_json_value *value;
+    const char *string;
+    int i;
+
+    for (i = 0; paths[i].path; i++)
+    {
+        value = bench_json_tree_get(record, paths[i].path);
+        if (!value)
+            continue;
+        switch (paths[i].type)
+        {
+            case SLACK_JSON_STRING:
+                string = slack_json_get_string(value);
+                bench_json_sum += (string) ? strlen(string) : 0;
+                break;
+            case SLACK_JSON_BOOLEAN:
+                bench_json_sum += slack_json_get_boolean(value);
+                break;
+            case SLACK_JSON_INTEGER:
+                bench_json_sum += slack_json_get_int(value);
+                break;
+        }
+    }
+}
+
+/* what slack-api.c does with each frame before dispatching it */
+static void bench_json_rtm_work(const void *data)
+{
+    const struct t_bench_json_input *input;
+    struct t_slack_json_value *frame;
+    const char *type;
+    int i;
+
+    input = data;
+    for (i = 0; i < input->num_frames; i++)
+    {
+        frame = slack_json_parse(input->frames[i]);
+        type = slack_json_get_string(slack_json_object_get(frame, "type"));
+        bench_json_sum += (type) ? type[0] : 0;
+        slack_json_free(frame);
+    }
+}
+
+struct t_bench_json_page
+{
+    const struct t_bench_json_input *input;
+    const char *records;
+    const struct t_bench_json_path *paths;
+};
+
+static void bench_json_page_tree_work(const void *data)
+{
+    const struct t_bench_json_page *page;
+    struct t_slack_json_value *root, *records;
+    int i, length;
+
+    page = data;
+    root = slack_json_parse(page->input->text);
+    bench_json_sum += slack_json_get_boolean(slack_json_object_get(root, "ok"));
+    records = slack_json_object_get(root, page->records);
+    length = slack_json_array_length(records);
+    for (i = 0; i < length; i++)
+        bench_json_tree_read(slack_json_array_get(records, i), page->paths);
+    slack_json_free(root);
+}
+
+static void bench_json_page(const char *directory, const char *name,
+                            const char *records,
+                            const struct t_bench_json_path *paths)
+{
+    struct t_bench_json_input input;
+    struct t_bench_json_page page;
+    struct t_slack_json_value *root;
+    char title[64];
+    int count;
+
+    if (!bench_json_load(&input, directory, name))
+        exit(1);
+
+    root = slack_json_parse(input.text);
+    count = slack_json_array_length(slack_json_object_get(root, records));
+    slack_json_free(root);
+
+    page.input = &input;
+    page.records = records;
+    page.paths = paths;
+    snprintf(title, sizeof(title), "%s (%d %s)", name, count, records);
+    bench_json_run(title, "page", 1, input.length,
+                   &bench_json_page_tree_work, &page);
+
+    bench_json_input_free(&input);
+}
+
+/*
+ * users.list as the request decodes it: the same result and member structs,
+ * the page fed to the streaming decoder in socket-sized chunks.
+ */
+
+struct t_bench_json_users_result
+{
+    unsigned int found;
+    int ok;
+    char error[64];
+    char next_cursor[64];
+};
+
+static const struct t_slack_json_field bench_json_users_fields[] =
+{
+    SLACK_JSON_FIELD(struct t_bench_json_users_result, "ok",
+                     SLACK_JSON_BOOLEAN, ok),
+    SLACK_JSON_FIELD(struct t_bench_json_users_result, "error",
+                     SLACK_JSON_STRING, error),
+    SLACK_JSON_FIELD(struct t_bench_json_users_result,
+                     "response_metadata.next_cursor",
+                     SLACK_JSON_STRING, next_cursor),
+};
+
+struct t_bench_json_member
+{
+    unsigned int found;
+    char id[SLACK_ID_MAX_LEN + 2];
+    char name[128];
+    char display_name[256];
+    char real_name[256];
+    char bot_id[SLACK_ID_MAX_LEN + 2];
+    char team_id[SLACK_ID_MAX_LEN + 2];
+    char team[SLACK_ID_MAX_LEN + 2];
+    char tz[64];
+    char tz_label[128];
+    char locale[16];
+    char status_emoji[128];
+    long tz_offset;
+};
+
+static const struct t_slack_json_field bench_json_member_fields[] =
+{
+    SLACK_JSON_FIELD(struct t_bench_json_member, "id",
+                     SLACK_JSON_STRING, id),
+    SLACK_JSON_FIELD(struct t_bench_json_member, "name",
+                     SLACK_JSON_STRING, name),
+    SLACK_JSON_FIELD(struct t_bench_json_member, "profile.display_name",
+                     SLACK_JSON_STRING, display_name),
+    SLACK_JSON_FIELD(struct t_bench_json_member, "profile.real_name",
+                     SLACK_JSON_STRING, real_name),
+    SLACK_JSON_FIELD(struct t_bench_json_member, "profile.bot_id",
+                     SLACK_JSON_STRING, bot_id),
+    SLACK_JSON_FIELD(struct t_bench_json_member, "team_id",
+                     SLACK_JSON_STRING, team_id),
+    SLACK_JSON_FIELD(struct t_bench_json_member, "profile.team",
+                     SLACK_JSON_STRING, team),
+    SLACK_JSON_FIELD(struct t_bench_json_member, "tz",
+                     SLACK_JSON_STRING, tz),
+    SLACK_JSON_FIELD(struct t_bench_json_member, "tz_label",
+                     SLACK_JSON_STRING, tz_label),
+    SLACK_JSON_FIELD(struct t_bench_json_member, "locale",
+                     SLACK_JSON_STRING, locale),
+    SLACK_JSON_FIELD(struct t_bench_json_member, "profile.status_emoji",
+                     SLACK_JSON_STRING, status_emoji),
+    SLACK_JSON_FIELD(struct t_bench_json_member, "tz_offset",
+                     SLACK_JSON_INTEGER, tz_offset),
+};
+
+static void bench_json_member_cb(void *data, const void *record)
+{
+    const struct t_bench_json_member *member;
+
+    (void) data;
+
+    member = record;
+    bench_json_sum += strlen(member->id) + strlen(member->name)
+        + strlen(member->display_name) + strlen(member->real_name)
+        + strlen(member->bot_id) + strlen(member->team_id)
+        + strlen(member->team) + strlen(member->tz)
+        + strlen(member->tz_label) + strlen(member->locale)
+        + strlen(member->status_emoji) + member->tz_offset;
+}
+
+static const struct t_slack_json_table bench_json_users_table =
+{
+    bench_json_users_fields,
+    sizeof(bench_json_users_fields) / sizeof(bench_json_users_fields[0]),
+    sizeof(struct t_bench_json_users_result),
+    "members",
+    bench_json_member_fields,
+    sizeof(bench_json_member_fields) / sizeof(bench_json_member_fields[0]),
+    sizeof(struct t_bench_json_member),
+    &bench_json_member_cb,
+};
+
+static void bench_json_page_decoder_work(const void *data)
+{
+    const struct t_bench_json_page *page;
+    const struct t_bench_json_users_result *result;
+    struct t_slack_json_decoder *decoder;
+    size_t offset, length;
+
+    page = data;
+    decoder = slack_json_decoder_new(&bench_json_users_table, NULL);
+    for (offset = 0; offset < page->input->length; offset += length)
+    {
+        length = page->input->length - offset;
+        if (length > BENCH_JSON_CHUNK)
+            length = BENCH_JSON_CHUNK;
+        slack_json_decoder_feed(decoder, page->input->text + offset, length);
+    }
+    result = slack_json_decoder_finish(decoder);
+    bench_json_sum += (result) ? result->ok : 0;
+    slack_json_decoder_free(decoder);
+}
+
+/* end of the array that starts at text, or NULL */
+static const char *bench_json_array_end(const char *text)
+{
+    int depth, string;
+
+    depth = 0;
+    string = 0;
+    for (; *text; text++)
+    {
+        if (string)
+        {
+            if (*text == '\\' && text[1])
+                text++;
+            else if (*text == '"')
+                string = 0;
+            continue;
+        }
+        switch (*text)
+        {
+            case '"':
+                string = 1;
+                break;
+            case '[':
+            case '{':
+                depth++;
+                break;
+            case ']':
+            case '}':
+                if (--depth == 0)
+                    return text;
+                break;
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * The users.list page with its members repeated, so that the heap used by
+ * the tree can be seen to grow with the page while the decoder's does not.
+ */
+
+static int bench_json_users_repeat(struct t_bench_json_input *page,
+                                   const struct t_bench_json_input *input,
+                                   int times)
+{
+    const char *ptr_start, *ptr_end;
+    size_t length_head, length_members, length_tail;
+    char *ptr_text;
+    int i;
+
+    memset(page, 0, sizeof(*page));
+
+    ptr_start = strstr(input->text, "\"members\":[");
+    if (!ptr_start)
+        return 0;
+    ptr_start += strlen("\"members\":");
+    ptr_end = bench_json_array_end(ptr_start);
+    if (!ptr_end)
+        return 0;
+
+    length_head = ptr_start + 1 - input->text;
+    length_members = ptr_end - (ptr_start + 1);
+    length_tail = input->length - (ptr_end - input->text);
+
+    page->length = length_head + times * (length_members + 1) - 1 + length_tail;
+    page->text = malloc(page->length + 1);
+    if (!page->text)
+        return 0;
+
+    ptr_text = page->text;
+    memcpy(ptr_text, input->text, length_head);
+    ptr_text += length_head;
+    for (i = 0; i < times; i++)
+    {
+        if (i > 0)
+            *ptr_text++ = ',';
+        memcpy(ptr_text, ptr_start + 1, length_members);
+        ptr_text += length_members;
+    }
+    memcpy(ptr_text, ptr_end, length_tail);
+    page->text[page->length] = '\0';
+
+    return 1;
+}
+
+static void bench_json_users(const char *directory)
+{
+    static const int repeats[] = { 1, 10, 100 };
+    struct t_bench_json_input input, repeated;
+    struct t_bench_json_page page;
+    struct t_slack_json_value *root;
+    char title[64];
+    int count;
+    size_t i;
+
+    if (!bench_json_load(&input, directory, "users-list.json"))
+        exit(1);
+
+    page.records = "members";
+    page.paths = bench_json_member_paths;
+    for (i = 0; i < sizeof(repeats) / sizeof(repeats[0]); i++)
+    {
+        if (!bench_json_users_repeat(&repeated, &input, repeats[i]))
+        {
+            fprintf(stderr, "bench-json: no members in users-list.json\n");
+            exit(1);
+        }
+        page.input = &repeated;
+
+        root = slack_json_parse(repeated.text);
+        count = slack_json_array_length(slack_json_object_get(root, "members"));
+        slack_json_free(root);
+
+        snprintf(title, sizeof(title), "users.list x%d (%d members) tree",
+                 repeats[i], count);
+        bench_json_run(title, "page", 1, repeated.length,
+                       &bench_json_page_tree_work, &page);
+        snprintf(title, sizeof(title), "users.list x%d (%d members) decoder",
+                 repeats[i], count);
+        bench_json_run(title, "page", 1, repeated.length,
+                       &bench_json_page_decoder_work, &page);
+
+        bench_json_input_free(&repeated);
+    }
+
+    bench_json_input_free(&input);
+}
+
+int main(int argc, char *argv[])
+{
+    struct t_bench_json_input input;
+    const char *directory;
+    char title[64];
+
+    directory = (argc > 1) ? argv[1] : "test/fixtures";
+
+    printf("%s:\n", argv[0]);
+
+    if (!bench_json_load(&input, directory, "rtm-frames.jsonl"))
+        return 1;
+    snprintf(title, sizeof(title), "rtm-frames.jsonl (%d frames)",
+             input.num_frames);
+    bench_json_run(title, "frame", input.num_frames, input.length,
+                   &bench_json_rtm_work, &input);
+    bench_json_input_free(&input);
+
+    bench_json_users(directory);
+    bench_json_page(directory, "channels-list.json", "channels",
+                    bench_json_channel_paths);
+
+    return (bench_json_sum) ? 0 : 1;
+}
@@ -0,0 +1,160 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, version 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <libwebsockets.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../weechat-plugin.h"
+#include "../slack.h"
+#include "../slack-workspace.h"
+#include "../slack-message.h"
+#include "stubs.h"
+
+/*
+ * Microbenchmark of slack_message_decode: time per message and per byte, and
+ * allocations per message, for each kind of text, plain text being by far
+ * the most common. Each text is decoded with slack.look.render_mrkdwn off
+ * first, as a baseline, then on.
+ */
+
+#define BENCH_MESSAGE_SECONDS 0.2
+
+/*
+ * Allocation count: malloc and friends are replaced (glibc forwards to its
+ * __libc_* entry points).
+ */
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *pointer, size_t size);
+
+static long bench_message_allocations = 0;
+
+void *malloc(size_t size)
+{
+    bench_message_allocations++;
+
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size)
+{
+    bench_message_allocations++;
+
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *pointer, size_t size)
+{
+    bench_message_allocations++;
+
+    return __libc_realloc(pointer, size);
+}
+
+static const char *bench_message_texts[][2] =
+{
+    { "plain",
+      "sounds good, I'll pick it up after lunch and let you know how it goes" },
+    { "mentions",
+      "<@U0ALICE> could you look at <#C0GENERAL|general>? "
+      "details in <https://example.com/issues/42|the issue>" },
+    { "mrkdwn",
+      "*deploy* finished in _3m12s_, ~maybe~ run `make check` first:\n"
+      "```make check\nall tests passed```" },
+    { "emoji",
+      "nice work :+1: :tada: that was quick :smile: :ok_hand: :unknown:" },
+    { "entities",
+      "if a &lt; b &amp;&amp; c &gt; d then swap &amp; retry" },
+};
+
+static double bench_message_now()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void bench_message_measure(struct t_slack_workspace *workspace,
+                                  const char *text, size_t length)
+{
+    double start, elapsed;
+    long allocations, count, i;
+    char *decoded;
+
+    allocations = bench_message_allocations;
+    decoded = slack_message_decode(workspace, text);
+    allocations = bench_message_allocations - allocations;
+    free(decoded);
+
+    count = 0;
+    start = bench_message_now();
+    do
+    {
+        for (i = 0; i < 1000; i++)
+        {
+            decoded = slack_message_decode(workspace, text);
+            free(decoded);
+        }
+        count += i;
+        elapsed = bench_message_now() - start;
+    }
+    while (elapsed < BENCH_MESSAGE_SECONDS);
+
+    printf(" %9.1f ns/message %6.2f ns/byte %2ld allocations",
+           elapsed * 1e9 / count, elapsed * 1e9 / count / length,
+           allocations);
+}
+
+static void bench_message_run(struct t_slack_workspace *workspace,
+                              const char *name, const char *text)
+{
+    size_t length;
+
+    length = strlen(text);
+
+    printf("  %-10s %6zu bytes\n    without mrkdwn:", name, length);
+    stubs_render_mrkdwn = 0;
+    bench_message_measure(workspace, text, length);
+    printf("\n    with mrkdwn:   ");
+    stubs_render_mrkdwn = 1;
+    bench_message_measure(workspace, text, length);
+    printf("\n");
+}
+
+int main(int argc, char *argv[])
+{
+    struct t_slack_workspace workspace;
+    char *long_text;
+    size_t i, length;
+
+    (void) argc;
+
+    memset(&workspace, 0, sizeof(workspace));
+
+    printf("%s:\n", argv[0]);
+    for (i = 0; i < sizeof(bench_message_texts) / sizeof(bench_message_texts[0]); i++)
+        bench_message_run(&workspace, bench_message_texts[i][0],
+                          bench_message_texts[i][1]);
+
+    /* a long paste without markup: only the scan for markup runs */
+    length = strlen(bench_message_texts[0][1]);
+    long_text = malloc(64 * (length + 1) + 1);
+    if (!long_text)
+        return 1;
+    for (i = 0; i < 64; i++)
+    {
+        memcpy(long_text + i * (length + 1), bench_message_texts[0][1], length);
+        long_text[i * (length + 1) + length] = '\n';
+    }
+    long_text[64 * (length + 1)] = '\0';
+    bench_message_run(&workspace, "plain-long", long_text);
+    free(long_text);
+
+    return 0;
+}
@@ -0,0 +1,79 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, version 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <libwebsockets.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "../weechat-plugin.h"
+#include "../slack.h"
+#include "../slack-id.h"
+#include "../slack-workspace.h"
+#include "../slack-channel.h"
+#include "../slack-user.h"
+#include "../slack-emoji.h"
+
+/* slack.look.render_mrkdwn, on unless a test turns it off */
+int stubs_render_mrkdwn = 1;
+struct t_config_option *slack_config_look_render_mrkdwn =
+    (struct t_config_option *)&stubs_render_mrkdwn;
+
+/*
+ * Directory lookups made by slack_message_decode: one user (U0ALICE), one
+ * channel (C0GENERAL) and a handful of emoji.
+ */
+
+static struct t_slack_user stubs_user =
+{
+    .profile = { .display_name = "alice" },
+};
+
+static struct t_slack_channel stubs_channel =
+{
+    .name = "general",
+};
+
+static const char *stubs_emoji[][2] =
+{
+    { ":smile:", "\xf0\x9f\x98\x84" },
+    { ":+1:", "\xf0\x9f\x91\x8d" },
+    { ":ok_hand:", "\xf0\x9f\x91\x8c" },
+    { ":tada:", "\xf0\x9f\x8e\x89" },
+    /* custom emoji may end with '_' */
+    { ":x_:", "[x_]" },
+};
+
+struct t_slack_user *slack_user_search_id(struct t_slack_workspace *workspace,
+                                          t_slack_id id)
+{
+    (void) workspace;
+
+    return (id == slack_id_encode("U0ALICE")) ? &stubs_user : NULL;
+}
+
+struct t_slack_channel *slack_channel_search_id(struct t_slack_workspace *workspace,
+                                                t_slack_id id)
+{
+    (void) workspace;
+
+    return (id == slack_id_encode("C0GENERAL")) ? &stubs_channel : NULL;
+}
+
+const char *slack_emoji_get_unicode_by_shortcode(struct t_slack_workspace *workspace,
+                                                 const char *shortcode,
+                                                 size_t length)
+{
+    size_t i;
+
+    (void) workspace;
+
+    for (i = 0; i < sizeof(stubs_emoji) / sizeof(stubs_emoji[0]); i++)
+    {
+        if (strlen(stubs_emoji[i][0]) == length
+            && memcmp(stubs_emoji[i][0], shortcode, length) == 0)
+            return stubs_emoji[i][1];
+    }
+
+    return NULL;
+}
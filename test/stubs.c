@@ -0,0 +1,192 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, version 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+
+#include "../weechat-plugin.h"
+#include "../slack.h"
+#include "../slack-color.h"
+#include "stubs.h"
+
+/*
+ * The few weechat functions reached by the code under test, so that it can
+ * run outside of weechat. Colours are readable markers, for expected output.
+ */
+
+int stubs_timers = 0;
+int stubs_bar_item_updates = 0;
+
+static const char *stubs_gettext(const char *string)
+{
+    return string;
+}
+
+static void stubs_printf_date_tags(struct t_gui_buffer *buffer, time_t date,
+                                   const char *tags, const char *message, ...)
+{
+    va_list args;
+
+    (void) buffer;
+    (void) date;
+    (void) tags;
+
+    va_start(args, message);
+    vfprintf(stderr, message, args);
+    va_end(args);
+    fputc('\n', stderr);
+}
+
+static const char *stubs_buffer_get_string(struct t_gui_buffer *buffer,
+                                           const char *property)
+{
+    (void) buffer;
+    (void) property;
+
+    return NULL;
+}
+
+static void stubs_buffer_set(struct t_gui_buffer *buffer, const char *property,
+                             const char *value)
+{
+    (void) buffer;
+    (void) property;
+    (void) value;
+}
+
+static const char *stubs_utf8_next_char(const char *string)
+{
+    if (!string || !*string)
+        return NULL;
+
+    string++;
+    while ((*string & 0xC0) == 0x80)
+        string++;
+
+    return string;
+}
+
+static int stubs_utf8_char_int(const char *string)
+{
+    const unsigned char *ptr_string;
+
+    ptr_string = (const unsigned char *)string;
+    if (ptr_string[0] < 0x80)
+        return ptr_string[0];
+    if ((ptr_string[0] & 0xE0) == 0xC0 && ptr_string[1])
+        return ((ptr_string[0] & 0x1F) << 6) | (ptr_string[1] & 0x3F);
+    if ((ptr_string[0] & 0xF0) == 0xE0 && ptr_string[1] && ptr_string[2])
+        return ((ptr_string[0] & 0x0F) << 12) | ((ptr_string[1] & 0x3F) << 6)
+            | (ptr_string[2] & 0x3F);
+    if (ptr_string[1] && ptr_string[2] && ptr_string[3])
+        return ((ptr_string[0] & 0x07) << 18) | ((ptr_string[1] & 0x3F) << 12)
+            | ((ptr_string[2] & 0x3F) << 6) | (ptr_string[3] & 0x3F);
+
+    return ptr_string[0];
+}
+
+static struct t_gui_nick_group *stubs_nicklist_search_group(
+    struct t_gui_buffer *buffer, struct t_gui_nick_group *from_group,
+    const char *name)
+{
+    (void) buffer;
+    (void) from_group;
+    (void) name;
+
+    return NULL;
+}
+
+static const char *stubs_info_get(struct t_weechat_plugin *plugin,
+                                  const char *info_name,
+                                  const char *arguments)
+{
+    (void) plugin;
+    (void) info_name;
+    (void) arguments;
+
+    return NULL;
+}
+
+/* options under test point to an int holding their value */
+static int stubs_config_boolean(struct t_config_option *option)
+{
+    return (option) ? *(int *)option : 0;
+}
+
+static struct t_hook *stubs_hook_timer(struct t_weechat_plugin *plugin,
+                                       long interval, int align_second,
+                                       int max_calls,
+                                       int (*callback)(const void *pointer,
+                                                       void *data,
+                                                       int remaining_calls),
+                                       const void *callback_pointer,
+                                       void *callback_data)
+{
+    static char hook;
+
+    (void) plugin;
+    (void) interval;
+    (void) align_second;
+    (void) max_calls;
+    (void) callback;
+    (void) callback_pointer;
+    (void) callback_data;
+
+    stubs_timers++;
+
+    return (struct t_hook *)&hook;
+}
+
+static void stubs_unhook(struct t_hook *hook)
+{
+    (void) hook;
+}
+
+static void stubs_bar_item_update(const char *name)
+{
+    (void) name;
+
+    stubs_bar_item_updates++;
+}
+
+static struct t_weechat_plugin stubs_plugin =
+{
+    .gettext = &stubs_gettext,
+    .strcasecmp = &strcasecmp,
+    .utf8_next_char = &stubs_utf8_next_char,
+    .utf8_char_int = &stubs_utf8_char_int,
+    .printf_date_tags = &stubs_printf_date_tags,
+    .buffer_get_string = &stubs_buffer_get_string,
+    .buffer_set = &stubs_buffer_set,
+    .nicklist_search_group = &stubs_nicklist_search_group,
+    .config_boolean = &stubs_config_boolean,
+    .info_get = &stubs_info_get,
+    .hook_timer = &stubs_hook_timer,
+    .unhook = &stubs_unhook,
+    .bar_item_update = &stubs_bar_item_update,
+};
+
+struct t_weechat_plugin *weechat_slack_plugin = &stubs_plugin;
+
+struct t_slack_color_escape slack_color_escapes[SLACK_NUM_COLORS] =
+{
+    [SLACK_COLOR_RESET] = { "{reset}", 7 },
+    [SLACK_COLOR_RESETCOLOR] = { "{/color}", 8 },
+    [SLACK_COLOR_BOLD] = { "{b}", 3 },
+    [SLACK_COLOR_UNBOLD] = { "{/b}", 4 },
+    [SLACK_COLOR_ITALIC] = { "{i}", 3 },
+    [SLACK_COLOR_UNITALIC] = { "{/i}", 4 },
+    [SLACK_COLOR_CHAT_NICK] = { "{nick}", 6 },
+    [SLACK_COLOR_CHAT_VALUE] = { "{value}", 7 },
+    [SLACK_COLOR_CHAT_DELIMITERS] = { "{delim}", 7 },
+};
+
+struct t_slack_color_escape slack_color_prefixes[SLACK_NUM_COLOR_PREFIXES] =
+{
+    [SLACK_COLOR_PREFIX_ERROR] = { "=!= ", 4 },
+    [SLACK_COLOR_PREFIX_NETWORK] = { "-- ", 3 },
+    [SLACK_COLOR_PREFIX_ACTION] = { " * ", 3 },
+};
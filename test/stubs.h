@@ -0,0 +1,15 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, version 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef _SLACK_TEST_STUBS_H_
+#define _SLACK_TEST_STUBS_H_
+
+/* calls seen by the weechat stubs */
+extern int stubs_timers;
+extern int stubs_bar_item_updates;
+
+/* options read by the code under test (test/stubs-message.c) */
+extern int stubs_render_mrkdwn;
+
+#endif /*SLACK_TEST_STUBS_H*/
@@ -0,0 +1,296 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, version 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <libwebsockets.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../weechat-plugin.h"
+#include "../slack.h"
+#include "../slack-id.h"
+#include "../slack-workspace.h"
+#include "../slack-channel.h"
+#include "../slack-user.h"
+#include "../slack-buffer.h"
+#include "../slack-input.h"
+#include "stubs.h"
+#include "test.h"
+
+#define TEST_CHANNEL_TYPERS 1000
+
+/*
+ * Buffers, input and the user directory are linked in by slack-channel.c
+ * but not reached by typing notifications: channels under test have no
+ * buffer.
+ */
+
+void slack_buffer_register(struct t_gui_buffer *buffer,
+                           struct t_slack_workspace *workspace,
+                           struct t_slack_channel *channel)
+{
+    (void) buffer;
+    (void) workspace;
+    (void) channel;
+}
+
+void slack_buffer_unregister(struct t_gui_buffer *buffer)
+{
+    (void) buffer;
+}
+
+struct t_gui_buffer *slack_buffer_search(const char *domain, const char *type,
+                                         const char *name)
+{
+    (void) domain;
+    (void) type;
+    (void) name;
+
+    return NULL;
+}
+
+int slack_buffer_nickcmp_cb(const void *pointer, void *data,
+                            struct t_gui_buffer *buffer,
+                            const char *nick1,
+                            const char *nick2)
+{
+    (void) pointer;
+    (void) data;
+    (void) buffer;
+
+    return strcmp(nick1, nick2);
+}
+
+int slack_buffer_close_cb(const void *pointer, void *data,
+                          struct t_gui_buffer *buffer)
+{
+    (void) pointer;
+    (void) data;
+    (void) buffer;
+
+    return WEECHAT_RC_OK;
+}
+
+int slack_input_data_cb(const void *pointer, void *data,
+                        struct t_gui_buffer *buffer,
+                        const char *input_data)
+{
+    (void) pointer;
+    (void) data;
+    (void) buffer;
+    (void) input_data;
+
+    return WEECHAT_RC_OK;
+}
+
+struct t_slack_user *slack_user_search(struct t_slack_workspace *workspace,
+                                       const char *id)
+{
+    (void) workspace;
+    (void) id;
+
+    return NULL;
+}
+
+struct t_slack_user *slack_user_search_index(struct t_slack_workspace *workspace,
+                                             uint32_t index)
+{
+    (void) workspace;
+    (void) index;
+
+    return NULL;
+}
+
+int slack_user_sort_key_cmp(struct t_slack_user *user1,
+                            struct t_slack_user *user2)
+{
+    return strcmp(user1->profile.display_name, user2->profile.display_name);
+}
+
+void slack_user_nicklist_populate(struct t_slack_workspace *workspace,
+                                  struct t_slack_channel *channel)
+{
+    (void) workspace;
+    (void) channel;
+}
+
+void slack_user_nicklist_add(struct t_slack_workspace *workspace,
+                             struct t_slack_channel *channel,
+                             struct t_slack_user *user)
+{
+    (void) workspace;
+    (void) channel;
+    (void) user;
+}
+
+static struct t_slack_user *test_channel_users;
+static char (*test_channel_names)[16];
+
+static void test_channel_users_new()
+{
+    int i;
+
+    test_channel_users = calloc(TEST_CHANNEL_TYPERS, sizeof(*test_channel_users));
+    test_channel_names = calloc(TEST_CHANNEL_TYPERS, sizeof(*test_channel_names));
+    for (i = 0; i < TEST_CHANNEL_TYPERS; i++)
+    {
+        test_channel_users[i].id = i + 1;
+        snprintf(test_channel_names[i], sizeof(test_channel_names[i]),
+                 "user%d", i);
+        test_channel_users[i].profile.display_name = test_channel_names[i];
+    }
+}
+
+/* ages every typer, as if the timeout had passed since its last refresh */
+static void test_channel_typing_expire(struct t_slack_channel *channel)
+{
+    struct t_slack_channel_typing *ptr_typing;
+
+    for (ptr_typing = channel->typings; ptr_typing;
+         ptr_typing = ptr_typing->next_typing)
+        ptr_typing->ts -= SLACK_CHANNEL_TYPING_TIMEOUT + 1;
+}
+
+static void test_channel_typing_names(struct t_slack_workspace *workspace,
+                                      struct t_slack_channel *channel)
+{
+    TEST_CHECK_STRING(slack_channel_typing_notification(channel), "");
+
+    slack_channel_add_typing(workspace, channel, &test_channel_users[0]);
+    TEST_CHECK_STRING(slack_channel_typing_notification(channel),
+                      "user0 is typing...");
+
+    slack_channel_add_typing(workspace, channel, &test_channel_users[1]);
+    TEST_CHECK_STRING(slack_channel_typing_notification(channel),
+                      "user0, user1 are typing...");
+
+    slack_channel_add_typing(workspace, channel, &test_channel_users[2]);
+    TEST_CHECK_STRING(slack_channel_typing_notification(channel),
+                      "Several people are typing...");
+
+    slack_channel_typing_remove(workspace, channel, channel->typings);
+    TEST_CHECK_STRING(slack_channel_typing_notification(channel),
+                      "user1, user2 are typing...");
+
+    slack_channel_typing_free_all(workspace, channel);
+    TEST_CHECK_STRING(slack_channel_typing_notification(channel), "");
+    TEST_CHECK(workspace->typing_heap_count == 0);
+}
+
+static void test_channel_typing_long_names(struct t_slack_workspace *workspace,
+                                           struct t_slack_channel *channel)
+{
+    struct t_slack_user users[2];
+    char name[2][SLACK_CHANNEL_TYPING_NOTIFICATION_MAX_LEN * 2];
+    const char *notification;
+    int i;
+
+    memset(users, 0, sizeof(users));
+    for (i = 0; i < 2; i++)
+    {
+        memset(name[i], 'a' + i, sizeof(name[i]) - 1);
+        name[i][sizeof(name[i]) - 1] = '\0';
+        users[i].id = TEST_CHANNEL_TYPERS + 1 + i;
+        users[i].profile.display_name = name[i];
+        slack_channel_add_typing(workspace, channel, &users[i]);
+    }
+
+    notification = slack_channel_typing_notification(channel);
+    TEST_CHECK(strlen(notification) == SLACK_CHANNEL_TYPING_NOTIFICATION_MAX_LEN);
+    TEST_CHECK(strncmp(notification, name[0], strlen(notification)) == 0);
+
+    slack_channel_typing_free_all(workspace, channel);
+}
+
+static void test_channel_typing_many(struct t_slack_workspace *workspace,
+                                     struct t_slack_channel *channel)
+{
+    const char *notification;
+    int i, timers, updates;
+
+    workspace->typing_timer = NULL;
+    timers = stubs_timers;
+    for (i = 0; i < TEST_CHANNEL_TYPERS; i++)
+        slack_channel_add_typing(workspace, channel, &test_channel_users[i]);
+
+    /* one timer for the earliest expiration, however many typers */
+    TEST_CHECK(stubs_timers == timers + 1);
+    TEST_CHECK(workspace->typing_heap_count == TEST_CHANNEL_TYPERS);
+
+    notification = slack_channel_typing_notification(channel);
+    TEST_CHECK_STRING(notification, "Several people are typing...");
+
+    /* refreshes move entries in the heap, the text is left as is */
+    updates = stubs_bar_item_updates;
+    for (i = 0; i < TEST_CHANNEL_TYPERS; i += 7)
+        slack_channel_add_typing(workspace, channel, &test_channel_users[i]);
+    TEST_CHECK(workspace->typing_heap_count == TEST_CHANNEL_TYPERS);
+    TEST_CHECK(stubs_bar_item_updates == updates);
+    TEST_CHECK(slack_channel_typing_notification(channel) == notification);
+
+    /* all expire on the next timer call, with a single bar item update */
+    test_channel_typing_expire(channel);
+    updates = stubs_bar_item_updates;
+    workspace->typing_timer = NULL;
+    slack_channel_typing_cb(workspace, NULL, 0);
+    TEST_CHECK(channel->typings == NULL);
+    TEST_CHECK(workspace->typing_heap_count == 0);
+    TEST_CHECK(stubs_bar_item_updates == updates + 1);
+    TEST_CHECK_STRING(slack_channel_typing_notification(channel), "");
+}
+
+static void test_channel_typing_expire_some(struct t_slack_workspace *workspace,
+                                            struct t_slack_channel *channel)
+{
+    struct t_slack_channel_typing *ptr_typing;
+    int i, count;
+
+    for (i = 0; i < 10; i++)
+        slack_channel_add_typing(workspace, channel, &test_channel_users[i]);
+    test_channel_typing_expire(channel);
+    for (i = 0; i < 10; i += 3)
+        slack_channel_add_typing(workspace, channel, &test_channel_users[i]);
+
+    workspace->typing_timer = NULL;
+    slack_channel_typing_cb(workspace, NULL, 0);
+
+    count = 0;
+    for (ptr_typing = channel->typings; ptr_typing;
+         ptr_typing = ptr_typing->next_typing)
+    {
+        TEST_CHECK((ptr_typing->id - 1) % 3 == 0);
+        count++;
+    }
+    TEST_CHECK(count == 4);
+    TEST_CHECK(workspace->typing_heap_count == 4);
+    /* re-armed for the typers left */
+    TEST_CHECK(workspace->typing_timer != NULL);
+
+    slack_channel_typing_free_all(workspace, channel);
+}
+
+int main()
+{
+    struct t_slack_workspace workspace;
+    struct t_slack_channel channel;
+
+    memset(&workspace, 0, sizeof(workspace));
+    memset(&channel, 0, sizeof(channel));
+    channel.workspace = &workspace;
+
+    test_channel_users_new();
+
+    test_channel_typing_names(&workspace, &channel);
+    test_channel_typing_long_names(&workspace, &channel);
+    test_channel_typing_many(&workspace, &channel);
+    test_channel_typing_expire_some(&workspace, &channel);
+
+    free(channel.typing_notification);
+    free(workspace.typing_heap);
+    free(test_channel_users);
+    free(test_channel_names);
+
+    return test_report("test-channel");
+}
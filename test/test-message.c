@@ -0,0 +1,196 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, version 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+/*
+ * Built once per markup scan path (see SCAN_VARIANTS in the Makefile), with
+ * the source included to reach its static functions.
+ */
+#include "../slack-message.c"
+#include "stubs.h"
+#include "test.h"
+
+#if defined(__AVX2__)
+#define TEST_MESSAGE_SCAN_PATH "avx2"
+#elif defined(__SSE2__)
+#define TEST_MESSAGE_SCAN_PATH "sse2"
+#else
+#define TEST_MESSAGE_SCAN_PATH "scalar"
+#endif
+
+#define TEST_MESSAGE_SCAN_MAX 160
+
+/* bytes that the scan stops on */
+static const char test_message_specials[] = "<&*_~`:";
+
+static unsigned int test_message_seed = 1;
+
+static unsigned int test_message_random()
+{
+    test_message_seed = test_message_seed * 1103515245 + 12345;
+
+    return test_message_seed >> 16;
+}
+
+static int test_message_is_special(char c)
+{
+    return c && strchr(test_message_specials, c);
+}
+
+static char test_message_random_special()
+{
+    return test_message_specials[
+        test_message_random() % (sizeof(test_message_specials) - 1)];
+}
+
+/* the byte-at-a-time scan that every path must agree with */
+static size_t test_message_scan_bytes(const char *text, size_t length)
+{
+    size_t i;
+
+    for (i = 0; i < length; i++)
+    {
+        if (test_message_is_special(text[i]))
+            return i;
+    }
+
+    return length;
+}
+
+/* random bytes, any value but the special ones */
+static void test_message_fill(char *text, size_t length)
+{
+    size_t i;
+    char c;
+
+    for (i = 0; i < length; i++)
+    {
+        do
+            c = test_message_random() & 0xFF;
+        while (!c || test_message_is_special(c));
+        text[i] = c;
+    }
+}
+
+static void test_message_scan()
+{
+    char buffer[32 + TEST_MESSAGE_SCAN_MAX + 32], *text;
+    size_t align, length, position, expected;
+    int c;
+
+    for (align = 0; align < 32; align++)
+    {
+        text = buffer + align;
+        for (length = 0; length <= TEST_MESSAGE_SCAN_MAX; length++)
+        {
+            test_message_fill(text, length);
+            TEST_CHECK(slack_message_scan(text, length) == length);
+
+            /* one special byte at each position, trailing bytes unread */
+            for (position = 0; position < length; position++)
+            {
+                test_message_fill(text, length + 32);
+                text[position] = test_message_random_special();
+                if (test_message_random() % 4 == 0)
+                    text[position + 1 + test_message_random() % 32] =
+                        test_message_random_special();
+                TEST_CHECK(slack_message_scan(text, length) == position);
+            }
+        }
+    }
+
+    /* every byte value at every offset of a block, including bytes >= 0x80 */
+    for (c = 1; c < 256; c++)
+    {
+        for (position = 0; position < 64; position++)
+        {
+            test_message_fill(buffer, 64);
+            buffer[position] = c;
+            expected = test_message_scan_bytes(buffer, 64);
+            TEST_CHECK(slack_message_scan(buffer, 64) == expected);
+        }
+    }
+}
+
+/* text, and its rendering with the markers of test/stubs.c */
+static const char *test_message_renderings[][2] =
+{
+    { "*bold*", "{b}bold{/b}" },
+    { "_italic_", "{i}italic{/i}" },
+    { "~strike~", "{delim}~{/color}strike{delim}~{/color}" },
+    { "`code`", "{value}code{/color}" },
+    { "```a *b* :smile:```", "{value}a *b* :smile:{/color}" },
+    { "*x* and *y*", "{b}x{/b} and {b}y{/b}" },
+    { "*a _b_ c*", "{b}a {i}b{/i} c{/b}" },
+    { "a*b*c snake_case_name", "a*b*c snake_case_name" },
+    { "*unclosed", "*unclosed" },
+    { "*a\nb*", "*a\nb*" },
+    { "<@U0ALICE> hi", "{nick}@alice{/color} hi" },
+    { "<@U0BOB>", "{nick}User:U0BOB{/color}" },
+    { "<#C0GENERAL|gen>", "{nick}#gen{/color}" },
+    { "<!here>", "{nick}@here{/color}" },
+    { "<https://example.com|link>", "{nick}https://example.com|link{/color}" },
+    { "_a <@U0ALICE>_", "{i}a {nick}@alice{/color}{/i}" },
+    { "a < b", "a < b" },
+    { "&lt;b&gt; &amp;", "<b> &" },
+    { "x :+1: :nope:", "x \xf0\x9f\x91\x8d :nope:" },
+    { "*bold:smile:*", "{b}bold\xf0\x9f\x98\x84{/b}" },
+    { "12:30 :tada::smile:", "12:30 \xf0\x9f\x8e\x89\xf0\x9f\x98\x84" },
+    /* a shortcode must not swallow the closing marker of a span */
+    { "_hi :x_: there", "{i}hi :x{/i}: there" },
+    { "_hi_ :x_:", "{i}hi{/i} [x_]" },
+};
+
+/* with slack.look.render_mrkdwn off: markers as sent, the rest rendered */
+static const char *test_message_renderings_plain[][2] =
+{
+    { "*bold* _italic_", "*bold* _italic_" },
+    { "`<@U0ALICE>` :smile:", "`{nick}@alice{/color}` \xf0\x9f\x98\x84" },
+    { "~a &amp; b~", "~a & b~" },
+};
+
+static void test_message_decode()
+{
+    struct t_slack_workspace workspace;
+    char *decoded;
+    size_t i;
+
+    memset(&workspace, 0, sizeof(workspace));
+
+    TEST_CHECK(slack_message_decode(&workspace, "no markup here") == NULL);
+
+    for (i = 0; i < sizeof(test_message_renderings) / sizeof(test_message_renderings[0]); i++)
+    {
+        decoded = slack_message_decode(&workspace, test_message_renderings[i][0]);
+        TEST_CHECK_STRING(decoded, test_message_renderings[i][1]);
+        free(decoded);
+    }
+
+    stubs_render_mrkdwn = 0;
+    for (i = 0; i < sizeof(test_message_renderings_plain) / sizeof(test_message_renderings_plain[0]); i++)
+    {
+        decoded = slack_message_decode(&workspace,
+                                       test_message_renderings_plain[i][0]);
+        TEST_CHECK_STRING(decoded, test_message_renderings_plain[i][1]);
+        free(decoded);
+    }
+    stubs_render_mrkdwn = 1;
+}
+
+int main()
+{
+#if defined(__AVX2__)
+    __builtin_cpu_init();
+    if (!__builtin_cpu_supports("avx2"))
+    {
+        printf("test-message (" TEST_MESSAGE_SCAN_PATH "): "
+               "skipped, no AVX2 on this CPU\n");
+        return 0;
+    }
+#endif
+
+    test_message_scan();
+    test_message_decode();
+
+    return test_report("test-message (" TEST_MESSAGE_SCAN_PATH ")");
+}
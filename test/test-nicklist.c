@@ -0,0 +1,201 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, version 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <libwebsockets.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../weechat-plugin.h"
+#include "../slack.h"
+#include "../slack-id.h"
+#include "../slack-workspace.h"
+#include "../slack-channel.h"
+#include "../slack-user.h"
+#include "../slack-buffer.h"
+#include "../slack-input.h"
+#include "stubs.h"
+#include "test.h"
+
+#define TEST_NICKLIST_MAX 16
+
+/*
+ * Input and the workspace are linked in by slack-buffer.c but not reached
+ * when adding nicks.
+ */
+
+int slack_input_data_cb(const void *pointer, void *data,
+                        struct t_gui_buffer *buffer,
+                        const char *input_data)
+{
+    (void) pointer;
+    (void) data;
+    (void) buffer;
+    (void) input_data;
+
+    return WEECHAT_RC_OK;
+}
+
+void slack_workspace_disconnect(struct t_slack_workspace *workspace,
+                                int reconnect)
+{
+    (void) workspace;
+    (void) reconnect;
+}
+
+struct t_hashtable *slack_workspace_name_hashtable_new(int size)
+{
+    (void) size;
+
+    return NULL;
+}
+
+/*
+ * A nicklist of one group, kept as weechat does through the nickcmp
+ * callback of the buffer: a nick equal to one in place is refused (the nick
+ * in place is compared first), others go before the first greater nick (the
+ * new nick is compared first).
+ */
+
+static const char *test_nicklist_nicks[TEST_NICKLIST_MAX];
+static int test_nicklist_count = 0;
+
+static struct t_gui_nick *test_nicklist_add_nick(struct t_gui_buffer *buffer,
+                                                 struct t_gui_nick_group *group,
+                                                 const char *name,
+                                                 const char *color,
+                                                 const char *prefix,
+                                                 const char *prefix_color,
+                                                 int visible)
+{
+    int i, pos;
+
+    (void) group;
+    (void) color;
+    (void) prefix;
+    (void) prefix_color;
+    (void) visible;
+
+    for (i = 0; i < test_nicklist_count; i++)
+    {
+        if (slack_buffer_nickcmp_cb(NULL, NULL, buffer,
+                                    test_nicklist_nicks[i], name) == 0)
+            return NULL;
+    }
+
+    if (test_nicklist_count == TEST_NICKLIST_MAX)
+        return NULL;
+
+    for (pos = 0; pos < test_nicklist_count; pos++)
+    {
+        if (slack_buffer_nickcmp_cb(NULL, NULL, buffer,
+                                    name, test_nicklist_nicks[pos]) < 0)
+            break;
+    }
+    memmove(&test_nicklist_nicks[pos + 1], &test_nicklist_nicks[pos],
+            (test_nicklist_count - pos) * sizeof(test_nicklist_nicks[0]));
+    test_nicklist_nicks[pos] = name;
+    test_nicklist_count++;
+
+    return (struct t_gui_nick *)&test_nicklist_nicks[pos];
+}
+
+/* display names with their sort keys, folded by hand */
+static const char *test_nicklist_names[][2] =
+{
+    { "carol", "carol" },
+    { "Alice", "alice" },
+    { "\xc3\x89mile", "\xc3\xa9mile" },
+    { "bob", "bob" },
+    { "Dave", "dave" },
+    { "alice2", "alice2" },
+};
+
+#define TEST_NICKLIST_USERS \
+    (int)(sizeof(test_nicklist_names) / sizeof(test_nicklist_names[0]))
+
+static void test_nicklist_cmp(struct t_slack_user *users)
+{
+    struct t_slack_user *alice;
+
+    alice = &users[1];
+    slack_user_nicklist_inserted = alice;
+
+    /* the inserted nick on either side, matched by pointer */
+    TEST_CHECK(slack_buffer_nickcmp_cb(NULL, NULL, NULL,
+                                       alice->profile.display_name, "bob") < 0);
+    TEST_CHECK(slack_buffer_nickcmp_cb(NULL, NULL, NULL,
+                                       "bob", alice->profile.display_name) > 0);
+    TEST_CHECK(slack_buffer_nickcmp_cb(NULL, NULL, NULL,
+                                       alice->profile.display_name,
+                                       "ALICE") == 0);
+    TEST_CHECK(slack_buffer_nickcmp_cb(NULL, NULL, NULL,
+                                       "ALICE",
+                                       alice->profile.display_name) == 0);
+    TEST_CHECK(slack_buffer_nickcmp_cb(NULL, NULL, NULL,
+                                       "alice2",
+                                       alice->profile.display_name) > 0);
+
+    /* other nicks, even with the same text, are compared as they are */
+    TEST_CHECK(slack_buffer_nickcmp_cb(NULL, NULL, NULL, "bob", "carol") < 0);
+    TEST_CHECK(slack_buffer_nickcmp_cb(NULL, NULL, NULL, "carol", "bob") > 0);
+    TEST_CHECK(slack_buffer_nickcmp_cb(NULL, NULL, NULL, "Alice", "bob") < 0);
+
+    slack_user_nicklist_inserted = NULL;
+    TEST_CHECK(slack_buffer_nickcmp_cb(NULL, NULL, NULL, "Bob", "bob") == 0);
+}
+
+static void test_nicklist_add(struct t_slack_workspace *workspace,
+                              struct t_slack_user *users)
+{
+    static const char *expected[] =
+    {
+        "Alice", "alice2", "bob", "carol", "Dave", "\xc3\x89mile",
+    };
+    int i;
+
+    for (i = 0; i < TEST_NICKLIST_USERS; i++)
+        slack_user_nicklist_add(workspace, NULL, &users[i]);
+    TEST_CHECK(slack_user_nicklist_inserted == NULL);
+
+    /* every user is in the nicklist, in order */
+    TEST_CHECK(test_nicklist_count == TEST_NICKLIST_USERS);
+    for (i = 0; i < test_nicklist_count; i++)
+        TEST_CHECK_STRING(test_nicklist_nicks[i], expected[i]);
+
+    /* adding a user again, or a nick differing by case, is refused */
+    slack_user_nicklist_add(workspace, NULL, &users[3]);
+    TEST_CHECK(test_nicklist_count == TEST_NICKLIST_USERS);
+    TEST_CHECK(test_nicklist_add_nick(workspace->buffer, NULL, "BOB",
+                                      NULL, NULL, NULL, 1) == NULL);
+    TEST_CHECK(test_nicklist_count == TEST_NICKLIST_USERS);
+}
+
+int main()
+{
+    struct t_slack_workspace workspace;
+    struct t_slack_user users[TEST_NICKLIST_USERS];
+    int i;
+
+    weechat_slack_plugin->nicklist_add_nick = &test_nicklist_add_nick;
+
+    memset(&workspace, 0, sizeof(workspace));
+    memset(users, 0, sizeof(users));
+    /* never dereferenced: only looked for by the nicklist */
+    workspace.buffer = (struct t_gui_buffer *)&workspace;
+    workspace.nicklist_loaded = 1;
+
+    for (i = 0; i < TEST_NICKLIST_USERS; i++)
+    {
+        users[i].id = i + 1;
+        users[i].profile.display_name = test_nicklist_names[i][0];
+        users[i].sort_key = (char *)test_nicklist_names[i][1];
+        users[i].sort_key_length = strlen(test_nicklist_names[i][1]);
+    }
+
+    test_nicklist_cmp(users);
+    test_nicklist_add(&workspace, users);
+
+    return test_report("test-nicklist");
+}
@@ -0,0 +1,49 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, version 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef _SLACK_TEST_H_
+#define _SLACK_TEST_H_
+
+#include <stdio.h>
+#include <string.h>
+
+static int test_checks = 0;
+static int test_failures = 0;
+
+#define TEST_CHECK(__condition)                                         \
+    do                                                                  \
+    {                                                                   \
+        test_checks++;                                                  \
+        if (!(__condition))                                             \
+        {                                                               \
+            test_failures++;                                            \
+            fprintf(stderr, "%s:%d: check failed: %s\n",                \
+                    __FILE__, __LINE__, #__condition);                  \
+        }                                                               \
+    } while (0)
+
+#define TEST_CHECK_STRING(__string, __expected)                         \
+    do                                                                  \
+    {                                                                   \
+        const char *__ptr_string = (__string);                          \
+        test_checks++;                                                  \
+        if (!__ptr_string || strcmp(__ptr_string, __expected) != 0)     \
+        {                                                               \
+            test_failures++;                                            \
+            fprintf(stderr, "%s:%d: got \"%s\", expected \"%s\"\n",     \
+                    __FILE__, __LINE__,                                 \
+                    (__ptr_string) ? __ptr_string : "(null)",           \
+                    __expected);                                        \
+        }                                                               \
+    } while (0)
+
+/* prints a summary line and returns the exit status of the test */
+static inline int test_report(const char *name)
+{
+    printf("%s: %d checks, %d failed\n", name, test_checks, test_failures);
+
+    return (test_failures) ? 1 : 0;
+}
+
+#endif /*SLACK_TEST_H*/